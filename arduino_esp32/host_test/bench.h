@@ -0,0 +1,22 @@
+// 微基准计时：重复运行直到超过最短时间，报告每次调用的微秒数
+#pragma once
+#include <chrono>
+#include <stdio.h>
+
+template <typename F>
+static double benchUs(F &&f, double min_ms = 200.0) {
+  using clock = std::chrono::steady_clock;
+  long n = 0;
+  const auto t0 = clock::now();
+  double elapsed_ms = 0;
+  do {
+    for (int i = 0; i < 16; ++i, ++n)
+      f(n);
+    elapsed_ms = std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+  } while (elapsed_ms < min_ms);
+  return elapsed_ms * 1000.0 / n;
+}
+
+static inline void benchRow(const char *name, double us) {
+  printf("  %-34s %10.2f us\n", name, us);
+}
@@ -0,0 +1,49 @@
+// fillRect() / drawFastHLine() / drawFastVLine() / fillScreen() 和同样区域逐像素 drawPixel() 的对比
+// 先确认两条路径画出来的画面一致（含负坐标裁剪和奇数宽度），再计时
+#include <Arduino.h>
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "bench.h"
+#include "panel_image.h"
+
+static void pixelRect(MatrixPanel_I2S_DMA &d, int x, int y, int w, int h, uint16_t c) {
+  for (int j = y; j < y + h; ++j)
+    for (int i = x; i < x + w; ++i)
+      d.drawPixel(i, j, c);
+}
+
+int main() {
+  HUB75_I2S_CFG cfg(64, 64, 1);
+  MatrixPanel_I2S_DMA fill(cfg), pixel(cfg);
+  if (!fill.begin() || !pixel.begin())
+    return 1;
+  const int W = panelWidth(fill), H = panelHeight(fill);
+
+  // 随机矩形和线段，包括越界和负坐标
+  HostRandom rnd(9);
+  for (int i = 0; i < 2000; ++i) {
+    const int x = rnd.range(-8, W), y = rnd.range(-8, H);
+    const int w = rnd.range(1, W / 2), h = rnd.range(1, H / 2);
+    const uint16_t c = rnd.next();
+    switch (i % 3) {
+      case 0: fill.fillRect(x, y, w, h, c);      pixelRect(pixel, x, y, w, h, c); break;
+      case 1: fill.drawFastHLine(x, y, w, c);    pixelRect(pixel, x, y, w, 1, c); break;
+      case 2: fill.drawFastVLine(x, y, h, c);    pixelRect(pixel, x, y, 1, h, c); break;
+    }
+  }
+  const bool same = capturePanel(fill) == capturePanel(pixel);
+  printf("%dx%d, identical after 2000 random fills %s\n", W, H, same ? "yes" : "NO");
+
+  printf("fill primitive vs the same area drawn with drawPixel\n");
+  benchRow("fillScreen", benchUs([&](long i) { fill.fillScreen(i * 77); }));
+  benchRow("  per pixel", benchUs([&](long i) { pixelRect(pixel, 0, 0, W, H, i * 77); }));
+  benchRow("fillRect 20x20", benchUs([&](long i) { fill.fillRect(i % 40, (i * 7) % 40, 20, 20, i * 77); }));
+  benchRow("  per pixel", benchUs([&](long i) { pixelRect(pixel, i % 40, (i * 7) % 40, 20, 20, i * 77); }));
+  benchRow("drawFastHLine 40", benchUs([&](long i) { fill.drawFastHLine(i % 20, i % 64, 40, i * 77); }));
+  benchRow("  per pixel", benchUs([&](long i) { pixelRect(pixel, i % 20, i % 64, 40, 1, i * 77); }));
+  benchRow("drawFastVLine 64", benchUs([&](long i) { fill.drawFastVLine(i % 64, 0, 64, i * 77); }));
+  benchRow("  per pixel", benchUs([&](long i) { pixelRect(pixel, i % 64, 0, 1, 64, i * 77); }));
+
+  return same ? 0 : 1;
+}
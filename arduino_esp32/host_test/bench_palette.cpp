@@ -0,0 +1,61 @@
+// GIF 调色板：逐像素颜色顺序转换 + drawSpanRGB565() 和每帧转换一次调色板 + drawSpanIndexed() 的对比
+// 64x64 随机8位索引帧，有/无影子帧缓冲各测一次，先确认两条路径画面一致
+#include <Arduino.h>
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "bench.h"
+#include "panel_image.h"
+
+// GIFManager.cpp 中默认 RBG 颜色顺序的转换
+static inline uint16_t mapColorOrder(uint16_t color) {
+  uint8_t r = (color >> 8) & 0xF8, g = (color >> 3) & 0xFC, b = (color << 3) & 0xF8;
+  return ((r & 0xF8) << 8) | ((b & 0xFC) << 3) | (g >> 3);
+}
+
+int main() {
+  int failures = 0;
+  HostRandom rnd(19);
+  uint16_t palette[256];
+  for (auto &p : palette) p = rnd.next();
+  uint8_t frame[64 * 64];
+  for (auto &v : frame) v = rnd.next();
+
+  for (bool shadow : {false, true}) {
+    HUB75_I2S_CFG cfg(64, 64, 1);
+    MatrixPanel_I2S_DMA before(cfg), after(cfg);
+    if (!before.begin() || !after.begin())
+      return 1;
+    if (shadow && !(before.setShadowBuffer(true) && after.setShadowBuffer(true)))
+      return 1;
+
+    uint16_t line[64], palette565[256];
+    uint32_t planeBits[256];
+    auto drawBefore = [&](long) {
+      for (int y = 0; y < 64; ++y) {
+        for (int x = 0; x < 64; ++x) line[x] = mapColorOrder(palette[frame[y * 64 + x]]);
+        before.drawSpanRGB565(0, y, line, 64);
+      }
+      if (shadow) before.commit();
+    };
+    auto drawAfter = [&](long) {
+      for (int i = 0; i < 256; ++i) palette565[i] = mapColorOrder(palette[i]);
+      if (!shadow) after.paletteToPlaneBits(palette565, planeBits, 256);
+      for (int y = 0; y < 64; ++y)
+        after.drawSpanIndexed(0, y, frame + y * 64, 64, palette565, planeBits);
+      if (shadow) after.commit();
+    };
+
+    drawBefore(0);
+    drawAfter(0);
+    const bool same = capturePanel(before) == capturePanel(after);
+    failures += !same;
+
+    const double us_before = benchUs(drawBefore), us_after = benchUs(drawAfter);
+    printf("64x64 indexed frame, shadow buffer %s, identical %s\n", shadow ? "on" : "off", same ? "yes" : "NO");
+    benchRow("per-pixel swizzle + drawSpanRGB565", us_before);
+    benchRow("palette once + drawSpanIndexed", us_after);
+    printf("  speed-up                           %10.2fx\n", us_before / us_after);
+  }
+  return failures;
+}
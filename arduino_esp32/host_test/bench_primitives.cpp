@@ -0,0 +1,66 @@
+// 驱动绘制原语的微基准，在工作站上比较驱动改动前后的性能
+// 数字只用于相对比较，绝对值和ESP32上不同
+#include <Arduino.h>
+#include <vector>
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "bench.h"
+#include "panel_image.h"
+
+// 子类只为了能直接调用受保护的缓冲区初始化
+struct BenchPanel : MatrixPanel_I2S_DMA {
+  using MatrixPanel_I2S_DMA::MatrixPanel_I2S_DMA;
+  using MatrixPanel_I2S_DMA::clearFrameBuffer;
+  using MatrixPanel_I2S_DMA::resetbuffers;
+};
+
+static void benchLayout(int panel_w, int panel_h, int chain) {
+  HUB75_I2S_CFG cfg(panel_w, panel_h, chain);
+  BenchPanel d(cfg);
+  if (!d.begin()) {
+    printf("begin() failed for %dx%d x%d\n", panel_w, panel_h, chain);
+    return;
+  }
+  const int W = panelWidth(d), H = panelHeight(d);
+  printf("%dx%d (%d bit colour):\n", W, H, d.getColorDepth());
+
+  HostRandom rnd(7);
+  std::vector<uint16_t> frame(W * H);
+  for (auto &p : frame) p = rnd.next();
+
+  benchRow("drawPixel, full frame", benchUs([&](long n) {
+    for (int y = 0; y < H; ++y)
+      for (int x = 0; x < W; ++x)
+        d.drawPixel(x, y, frame[y * W + x] + n);
+  }));
+  benchRow("drawSpanRGB565, full frame", benchUs([&](long) {
+    for (int y = 0; y < H; ++y)
+      d.drawSpanRGB565(0, y, &frame[y * W], W);
+  }));
+  benchRow("drawRectRGB565, full frame", benchUs([&](long) { d.drawRectRGB565(0, 0, W, H, frame.data()); }));
+  benchRow("fillScreen", benchUs([&](long n) { d.fillScreen(n * 77); }));
+  benchRow("clearScreen", benchUs([&](long) { d.clearScreen(); }));
+  benchRow("fillRect 20x20", benchUs([&](long n) { d.fillRect(n % 40, (n * 7) % 40, 20, 20, n * 77); }));
+  benchRow("fillRect full", benchUs([&](long n) { d.fillRect(0, 0, W, H, n * 77); }));
+  benchRow("drawFastHLine 40", benchUs([&](long n) { d.drawFastHLine(n % 20, n % H, 40, n * 77); }));
+  benchRow("drawFastVLine 40", benchUs([&](long n) { d.drawFastVLine(n % W, n % (H - 40), 40, n * 77); }));
+  benchRow("setBrightness8 step (OE adjust)", benchUs([&](long n) { d.setBrightness8((n & 1) ? 200 : 190); }));
+  benchRow("clearFrameBuffer", benchUs([&](long) { d.clearFrameBuffer(0); }));
+  benchRow("resetbuffers (clear + OE)", benchUs([&](long) { d.resetbuffers(); }));
+
+  std::vector<uint8_t> rgb(W * H * 3);
+  benchRow("readDMAFrame", benchUs([&](long) { d.readDMAFrame(rgb.data()); }));
+
+  d.setShadowBuffer(true);
+  benchRow("shadow drawRectRGB565 + commit", benchUs([&](long) {
+    d.drawRectRGB565(0, 0, W, H, frame.data());
+    d.commit();
+  }));
+}
+
+int main() {
+  benchLayout(64, 64, 1);
+  benchLayout(64, 64, 2);
+  return 0;
+}
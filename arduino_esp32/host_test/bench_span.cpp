@@ -0,0 +1,52 @@
+// drawSpanRGB565() / drawRectRGB565() 和逐像素 drawPixel() 的对比
+// 先确认两条路径解码出来的画面完全一致，再计时一整帧
+#include <Arduino.h>
+#include <vector>
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "bench.h"
+#include "panel_image.h"
+
+int main() {
+  int failures = 0;
+
+  for (int chain : {1, 2}) {
+    HUB75_I2S_CFG cfg(64, 64, chain);
+    MatrixPanel_I2S_DMA perPixel(cfg), span(cfg);
+    if (!perPixel.begin() || !span.begin())
+      return 1;
+    const int W = panelWidth(span), H = panelHeight(span);
+
+    HostRandom rnd(W);
+    std::vector<uint16_t> frame(W * H);
+    for (auto &p : frame) p = rnd.next();
+
+    for (int y = 0; y < H; ++y)
+      for (int x = 0; x < W; ++x)
+        perPixel.drawPixel(x, y, frame[y * W + x]);
+    span.drawRectRGB565(0, 0, W, H, frame.data());
+
+    const bool same = capturePanel(perPixel) == capturePanel(span);
+    failures += !same;
+
+    const double us_pixel = benchUs([&](long) {
+      for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x)
+          perPixel.drawPixel(x, y, frame[y * W + x]);
+    });
+    const double us_span = benchUs([&](long) {
+      for (int y = 0; y < H; ++y)
+        span.drawSpanRGB565(0, y, &frame[y * W], W);
+    });
+    const double us_rect = benchUs([&](long) { span.drawRectRGB565(0, 0, W, H, frame.data()); });
+
+    printf("%dx%d frame, identical %s\n", W, H, same ? "yes" : "NO");
+    benchRow("drawPixel per pixel", us_pixel);
+    benchRow("drawSpanRGB565 per row", us_span);
+    benchRow("drawRectRGB565", us_rect);
+    printf("  speed-up span vs per pixel        %10.2fx\n", us_pixel / us_span);
+  }
+
+  return failures;
+}
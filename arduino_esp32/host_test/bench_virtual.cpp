@@ -0,0 +1,40 @@
+// VirtualMatrixPanel：逐像素 getCoords() 和预先计算的坐标映射表对比，4块 64x64 面板
+#include <Arduino.h>
+#include <vector>
+#include "ESP32-VirtualMatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "bench.h"
+
+static void benchChain(int rows, int cols) {
+  HUB75_I2S_CFG cfg(64, 64, rows * cols);
+  MatrixPanel_I2S_DMA dma(cfg);
+  if (!dma.begin())
+    return;
+  VirtualMatrixPanel v(dma, rows, cols, 64, 64, true, false);
+  const int W = v.virtualResX, H = v.virtualResY;
+
+  HostRandom rnd(W);
+  std::vector<uint16_t> line(W);
+  for (auto &p : line) p = rnd.next();
+
+  printf("%dx%d virtual (%dx%d panels)\n", W, H, cols, rows);
+  for (int pass = 0; pass < 2; ++pass) {
+    if (pass) v.buildCoordMap();
+    printf(" %s\n", v.hasCoordMap() ? "coordinate map" : "getCoords() per pixel");
+    benchRow("drawPixel full frame", benchUs([&](long n) {
+      for (int y = 0; y < H; ++y)
+        for (int x = 0; x < W; ++x) v.drawPixel(x, y, (uint16_t)(x * y + n));
+    }));
+    benchRow("fillRect almost full", benchUs([&](long n) { v.fillRect(3, 5, W - 7, H - 9, (uint16_t)(n * 77)); }));
+    benchRow("drawSpanRGB565 every row", benchUs([&](long) {
+      for (int y = 0; y < H; ++y) v.drawSpanRGB565(0, y, line.data(), W);
+    }));
+  }
+}
+
+int main() {
+  benchChain(2, 2);
+  benchChain(1, 4);
+  return 0;
+}
@@ -0,0 +1,102 @@
+// 应用层模块（GIFReader 等）所需的 ESP 对象和 LittleFS 的主机实现
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_system.h>
+#include <sys/stat.h>
+
+HostESP ESP;
+HostFS LittleFS;
+
+uint32_t HostESP::getCycleCount() {
+  return (uint32_t)micros() * 240;
+}
+
+int File::seeks = 0;
+int File::reads = 0;
+
+size_t File::size() {
+  if (!f) return 0;
+  long pos = ftell(f.get());
+  fseek(f.get(), 0, SEEK_END);
+  long size = ftell(f.get());
+  fseek(f.get(), pos, SEEK_SET);
+  return size;
+}
+
+bool File::seek(size_t pos) {
+  ++seeks;
+  return f && fseek(f.get(), (long)pos, SEEK_SET) == 0;
+}
+
+size_t File::read(uint8_t *buf, size_t len) {
+  ++reads;
+  return f ? fread(buf, 1, len, f.get()) : 0;
+}
+
+String File::readStringUntil(char terminator) {
+  std::string line;
+  int c;
+  while (f && (c = fgetc(f.get())) != EOF && c != terminator)
+    line += (char)c;
+  return String(line);
+}
+
+File File::openNextFile() {
+  struct dirent *e;
+  while (d && (e = readdir(d.get())) != nullptr) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+      continue;
+    const std::string child = vpath + "/" + e->d_name;
+    if (e->d_type == DT_DIR)
+      return File(opendir((hostPath + "/" + e->d_name).c_str()), hostPath + "/" + e->d_name, child);
+    return File(fopen((hostPath + "/" + e->d_name).c_str(), "rb"), child);
+  }
+  return File();
+}
+
+File HostFS::open(const char *path, const char *mode) {
+  const std::string host = root + path;
+  struct stat st;
+  if (mode[0] == 'r' && stat(host.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+    return File(opendir(host.c_str()), host, path);
+  const char *m = mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb";
+  FILE *f = fopen(host.c_str(), m);
+  return f ? File(f, path) : File();
+}
+
+bool HostFS::exists(const char *path) {
+  return (bool)open(path);
+}
+
+bool HostFS::remove(const char *path) {
+  return ::remove((root + path).c_str()) == 0;
+}
+
+bool HostFS::rename(const char *from, const char *to) {
+  return ::rename((root + from).c_str(), (root + to).c_str()) == 0;
+}
+
+bool HostFS::mkdir(const char *path) {
+  return ::mkdir((root + path).c_str(), 0755) == 0;
+}
+
+static size_t dirBytes(const std::string &dir) {
+  size_t total = 0;
+  DIR *d = opendir(dir.c_str());
+  struct dirent *e;
+  while (d && (e = readdir(d)) != nullptr) {
+    if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0)
+      continue;
+    const std::string child = dir + "/" + e->d_name;
+    struct stat st;
+    if (stat(child.c_str(), &st) == 0)
+      total += S_ISDIR(st.st_mode) ? dirBytes(child) : st.st_size;
+  }
+  if (d)
+    closedir(d);
+  return total;
+}
+
+size_t HostFS::usedBytes() {
+  return dirBytes(root);
+}
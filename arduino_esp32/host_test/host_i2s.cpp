@@ -0,0 +1,69 @@
+// 驱动所需的 Arduino 计时函数和 esp32_i2s_parallel_dma.h 接口的主机实现
+#include <Arduino.h>
+#include <chrono>
+#include "esp32_i2s_parallel_dma.h"
+#include "host_i2s.h"
+
+HostSerial Serial;
+int hostHeapFailCaps = 0;
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+unsigned long millis() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+unsigned long micros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void delay(unsigned long) {}
+void yield() {}
+
+static callback shiftComplete = nullptr;
+static uint32_t frameCount    = 0;
+static int      shownBuffer   = 0;
+
+void hostVsync() {
+  ++frameCount;
+  if (shiftComplete)
+    shiftComplete();
+}
+
+bool hostVsyncHooked() { return shiftComplete != nullptr; }
+
+int hostShownBuffer() { return shownBuffer; }
+
+extern "C" {
+
+void link_dma_desc(volatile lldesc_t *dmadesc, volatile lldesc_t *prevdmadesc, void *memory, size_t size) {
+  if (size > DMA_MAX)
+    size = DMA_MAX;
+  dmadesc->size   = size;
+  dmadesc->length = size;
+  dmadesc->buf    = memory;
+  dmadesc->eof    = 0;
+  dmadesc->qe.stqe_next = nullptr;
+  if (prevdmadesc)
+    prevdmadesc->qe.stqe_next = (lldesc_t *)dmadesc;
+}
+
+esp_err_t i2s_parallel_driver_install(i2s_port_t, i2s_parallel_config_t *) { return ESP_OK; }
+esp_err_t i2s_parallel_send_dma(i2s_port_t, lldesc_t *) { return ESP_OK; }
+esp_err_t i2s_parallel_stop_dma(i2s_port_t) { return ESP_OK; }
+esp_err_t i2s_parallel_set_clock(i2s_port_t, int, i2s_parallel_cfg_bits_t) { return ESP_OK; }
+void i2s_parallel_set_dma_chains(lldesc_t *, int, lldesc_t *, int) {}
+void i2s_parallel_flip_to_buffer(i2s_port_t, int buffer_id) { shownBuffer = buffer_id; }
+bool i2s_parallel_is_previous_buffer_free() { return true; }
+void i2s_parallel_set_previous_buffer_not_free() {}
+void setShiftCompleteCallback(callback f) { shiftComplete = f; }
+
+// 等待的时候DMA正好发完一帧
+bool i2s_parallel_wait_for_frame(TickType_t) {
+  hostVsync();
+  return true;
+}
+
+uint32_t i2s_parallel_get_frame_count() { return frameCount; }
+
+}
@@ -0,0 +1,13 @@
+// 主机构建的I2S并行DMA替身
+// 没有真正的DMA输出，帧缓冲只是普通堆内存；一次 hostVsync() 相当于DMA把整条链发送完一遍
+#pragma once
+#include <stdint.h>
+
+// 模拟一次DMA EOF中断：帧计数加一并调用驱动挂上的回调（当前帧、渐变、抖动……）
+void hostVsync();
+
+// EOF中断是否处于开启状态（有回调挂着）
+bool hostVsyncHooked();
+
+// i2s_parallel_flip_to_buffer() 最后一次切换到的缓冲区
+int hostShownBuffer();
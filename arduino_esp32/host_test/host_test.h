@@ -0,0 +1,27 @@
+// 主机测试用的最小断言工具：失败时打印位置，main 返回失败个数
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+static int hostTestFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { ++hostTestFailures; printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); } \
+  } while (0)
+
+#define CHECK_MSG(cond, ...) do { \
+    if (!(cond)) { ++hostTestFailures; printf("%s:%d: CHECK failed: %s - ", __FILE__, __LINE__, #cond); printf(__VA_ARGS__); printf("\n"); } \
+  } while (0)
+
+static inline int hostTestResult(const char *name) {
+  printf("%s: %s (%d failures)\n", name, hostTestFailures ? "FAILED" : "passed", hostTestFailures);
+  return hostTestFailures ? 1 : 0;
+}
+
+// 固定种子的伪随机数，各平台结果一致，黄金图像才可复现
+struct HostRandom {
+  uint32_t state;
+  explicit HostRandom(uint32_t seed) : state(seed ? seed : 1) {}
+  uint32_t next() { state ^= state << 13; state ^= state >> 17; state ^= state << 5; return state; }
+  int range(int lo, int hi) { return lo + (int)(next() % (uint32_t)(hi - lo)); }   // [lo, hi)
+};
@@ -0,0 +1,48 @@
+#include "panel_image.h"
+#include <stdio.h>
+
+PanelImage capturePanel(MatrixPanel_I2S_DMA &display, uint8_t buff_id) {
+  PanelImage img(panelWidth(display), panelHeight(display));
+  display.readDMAFrame(img.rgb.data(), buff_id);
+  return img;
+}
+
+bool writePPM(const std::string &path, const PanelImage &img) {
+  FILE *f = fopen(path.c_str(), "wb");
+  if (!f)
+    return false;
+  fprintf(f, "P6\n%d %d\n255\n", img.width, img.height);
+  const bool ok = fwrite(img.rgb.data(), 1, img.rgb.size(), f) == img.rgb.size();
+  fclose(f);
+  return ok;
+}
+
+bool readPPM(const std::string &path, PanelImage &img) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  int w = 0, h = 0, maxval = 0;
+  bool ok = fscanf(f, "P6 %d %d %d", &w, &h, &maxval) == 3 && maxval == 255 && fgetc(f) != EOF;
+  if (ok) {
+    img = PanelImage(w, h);
+    ok = fread(img.rgb.data(), 1, img.rgb.size(), f) == img.rgb.size();
+  }
+  fclose(f);
+  return ok;
+}
+
+int diffPixels(const PanelImage &a, const PanelImage &b, int *first_x, int *first_y) {
+  if (a.width != b.width || a.height != b.height)
+    return -1;
+  int count = 0;
+  for (int y = 0; y < a.height; ++y)
+    for (int x = 0; x < a.width; ++x) {
+      const size_t i = ((size_t)y * a.width + x) * 3;
+      if (a.rgb[i] != b.rgb[i] || a.rgb[i + 1] != b.rgb[i + 1] || a.rgb[i + 2] != b.rgb[i + 2]) {
+        if (!count && first_x) *first_x = x;
+        if (!count && first_y) *first_y = y;
+        ++count;
+      }
+    }
+  return count;
+}
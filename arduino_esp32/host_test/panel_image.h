@@ -0,0 +1,31 @@
+// 把DMA位平面解码回RGB图像，用于和黄金图像（PPM）逐像素比较
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+
+struct PanelImage {
+  int width  = 0;
+  int height = 0;
+  std::vector<uint8_t> rgb;   // 行优先，每像素3字节
+
+  PanelImage() = default;
+  PanelImage(int w, int h) : width(w), height(h), rgb((size_t)w * h * 3, 0) {}
+
+  uint8_t *at(int x, int y) { return &rgb[((size_t)y * width + x) * 3]; }
+  bool operator==(const PanelImage &o) const { return width == o.width && height == o.height && rgb == o.rgb; }
+};
+
+// NO_GFX 构建没有 width()/height()，从配置算
+inline int panelWidth(const MatrixPanel_I2S_DMA &d)  { return d.getCfg().mx_width * d.getCfg().chain_length; }
+inline int panelHeight(const MatrixPanel_I2S_DMA &d) { return d.getCfg().mx_height; }
+
+// 解码一个DMA缓冲区（面板实际输出的各通道亮度，已经过gamma和当前色深）
+PanelImage capturePanel(MatrixPanel_I2S_DMA &display, uint8_t buff_id = 0);
+
+bool writePPM(const std::string &path, const PanelImage &img);
+bool readPPM(const std::string &path, PanelImage &img);
+
+// 不同像素的个数，尺寸不同时返回 -1；first 为第一个不同像素的位置
+int diffPixels(const PanelImage &a, const PanelImage &b, int *first_x = nullptr, int *first_y = nullptr);
@@ -0,0 +1,70 @@
+// AnimatedGIF 替身：GIFReader 的文件回调类型，以及按测试给出的画布逐行回调 GIFDraw 的假解码器
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+typedef struct {
+  void *fHandle;
+  int32_t iPos;
+  int32_t iSize;
+  uint8_t *pData;
+} GIFFILE;
+
+typedef struct {
+  int iX, iY, y, iWidth, iHeight;
+  uint8_t *pPixels;
+  uint16_t *pPalette;
+  uint8_t ucTransparent, ucHasTransparency, ucDisposalMethod, ucBackground;
+} GIFDRAW;
+
+typedef void *(GIF_OPEN_CALLBACK)(const char *, int32_t *);
+typedef void (GIF_CLOSE_CALLBACK)(void *);
+typedef int32_t (GIF_READ_CALLBACK)(GIFFILE *, uint8_t *, int32_t);
+typedef int32_t (GIF_SEEK_CALLBACK)(GIFFILE *, int32_t);
+typedef void (GIF_DRAW_CALLBACK)(GIFDRAW *);
+
+class AnimatedGIF {
+public:
+  // 一帧：画布上的子矩形和其中的像素索引，transparent < 0 为没有透明色
+  struct Frame {
+    int x, y, w, h;
+    std::vector<uint8_t> pixels;
+    int transparent;
+    int delayMs;
+  };
+  int canvasW = 64, canvasH = 64;
+  uint16_t palette[256] = {};
+  std::vector<Frame> frames;
+  int failAt = -1;                // 在这一帧解码出错（返回-1），-1为不出错
+
+  int open(uint8_t *, int, GIF_DRAW_CALLBACK *draw) { drawCallback = draw; next = 0; return 1; }
+  int open(const char *, GIF_OPEN_CALLBACK *, GIF_CLOSE_CALLBACK *, GIF_READ_CALLBACK *, GIF_SEEK_CALLBACK *, GIF_DRAW_CALLBACK *draw) {
+    return open(nullptr, 0, draw);
+  }
+  void close() { drawCallback = nullptr; }
+  void reset() { next = 0; }
+  int getCanvasWidth() { return canvasW; }
+  int getCanvasHeight() { return canvasH; }
+
+  // 和真实解码器一样：画出一帧，返回之后是否还有帧
+  int playFrame(bool, int *delayMs) {
+    if (drawCallback == nullptr || next >= (int)frames.size())
+      return 0;
+    if (next == failAt)
+      return -1;
+    Frame &f = frames[next++];
+    std::vector<uint8_t> line(f.w);
+    for (int y = 0; y < f.h; ++y) {
+      line.assign(f.pixels.begin() + y * f.w, f.pixels.begin() + (y + 1) * f.w);
+      GIFDRAW d = {f.x, f.y, y, f.w, f.h, line.data(), palette,
+                   (uint8_t)(f.transparent < 0 ? 0 : f.transparent), (uint8_t)(f.transparent >= 0), 0, 0};
+      drawCallback(&d);
+    }
+    if (delayMs) *delayMs = f.delayMs;
+    return next < (int)frames.size();
+  }
+
+private:
+  GIF_DRAW_CALLBACK *drawCallback = nullptr;
+  int next = 0;
+};
@@ -0,0 +1,91 @@
+// 主机构建用的 Arduino 最小替身，只提供驱动用到的部分
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "Esp.h"
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define PSTR(x) x
+#define F(x) x
+
+typedef bool boolean;
+
+struct HostSerial {
+  template<typename... A> void printf(const char* f, A... a) { ::printf(f, a...); }
+  template<typename... A> void printf_P(const char* f, A... a) { ::printf(f, a...); }
+  void println(const char* s = "") { ::puts(s); }
+  void print(const char* s) { ::fputs(s, stdout); }
+  void flush() {}
+};
+extern HostSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+using std::min;
+using std::max;
+
+#define OUTPUT 1
+#define INPUT  0
+#define LOW    0
+#define HIGH   1
+static inline void pinMode(int, int) {}
+static inline void digitalWrite(int, int) {}
+static inline void delayMicroseconds(unsigned) {}
+
+// 应用层日志拼接用到的 String 子集
+#define HEX 16
+class String {
+public:
+  String(const char *c = "") : s(c) {}
+  String(const std::string &c) : s(c) {}
+  String(char c) : s(1, c) {}
+  String(int v, int base = 10) { set((long)v, base); }
+  String(unsigned v, int base = 10) { set((long)v, base); }
+  String(long v, int base = 10) { set(v, base); }
+  String(unsigned long v, int base = 10) { set((long)v, base); }
+  String operator+(const String &o) const { return String(s + o.s); }
+  String &operator+=(const String &o) { s += o.s; return *this; }
+  bool operator==(const String &o) const { return s == o.s; }
+  bool operator==(const char *o) const { return s == o; }
+  const char *c_str() const { return s.c_str(); }
+  size_t length() const { return s.size(); }
+
+private:
+  std::string s;
+  void set(long v, int base) {
+    char t[24];
+    snprintf(t, sizeof(t), base == HEX ? "%lx" : "%ld", v);
+    s = t;
+  }
+};
+static inline String operator+(const char *a, const String &b) { return String(a) + b; }
+
+#define PROGMEM
+#define pgm_read_byte(a)    (*(const uint8_t *)(a))
+#define pgm_read_word(a)    (*(const uint16_t *)(a))
+#define pgm_read_dword(a)   (*(const uint32_t *)(a))
+#define constrain(v, lo, hi) ((v) < (lo) ? (lo) : ((v) > (hi) ? (hi) : (v)))
+class __FlashStringHelper;
+
+static inline size_t strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size) {
+    size_t n = len < size - 1 ? len : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = 0;
+  }
+  return len;
+}
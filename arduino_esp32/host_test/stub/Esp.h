@@ -0,0 +1,12 @@
+// Arduino 的 ESP 对象和 CPU 频率，应用层日志和 Profiler 用到
+#pragma once
+#include <stdint.h>
+
+struct HostESP {
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getMinFreeHeap() { return 100000; }
+  uint32_t getCycleCount();
+};
+extern HostESP ESP;
+
+static inline uint32_t getCpuFrequencyMhz() { return 240; }
@@ -0,0 +1,49 @@
+// LittleFS 替身：路径映射到主机目录 LittleFS.root 下的普通文件和目录
+#pragma once
+#include <Arduino.h>
+#include <dirent.h>
+#include <memory>
+
+class File {
+public:
+  File() {}
+  File(FILE *f, const std::string &path) : f(f, fclose), vpath(path) {}
+  File(DIR *d, const std::string &hostPath, const std::string &path) : d(d, closedir), hostPath(hostPath), vpath(path) {}
+  explicit operator bool() const { return f != nullptr || d != nullptr; }
+  size_t size();
+  size_t position() { return f ? ftell(f.get()) : 0; }
+  bool seek(size_t pos);
+  size_t read(uint8_t *buf, size_t len);
+  size_t write(const uint8_t *buf, size_t len) { return f ? fwrite(buf, 1, len, f.get()) : 0; }
+  int available() { return f ? (int)(size() - position()) : 0; }
+  String readStringUntil(char terminator);
+  template<typename... A> size_t printf(const char *fmt, A... a) { return f ? fprintf(f.get(), fmt, a...) : 0; }
+  void close() { f.reset(); d.reset(); }
+
+  // 目录：完整路径和下一个目录项
+  const char *path() const { return vpath.c_str(); }
+  bool isDirectory() const { return d != nullptr; }
+  File openNextFile();
+
+  // 主机测试统计：真正访问文件的次数
+  static int seeks, reads;
+
+private:
+  std::shared_ptr<FILE> f;
+  std::shared_ptr<DIR> d;
+  std::string hostPath, vpath;
+};
+
+class HostFS {
+public:
+  std::string root = ".";
+  size_t totalSize = 1536 * 1024;   // totalBytes() 报告的分区大小
+  File open(const char *path, const char *mode = "r");
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+  bool mkdir(const char *path);
+  size_t totalBytes() { return totalSize; }
+  size_t usedBytes();               // root 下所有文件的大小之和
+};
+extern HostFS LittleFS;
@@ -0,0 +1,19 @@
+// Adafruit_GFX 继承的 Print 子集
+#pragma once
+#include <Arduino.h>
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buf, size_t n) {
+    size_t k = 0;
+    while (n--) k += write(*buf++);
+    return k;
+  }
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t print(int v) { return print(String(v)); }
+  size_t println(const char *s = "") { return print(s) + write('\n'); }
+};
@@ -0,0 +1,29 @@
+// DMA/PSRAM 内存在主机上都是普通堆内存
+#pragma once
+#include <stdlib.h>
+#include <stddef.h>
+
+#define MALLOC_CAP_DMA      (1 << 0)
+#define MALLOC_CAP_SPIRAM   (1 << 1)
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DEFAULT  (1 << 3)
+#define MALLOC_CAP_INTERNAL (1 << 4)
+#define MALLOC_CAP_32BIT    (1 << 5)
+
+// 报告给驱动的可用内存，大致相当于 ESP32 启动后的内部 RAM
+#define HOST_HEAP_FREE          300000
+#define HOST_HEAP_LARGEST_BLOCK 110000
+
+// 主机测试可以让带这些能力位的分配失败，例如 MALLOC_CAP_SPIRAM 模拟没有PSRAM
+extern int hostHeapFailCaps;
+
+static inline void *heap_caps_malloc(size_t size, int caps) { return (caps & hostHeapFailCaps) ? nullptr : malloc(size); }
+static inline void *heap_caps_calloc(size_t n, size_t size, int) { return calloc(n, size); }
+static inline void *heap_caps_aligned_alloc(size_t align, size_t size, int caps) {
+  return (caps & hostHeapFailCaps) || size == 0 ? nullptr : aligned_alloc(align, (size + align - 1) / align * align);
+}
+static inline void heap_caps_free(void *p) { free(p); }
+static inline size_t heap_caps_get_free_size(int) { return HOST_HEAP_FREE; }
+static inline size_t heap_caps_get_largest_free_block(int) { return HOST_HEAP_LARGEST_BLOCK; }
+static inline size_t heap_caps_get_total_size(int) { return 0; }
+static inline void heap_caps_print_heap_info(int) {}
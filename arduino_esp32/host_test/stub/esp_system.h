@@ -0,0 +1,3 @@
+// 应用层只通过它间接包含 ESP 对象
+#pragma once
+#include <Esp.h>
@@ -0,0 +1,26 @@
+// 单线程主机构建：临界区为空操作，信号量总是立即成功
+#pragma once
+#include <stdint.h>
+
+typedef int      BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void    *TaskHandle_t;
+typedef void    *SemaphoreHandle_t;
+typedef void    *QueueHandle_t;
+
+typedef struct { int owner; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portENTER_CRITICAL(m)     (void)(m)
+#define portEXIT_CRITICAL(m)      (void)(m)
+#define portENTER_CRITICAL_ISR(m) (void)(m)
+#define portEXIT_CRITICAL_ISR(m)  (void)(m)
+#define portYIELD_FROM_ISR(x)     (void)(x)
+
+#define portMAX_DELAY       0xffffffffu
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(x)    (x)
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              1
+#define configASSERT(x)
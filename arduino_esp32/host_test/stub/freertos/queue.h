@@ -0,0 +1,8 @@
+#pragma once
+#include "FreeRTOS.h"
+
+// 主机上不运行解码任务，队列创建失败时 GIFManager 在主循环中解码
+static inline QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t) { return nullptr; }
+static inline BaseType_t xQueueSend(QueueHandle_t, const void *, TickType_t) { return pdFALSE; }
+static inline BaseType_t xQueueReceive(QueueHandle_t, void *, TickType_t) { return pdFALSE; }
+static inline BaseType_t xQueueReset(QueueHandle_t) { return pdPASS; }
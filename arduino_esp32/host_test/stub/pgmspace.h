@@ -0,0 +1,3 @@
+// ESP32 上 PROGMEM 数据就在普通地址空间
+#pragma once
+#include <Arduino.h>
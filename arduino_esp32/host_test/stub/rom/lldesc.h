@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+typedef struct lldesc_s {
+    volatile uint32_t size : 12, length : 12, offset : 5, sosf : 1, eof : 1, owner : 1;
+    volatile void *buf;
+    union { struct lldesc_s *stqe_next; } qe;
+} lldesc_t;
@@ -0,0 +1,138 @@
+// GIFLibrary 动画库：保存、重复上传、哈希相同但内容不同、按最近播放淘汰，以及重启后从清单恢复
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "GIFLibrary.h"
+#include "host_test.h"
+
+static std::vector<uint8_t> randomGIF(int32_t size, uint32_t seed) {
+  HostRandom rnd(seed);
+  std::vector<uint8_t> data(size);
+  for (auto &b : data) b = rnd.next();
+  return data;
+}
+
+static std::string assetFile(uint32_t id) {
+  char path[GIF_PATH_SIZE];
+  snprintf(path, sizeof(path), "%s/%08lx.gif", GIF_LIBRARY_DIR, (unsigned long)id);
+  return path;
+}
+
+static std::vector<uint8_t> readFile(const std::string &path) {
+  File file = LittleFS.open(path.c_str(), "r");
+  std::vector<uint8_t> data(file ? file.size() : 0);
+  if (file)
+    file.read(data.data(), data.size());
+  return data;
+}
+
+static void writeFile(const char *path, const std::vector<uint8_t> &data) {
+  File file = LittleFS.open(path, "w");
+  file.write(data.data(), data.size());
+  file.close();
+}
+
+static std::string manifest() {
+  char buf[GIF_LIBRARY_TEXT_SIZE];
+  GIFLibrary::format(buf, sizeof(buf));
+  return buf;
+}
+
+static bool listed(uint32_t id) {
+  char key[16];
+  snprintf(key, sizeof(key), "%08lx:", (unsigned long)id);
+  return manifest().find(key) != std::string::npos;
+}
+
+static bool add(const std::vector<uint8_t> &data, uint32_t hash, uint32_t *id) {
+  return GIFLibrary::addBuffer(data.data(), (int32_t)data.size(), hash, id);
+}
+
+int main() {
+  const std::string root = std::string(HOST_FS_DIR) + "/giflibrary_fs";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+  LittleFS.root = root;
+  LittleFS.totalSize = 4 * GIF_LIBRARY_BUDGET;
+  GIFLibrary::begin();
+  CHECK(manifest() == "USED:0," + std::to_string(GIF_LIBRARY_BUDGET) + ";");
+
+  // 保存：文件名是内容哈希，内容和上传的一致；保存本身不切换播放
+  const std::vector<uint8_t> a = randomGIF(100 * 1024, 1);
+  const uint32_t hashA = GIFLibrary::hash(a.data(), a.size());
+  uint32_t id = 0;
+  CHECK(add(a, hashA, &id));
+  CHECK(id == hashA);
+  CHECK(readFile(assetFile(hashA)) == a);
+  CHECK(listed(hashA));
+  char path[GIF_PATH_SIZE];
+  CHECK(!GIFLibrary::takeSelection(path, sizeof(path)));
+  CHECK(GIFLibrary::play(hashA));
+  CHECK(GIFLibrary::takeSelection(path, sizeof(path)) && assetFile(hashA) == path);
+  CHECK(GIFLibrary::isActive(hashA));
+
+  // 重复上传：内存和文件模式都只记为最近播放，文件模式的上传文件被删除
+  const std::string before = manifest();
+  id = 0;
+  CHECK(add(a, hashA, &id) && id == hashA);
+  writeFile("/upload.gif", a);
+  id = 0;
+  CHECK(GIFLibrary::addFile("/upload.gif", hashA, &id) && id == hashA);
+  CHECK(!LittleFS.exists("/upload.gif"));
+  CHECK(manifest() == before);
+
+  // 哈希相同但内容不同（大小相同、大小不同）：不保存，库中的动画不变
+  std::vector<uint8_t> collision = a;
+  collision[a.size() / 2] ^= 0x55;
+  CHECK(!add(collision, hashA, &id));
+  CHECK(!add(randomGIF(1000, 2), hashA, &id));
+  writeFile("/upload.gif", collision);
+  CHECK(!GIFLibrary::addFile("/upload.gif", hashA, &id));
+  LittleFS.remove("/upload.gif");
+  CHECK(readFile(assetFile(hashA)) == a);
+  CHECK(manifest() == before);
+
+  // 超出预算时淘汰最久没有播放的：a 和前三个刚好放下，播放过 a 之后再加第四个，淘汰最早加入的第一个
+  const int32_t big = 300 * 1024;
+  std::vector<std::vector<uint8_t>> others;
+  std::vector<uint32_t> ids;
+  for (uint32_t seed = 10; seed < 14; ++seed) {
+    others.push_back(randomGIF(big, seed));
+    ids.push_back(GIFLibrary::hash(others.back().data(), big));
+  }
+  for (int i = 0; i < 3; ++i)
+    CHECK(add(others[i], ids[i], &id));
+  CHECK(listed(hashA) && listed(ids[0]) && listed(ids[1]) && listed(ids[2]));
+  CHECK(GIFLibrary::play(hashA));
+  CHECK(add(others[3], ids[3], &id));
+  CHECK(!listed(ids[0]));
+  CHECK(!LittleFS.exists(assetFile(ids[0]).c_str()));
+  CHECK(listed(hashA) && listed(ids[1]) && listed(ids[2]) && listed(ids[3]));
+  CHECK(readFile(assetFile(ids[3])) == others[3]);
+  // 最近播放的在前
+  CHECK(manifest().find(assetFile(ids[3]).substr(strlen(GIF_LIBRARY_DIR) + 1, 8)) <
+        manifest().find(assetFile(hashA).substr(strlen(GIF_LIBRARY_DIR) + 1, 8)));
+
+  // 超出整个预算的动画不保存，也不淘汰别的动画
+  const std::string full = manifest();
+  const std::vector<uint8_t> huge = randomGIF(GIF_LIBRARY_BUDGET + 1, 20);
+  CHECK(!add(huge, GIFLibrary::hash(huge.data(), huge.size()), &id));
+  CHECK(manifest() == full);
+
+  // 重启：从清单恢复，清单外的文件被删除
+  writeFile((std::string(GIF_LIBRARY_DIR) + "/deadbeef.gif").c_str(), a);
+  GIFLibrary::begin();
+  CHECK(manifest() == full);
+  CHECK(!LittleFS.exists(GIF_LIBRARY_DIR "/deadbeef.gif"));
+
+  // 删除
+  CHECK(GIFLibrary::remove(ids[1]));
+  CHECK(!listed(ids[1]) && !LittleFS.exists(assetFile(ids[1]).c_str()));
+  CHECK(!GIFLibrary::remove(ids[1]));
+  CHECK(!GIFLibrary::play(ids[1]));
+
+  std::filesystem::remove_all(root);
+  return hostTestResult("giflibrary");
+}
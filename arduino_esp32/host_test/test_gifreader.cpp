@@ -0,0 +1,80 @@
+// GIFReader 预读缓冲：随机 read/seek 序列的结果必须和直接按位置读文件一致，
+// 覆盖文件比缓冲区小、没有PSRAM（4KB内部缓冲）、缓冲区分配失败（直接读文件）和读到最后一个字节
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <vector>
+#include "GIFReader.h"
+#include "host_test.h"
+
+static void runFile(int32_t size, int failCaps, uint32_t seed) {
+  HostRandom rnd(seed);
+  std::vector<uint8_t> data(size);
+  for (auto &b : data) b = rnd.next();
+  File out = LittleFS.open("/reader.bin", "w");
+  out.write(data.data(), data.size());
+  out.close();
+
+  hostHeapFailCaps = failCaps;
+  GIFFILE gf = {};
+  gf.fHandle = GIFReader::open("/reader.bin", &gf.iSize);
+  CHECK(gf.fHandle != nullptr);
+  CHECK(gf.iSize == size);
+  if (gf.fHandle == nullptr)
+    return;
+
+  std::vector<uint8_t> buf(size + 64);
+  int32_t pos = 0;
+  int mismatches = 0;
+  for (int i = 0; i < 5000; ++i) {
+    if (rnd.range(0, 8) == 0) {
+      // 解码器常见的回退：回到开头或前面不远的位置
+      int32_t target = rnd.range(0, 4) == 0 ? 0 : rnd.range(-600, 200) + pos;
+      pos = GIFReader::seek(&gf, target);
+      CHECK(pos == std::max(0, std::min(target, size)));
+    }
+    // 大多是几十字节的小块读，偶尔有比缓冲区还大的读
+    const int32_t len = rnd.range(0, 10) == 0 ? rnd.range(0, size + 32) : rnd.range(1, 256);
+    const int32_t n = GIFReader::read(&gf, buf.data(), len);
+    const int32_t expected = std::min(len, size - pos);
+    if (n != expected || memcmp(buf.data(), data.data() + pos, n) != 0)
+      ++mismatches;
+    pos += n;
+    CHECK(gf.iPos == pos);
+  }
+  CHECK_MSG(mismatches == 0, "size %d failCaps %d: %d mismatching reads", size, failCaps, mismatches);
+
+  // 最后一个字节也能读到
+  GIFReader::seek(&gf, size - 1);
+  CHECK(GIFReader::read(&gf, buf.data(), 16) == 1 && buf[0] == data[size - 1]);
+
+  GIFReader::close(gf.fHandle);
+  hostHeapFailCaps = 0;
+}
+
+int main() {
+  LittleFS.root = HOST_FS_DIR;
+  const int noPsram = MALLOC_CAP_SPIRAM;
+  const int noMemory = MALLOC_CAP_SPIRAM | MALLOC_CAP_INTERNAL;
+  for (int32_t size : {1, 100, 4096, 20000, 100000}) {
+    runFile(size, 0, size);
+    runFile(size, noPsram, size + 1);
+    runFile(size, noMemory, size + 2);
+  }
+
+  // 顺序小块读取：整块预读，文件访问次数远少于读取次数
+  const int32_t size = 100000;
+  GIFFILE gf = {};
+  gf.fHandle = GIFReader::open("/reader.bin", &gf.iSize);
+  File::reads = File::seeks = 0;
+  uint8_t chunk[64];
+  int calls = 0;
+  while (GIFReader::read(&gf, chunk, sizeof(chunk)) > 0)
+    ++calls;
+  CHECK(calls == (size + 63) / 64);
+  CHECK_MSG(File::reads <= size / GIF_READ_BUFFER_SIZE + 1, "%d file reads for %d calls", File::reads, calls);
+  GIFReader::close(gf.fHandle);
+  LittleFS.remove("/reader.bin");
+
+  return hostTestResult("gifreader");
+}
@@ -0,0 +1,136 @@
+// GIF缩放：随机画布经 GIFManager 在三种缩放模式下播放（整帧 + 带透明色的子矩形帧），
+// 面板画面和按模式定义独立算出的最近像素映射逐像素比较；适应模式不放大比面板小的GIF
+#include <Arduino.h>
+#include <AnimatedGIF.h>
+#include <vector>
+#include "GIFManager.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "panel_image.h"
+
+static const int PW = 64, PH = 64;
+
+// 面板上 [dstX, dstX+dstW) x [dstY, dstY+dstH) 显示画布 [srcX, srcX+srcW) x [srcY, srcY+srcH)
+struct Mapping {
+  int dstX, dstY, dstW, dstH, srcX, srcY, srcW, srcH;
+};
+
+static Mapping expectedMapping(int mode, int cw, int ch) {
+  Mapping m;
+  const bool fits = cw <= PW && ch <= PH;
+  if (mode == GIF_SCALE_CENTER || (mode == GIF_SCALE_FIT && fits)) {
+    m.dstW = m.srcW = std::min(cw, PW);
+    m.dstH = m.srcH = std::min(ch, PH);
+  } else if (mode == GIF_SCALE_FIT) {
+    // 整个画布缩小到面板内，保持宽高比
+    m.srcW = cw;
+    m.srcH = ch;
+    const double s = std::min((double)PW / cw, (double)PH / ch);
+    m.dstW = std::max(1, (int)(cw * s + 1e-9));
+    m.dstH = std::max(1, (int)(ch * s + 1e-9));
+  } else {
+    // 铺满面板，画布中间和面板宽高比相同的部分
+    m.dstW = PW;
+    m.dstH = PH;
+    const double s = std::max((double)PW / cw, (double)PH / ch);
+    m.srcW = std::max(1, std::min(cw, (int)(PW / s + 1e-9)));
+    m.srcH = std::max(1, std::min(ch, (int)(PH / s + 1e-9)));
+  }
+  m.dstX = (PW - m.dstW) / 2;
+  m.dstY = (PH - m.dstH) / 2;
+  m.srcX = (cw - m.srcW) / 2;
+  m.srcY = (ch - m.srcH) / 2;
+  return m;
+}
+
+// 目标像素中心对应的画布像素
+static int sample(int i, int dst, int src) {
+  return (int)((2L * i + 1) * src / (2L * dst));
+}
+
+static PanelImage playScaled(int mode, AnimatedGIF &gif) {
+  HUB75_I2S_CFG cfg(PW, PH, 1);
+  MatrixPanel_I2S_DMA display(cfg);
+  CHECK(display.begin());
+  GIFManager manager(&display, &gif);
+  manager.setLoopMode(false);
+  manager.setScaleMode(mode);
+  manager.setGIFMemory((uint8_t *)malloc(16), 16);
+  CHECK(manager.initGIFPlayer());
+  // 按真实时间播放到结束（每帧延迟1ms）
+  const unsigned long start = millis();
+  while (manager.playGIFFrame() && millis() - start < 2000) {}
+  CHECK(!manager.isPlaying());
+  return capturePanel(display);
+}
+
+int main() {
+  const int sizes[][2] = {{64, 64}, {128, 128}, {200, 100}, {100, 200}, {32, 32}, {40, 64},
+                          {64, 30}, {480, 270}, {17, 90}, {90, 17}, {65, 63}, {1, 1}};
+  HostRandom rnd(22);
+
+  for (const auto &sz : sizes) {
+    const int cw = sz[0], ch = sz[1];
+    AnimatedGIF gif;
+    gif.canvasW = cw;
+    gif.canvasH = ch;
+    for (auto &c : gif.palette) c = rnd.next();
+
+    // 第一帧铺满画布，第二帧是带透明色7的子矩形
+    AnimatedGIF::Frame full = {0, 0, cw, ch, std::vector<uint8_t>(cw * ch), -1, 1};
+    for (auto &p : full.pixels) p = rnd.next();
+    AnimatedGIF::Frame part = {cw / 3, ch / 4, std::max(1, cw / 2), std::max(1, ch / 2), {}, 7, 1};
+    part.pixels.resize(part.w * part.h);
+    std::vector<uint8_t> canvas = full.pixels;
+    for (int y = 0; y < part.h; ++y)
+      for (int x = 0; x < part.w; ++x) {
+        uint8_t v = rnd.range(0, 3) == 0 ? 7 : rnd.next();
+        part.pixels[y * part.w + x] = v;
+        if (v != 7)
+          canvas[(part.y + y) * cw + part.x + x] = v;
+      }
+    gif.frames = {full, part};
+
+    for (int mode : {GIF_SCALE_CENTER, GIF_SCALE_FIT, GIF_SCALE_FILL}) {
+      const PanelImage shown = playScaled(mode, gif);
+
+      // 参考画面：逐像素画出映射后的画布颜色，区域外保持黑色
+      const Mapping m = expectedMapping(mode, cw, ch);
+      HUB75_I2S_CFG cfg(PW, PH, 1);
+      MatrixPanel_I2S_DMA ref(cfg);
+      CHECK(ref.begin());
+      for (int y = 0; y < m.dstH; ++y)
+        for (int x = 0; x < m.dstW; ++x) {
+          const int sx = m.srcX + (m.srcW == m.dstW ? x : sample(x, m.dstW, m.srcW));
+          const int sy = m.srcY + (m.srcH == m.dstH ? y : sample(y, m.dstH, m.srcH));
+          ref.drawPixel(m.dstX + x, m.dstY + y, gif.palette[canvas[sy * cw + sx]]);
+        }
+      const int diff = diffPixels(shown, capturePanel(ref));
+      CHECK_MSG(diff == 0, "%dx%d mode %d: %d pixels differ (area %dx%d at %d,%d)",
+                cw, ch, mode, diff, m.dstW, m.dstH, m.dstX, m.dstY);
+    }
+
+    // 比面板小的GIF在适应模式下不放大，和居中完全相同
+    if (cw <= PW && ch <= PH)
+      CHECK_MSG(diffPixels(playScaled(GIF_SCALE_FIT, gif), playScaled(GIF_SCALE_CENTER, gif)) == 0,
+                "%dx%d upscaled in fit mode", cw, ch);
+  }
+  // 解码出错时结束播放，循环模式下也不会一直重试
+  {
+    AnimatedGIF gif;
+    gif.frames = {{0, 0, 64, 64, std::vector<uint8_t>(64 * 64), -1, 1}, {0, 0, 64, 64, std::vector<uint8_t>(64 * 64), -1, 1}};
+    gif.failAt = 1;
+    HUB75_I2S_CFG cfg(PW, PH, 1);
+    MatrixPanel_I2S_DMA display(cfg);
+    CHECK(display.begin());
+    GIFManager manager(&display, &gif);
+    manager.setLoopMode(true);
+    manager.setGIFMemory((uint8_t *)malloc(16), 16);
+    CHECK(manager.initGIFPlayer());
+    const unsigned long start = millis();
+    while (manager.playGIFFrame() && millis() - start < 2000) {}
+    CHECK(!manager.isPlaying());
+  }
+
+  return hostTestResult("gifscale");
+}
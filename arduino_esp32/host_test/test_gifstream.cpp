@@ -0,0 +1,121 @@
+// GIFStream 边接收边播放的帧扫描：真实GIF按不同分块大小到达时帧数一致、只数完整收到的帧，
+// 截断的文件只数到截断处，结尾块之后的数据不再当作帧
+#include <Arduino.h>
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "GIFReader.h"
+#include "host_test.h"
+
+// Android 应用自带的动画，帧数由逐块解析文件得出
+struct Asset {
+  const char *name;
+  int frames;
+};
+static const Asset assets[] = {{"b.gif", 20}, {"dddd2.gif", 120}, {"matrix_spin.gif", 131}, {"shock_gs.gif", 18}};
+
+static std::vector<uint8_t> loadAsset(const char *name) {
+  std::vector<uint8_t> data;
+  FILE *f = fopen((std::string(GIF_ASSETS_DIR "/") + name).c_str(), "rb");
+  CHECK_MSG(f != nullptr, "cannot open %s", name);
+  if (f == nullptr)
+    return data;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return data;
+}
+
+/**
+ * 像BLE接收一样把 file 的前 total 字节按 chunk 大小写进缓冲区，缓冲区里还没收到的部分是无关数据；
+ * 返回每次写入后的帧数，帧数不能减少
+ */
+static std::vector<int> receive(const std::vector<uint8_t> &file, int32_t total, int32_t chunk, std::vector<uint8_t> &buf) {
+  buf.assign(file.size(), 0x2C);
+  std::vector<int> counts;
+  GIFStream::begin(buf.data(), (int32_t)buf.size());
+  for (int32_t received = 0; received < total;) {
+    const int32_t n = std::min(chunk, total - received);
+    memcpy(buf.data() + received, file.data() + received, n);
+    received += n;
+    GIFStream::update(received);
+    counts.push_back(GIFStream::frameCount());
+    if (counts.size() > 1)
+      CHECK(counts.back() >= counts[counts.size() - 2]);
+  }
+  return counts;
+}
+
+int main() {
+  for (const Asset &a : assets) {
+    const std::vector<uint8_t> file = loadAsset(a.name);
+    if (file.empty())
+      continue;
+    const int32_t size = (int32_t)file.size();
+    CHECK(file.back() == 0x3B);
+    std::vector<uint8_t> buf;
+
+    // 逐字节到达时每一步的帧数作为参考，其他分块大小在同样的位置必须得到同样的帧数
+    const std::vector<int> byByte = receive(file, size, 1, buf);
+    CHECK_MSG(byByte.back() == a.frames, "%s: %d frames, expected %d", a.name, byByte.back(), a.frames);
+    CHECK(byByte[12] == 0);
+    for (int32_t chunk : {7, 20, 244, 4096, size}) {
+      const std::vector<int> counts = receive(file, size, chunk, buf);
+      int mismatches = 0;
+      for (size_t i = 0; i < counts.size(); ++i) {
+        const int32_t received = std::min((int32_t)(i + 1) * chunk, size);
+        if (counts[i] != byByte[received - 1])
+          ++mismatches;
+      }
+      CHECK_MSG(mismatches == 0, "%s chunk %d: %d mismatching frame counts", a.name, chunk, mismatches);
+    }
+
+    // 最后一帧的数据子块结束后才数到它：只差结尾块时所有帧都已完整，再少一个字节就少一帧
+    CHECK(byByte[size - 2] == a.frames);
+    CHECK(byByte[size - 3] == a.frames - 1);
+
+    // 截断在中间：只数到截断处，和逐字节到达时一致
+    for (int32_t cut : {size / 3, size / 2, size - 100}) {
+      const std::vector<int> counts = receive(file, cut, 512, buf);
+      CHECK_MSG(counts.back() == byByte[cut - 1] && counts.back() > 0 && counts.back() < a.frames,
+                "%s cut at %d: %d frames", a.name, cut, counts.back());
+    }
+
+    // 结尾块之后的数据（这里是像图像描述符的字节）不再当作帧
+    std::vector<uint8_t> padded = file;
+    padded.insert(padded.end(), 64, 0x2C);
+    CHECK(receive(padded, (int32_t)padded.size(), 244, buf).back() == a.frames);
+
+    // 播放器只能解码完整收到的帧，接收完成后所有帧都可以解码
+    receive(file, size / 2, 244, buf);
+    uint8_t *data = nullptr;
+    int32_t dataSize = 0;
+    CHECK(GIFStream::attach(&data, &dataSize));
+    CHECK(data == buf.data() && dataSize == size);
+    const int ready = GIFStream::frameCount();
+    CHECK(GIFStream::frameReady(ready - 1));
+    CHECK(!GIFStream::frameReady(ready));
+    CHECK(!GIFStream::aborted());
+    memcpy(buf.data() + size / 2, file.data() + size / 2, size - size / 2);
+    GIFStream::update(size);
+    GIFStream::finish();
+    CHECK(GIFStream::frameReady(a.frames - 1));
+    CHECK(GIFStream::reading(buf.data()));
+    GIFStream::detach();
+    CHECK(!GIFStream::reading(buf.data()));
+    CHECK(!GIFStream::release(buf.data()));
+  }
+
+  // 不是GIF的数据不会开始边接收边播放
+  std::vector<uint8_t> junk(1000, 0x2C), buf;
+  CHECK(receive(junk, (int32_t)junk.size(), 100, buf).back() == 0);
+  uint8_t *data = nullptr;
+  int32_t dataSize = 0;
+  CHECK(!GIFStream::attach(&data, &dataSize));
+  GIFStream::release(buf.data());
+
+  return hostTestResult("gifstream");
+}
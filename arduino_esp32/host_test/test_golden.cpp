@@ -0,0 +1,111 @@
+// 黄金图像测试：固定的绘制场景解码回RGB后必须和 golden/ 下的PPM逐像素一致
+// 驱动改动后如确认新输出正确，用 --update 重新生成黄金图像
+#include <Arduino.h>
+#include <string.h>
+#include <vector>
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "panel_image.h"
+
+static bool updateGolden = false;
+
+// 各种绘制路径都走一遍：整屏填充、矩形、横竖线、单像素、RGB565块和行
+static void drawScene(MatrixPanel_I2S_DMA &d, uint32_t seed) {
+  HostRandom rnd(seed);
+  const int W = panelWidth(d), H = panelHeight(d);
+
+  d.fillScreenRGB888(8, 16, 40);
+
+  for (int i = 0; i < 12; ++i)
+    d.fillRect(rnd.range(-8, W), rnd.range(-8, H), rnd.range(1, W / 2), rnd.range(1, H / 2), rnd.next() & 0xFF, rnd.next() & 0xFF, rnd.next() & 0xFF);
+
+  for (int i = 0; i < 16; ++i) {
+    d.drawFastHLine(rnd.range(-4, W), rnd.range(0, H), rnd.range(1, W), rnd.next() & 0xFF, rnd.next() & 0xFF, rnd.next() & 0xFF);
+    d.drawFastVLine(rnd.range(0, W), rnd.range(-4, H), rnd.range(1, H), rnd.next() & 0xFF, rnd.next() & 0xFF, rnd.next() & 0xFF);
+  }
+
+  // 渐变块，覆盖所有灰阶
+  std::vector<uint16_t> block(32 * 16);
+  for (int y = 0; y < 16; ++y)
+    for (int x = 0; x < 32; ++x)
+      block[y * 32 + x] = MatrixPanel_I2S_DMA::color565(x * 8, y * 16, 255 - x * 8);
+  d.drawRectRGB565(W - 35, H - 18, 32, 16, block.data());
+
+  // 奇数起点和长度的行
+  std::vector<uint16_t> span(W);
+  for (int i = 0; i < 6; ++i) {
+    for (auto &p : span) p = rnd.next();
+    d.drawSpanRGB565(rnd.range(-3, W / 2) | 1, rnd.range(0, H), span.data(), rnd.range(1, W) | 1);
+  }
+
+  for (int i = 0; i < 200; ++i)
+    d.drawPixelRGB888(rnd.range(0, W), rnd.range(0, H), rnd.next() & 0xFF, rnd.next() & 0xFF, rnd.next() & 0xFF);
+}
+
+static void checkGolden(const char *name, const PanelImage &img) {
+  const std::string path = std::string(GOLDEN_DIR) + "/" + name + ".ppm";
+
+  if (updateGolden) {
+    CHECK_MSG(writePPM(path, img), "can't write %s", path.c_str());
+    printf("updated %s\n", path.c_str());
+    return;
+  }
+
+  PanelImage golden;
+  if (!readPPM(path, golden)) {
+    CHECK_MSG(false, "can't read %s, run with --update to create it", path.c_str());
+    return;
+  }
+
+  int fx = -1, fy = -1;
+  const int diff = diffPixels(golden, img, &fx, &fy);
+  CHECK_MSG(diff == 0, "%s: %d pixels differ, first at %d,%d", name, diff, fx, fy);
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; ++i)
+    if (!strcmp(argv[i], "--update"))
+      updateGolden = true;
+
+  {
+    HUB75_I2S_CFG cfg(64, 32, 1);
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    drawScene(d, 1);
+    checkGolden("single_64x32", capturePanel(d));
+  }
+
+  {
+    HUB75_I2S_CFG cfg(64, 64, 1);
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    d.setColorDepth(5);
+    drawScene(d, 2);
+    checkGolden("depth5_64x64", capturePanel(d));
+  }
+
+  {
+    // 两块级联、双缓冲：画在后台缓冲，翻页后显示的那块要是这一帧
+    HUB75_I2S_CFG cfg(64, 64, 2);
+    cfg.double_buff = true;
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    drawScene(d, 3);
+    d.flipDMABuffer();
+    checkGolden("double_128x64", capturePanel(d, hostShownBuffer()));
+  }
+
+  {
+    // 影子缓冲：绘制只写RGB565，commit() 时才转换到DMA
+    HUB75_I2S_CFG cfg(64, 64, 1);
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    CHECK(d.setShadowBuffer(true));
+    drawScene(d, 4);
+    d.commit();
+    checkGolden("shadow_64x64", capturePanel(d));
+  }
+
+  return hostTestResult("test_golden");
+}
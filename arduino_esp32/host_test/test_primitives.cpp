@@ -0,0 +1,173 @@
+// 绘制原语和参考图像比较：每个操作同时画进一张普通RGB图，解码DMA缓冲后必须完全一致
+// 线性gamma下DMA里的各位平面就是原始的8位颜色，低色深时只剩高位
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "panel_image.h"
+
+struct Reference {
+  PanelImage img;
+  uint8_t mask;
+
+  Reference(int w, int h, uint8_t depth) : img(w, h), mask((uint8_t)(0xFF << (8 - depth))) {}
+
+  void pixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+    if (x < 0 || y < 0 || x >= img.width || y >= img.height)
+      return;
+    uint8_t *p = img.at(x, y);
+    p[0] = r & mask; p[1] = g & mask; p[2] = b & mask;
+  }
+  void pixel565(int x, int y, uint16_t c) {
+    uint8_t r, g, b;
+    MatrixPanel_I2S_DMA::color565to888(c, r, g, b);
+    pixel(x, y, r, g, b);
+  }
+  void rect(int x, int y, int w, int h, uint8_t r, uint8_t g, uint8_t b) {
+    for (int j = y; j < y + h; ++j)
+      for (int i = x; i < x + w; ++i)
+        pixel(i, j, r, g, b);
+  }
+};
+
+// 随机操作序列，覆盖裁剪、奇数起点/长度和上下半屏
+static void runOps(MatrixPanel_I2S_DMA &d, Reference &ref, uint32_t seed, int ops, bool nested = false) {
+  HostRandom rnd(seed);
+  const int W = panelWidth(d), H = panelHeight(d);
+  std::vector<uint16_t> px(W * 4);
+
+  for (int it = 0; it < ops; ++it) {
+    const int x = rnd.range(-10, W + 10), y = rnd.range(-10, H + 10);
+    const int w = rnd.range(0, W / 2 + 2), h = rnd.range(0, H / 2 + 2);
+    const uint8_t r = rnd.next(), g = rnd.next(), b = rnd.next();
+
+    switch (rnd.range(0, 7)) {
+      case 0: d.fillRect(x, y, w, h, r, g, b);        ref.rect(x, y, w, h, r, g, b); break;
+      case 1: d.drawFastHLine(x, y, w, r, g, b);      ref.rect(x, y, w, 1, r, g, b); break;
+      case 2: d.drawFastVLine(x, y, h, r, g, b);      ref.rect(x, y, 1, h, r, g, b); break;
+      case 3: d.drawPixelRGB888(x, y, r, g, b);       ref.pixel(x, y, r, g, b); break;
+      case 4: {
+        const uint16_t c = rnd.next();
+        d.drawPixel(x, y, c);
+        ref.pixel565(x, y, c);
+        break;
+      }
+      case 5: {
+        for (auto &p : px) p = rnd.next();
+        d.drawSpanRGB565(x, y, px.data(), w);
+        for (int i = 0; i < w; ++i) ref.pixel565(x + i, y, px[i]);
+        break;
+      }
+      default: {
+        const int bh = h % 4;
+        for (auto &p : px) p = rnd.next();
+        d.drawRectRGB565(x, y, w, bh, px.data());
+        for (int j = 0; j < bh; ++j)
+          for (int i = 0; i < w; ++i) ref.pixel565(x + i, y + j, px[j * w + i]);
+        break;
+      }
+    }
+  }
+
+  // 偶尔整屏操作
+  if ((seed & 1) && !nested) {
+    d.fillScreenRGB888(0x81, 0x42, 0x17);
+    ref.rect(0, 0, W, H, 0x81, 0x42, 0x17);
+    runOps(d, ref, seed + 1000, ops / 4, true);
+  }
+}
+
+int main() {
+  // resize: DMA缓冲区按色深重新分配，只存高位的几个位平面
+  struct Layout { int w, h, chain; bool double_buff; uint8_t depth; bool resize; } layouts[] = {
+    {64, 32, 1, false, 8}, {64, 64, 1, false, 8}, {64, 64, 2, false, 8},
+    {64, 64, 1, true, 8},  {64, 32, 2, true, 8},  {64, 64, 1, false, 5}, {64, 64, 1, true, 3},
+    {64, 64, 1, false, 4, true}, {64, 32, 2, true, 3, true},
+  };
+
+  uint32_t seed = 1;
+  for (const auto &l : layouts) {
+    HUB75_I2S_CFG cfg(l.w, l.h, l.chain);
+    cfg.double_buff = l.double_buff;
+    cfg.gamma = HUB75_I2S_CFG::GAMMA_LINEAR;
+
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    CHECK(d.setColorDepth(l.depth, l.resize) == l.depth);
+
+    Reference ref(panelWidth(d), panelHeight(d), d.getColorDepth());
+    runOps(d, ref, seed++, 3000);
+
+    int fx = -1, fy = -1;
+    const int diff = diffPixels(ref.img, capturePanel(d, d.getBackBufferId()), &fx, &fy);
+    CHECK_MSG(diff == 0, "%dx%d chain %d double %d depth %d: %d pixels differ, first at %d,%d",
+              l.w, l.h, l.chain, l.double_buff, l.depth, diff, fx, fy);
+  }
+
+  // 重新分配：降色深时DMA内存按位平面数变少，再升回8位照样能画
+  {
+    HUB75_I2S_CFG cfg(64, 64, 1);
+    cfg.double_buff = true;
+    cfg.gamma = HUB75_I2S_CFG::GAMMA_LINEAR;
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    const size_t full = d.getDMAArena().reserved();
+
+    CHECK(d.setColorDepth(3, true) == 3);
+    CHECK(d.getStoredColorDepth() == 3);
+    CHECK_MSG(d.getDMAArena().reserved() * 2 < full, "3 planes reserve %d of %d bytes", (int)d.getDMAArena().reserved(), (int)full);
+
+    // 不重新分配时不能超过已存的位平面
+    CHECK(d.setColorDepth(6) == 3);
+
+    CHECK(d.setColorDepth(8, true) == 8);
+    CHECK(d.getDMAArena().reserved() == full);
+
+    Reference ref(panelWidth(d), panelHeight(d), 8);
+    runOps(d, ref, 77, 2000);
+    CHECK(diffPixels(ref.img, capturePanel(d, d.getBackBufferId())) == 0);
+  }
+
+  // 亮度渐变由DMA中断逐帧推进，最后停在目标亮度；渐变结束后下一次提交关掉EOF中断
+  {
+    HUB75_I2S_CFG cfg(64, 32, 1);
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    d.setBrightness8(20);
+    d.fadeTo(200, 100);
+    CHECK(d.isFading());
+    CHECK(hostVsyncHooked());
+    int frames = 0;
+    while (d.isFading() && frames < 10000) {
+      hostVsync();
+      ++frames;
+    }
+    CHECK(!d.isFading());
+    CHECK(frames > 1);
+    CHECK(hostVsyncHooked());
+    d.presentIncremental();
+    CHECK(!hostVsyncHooked());
+  }
+
+  // 测刷新率的窗口内EOF中断一直开着，每一帧都计数；测完不再需要时关掉
+  {
+    HUB75_I2S_CFG cfg(64, 32, 1);
+    MatrixPanel_I2S_DMA d(cfg);
+    CHECK(d.begin());
+    CHECK(!hostVsyncHooked());
+    CHECK(d.getRefreshRate() == d.calculated_refresh_rate);
+    CHECK(hostVsyncHooked());
+    for (int i = 0; i < 100; ++i)
+      hostVsync();
+    CHECK(d.getRefreshRate() == d.calculated_refresh_rate);   // 窗口还没过完
+    std::this_thread::sleep_for(std::chrono::milliseconds(REFRESH_RATE_WINDOW_MS + 50));
+    const int rate = d.getRefreshRate();
+    CHECK(!hostVsyncHooked());
+    CHECK_MSG(rate > 0 && rate <= 100 * 1000 / REFRESH_RATE_WINDOW_MS, "measured %d Hz", rate);
+  }
+
+  return hostTestResult("test_primitives");
+}
@@ -0,0 +1,89 @@
+// VirtualMatrixPanel 坐标映射表：随机绘制操作经映射表画一份，逐像素 getCoords() 画一份，DMA 缓冲必须一致
+#include <Arduino.h>
+#include <vector>
+#include "ESP32-VirtualMatrixPanel-I2S-DMA.h"
+#include "host_i2s.h"
+#include "host_test.h"
+#include "panel_image.h"
+
+struct Layout {
+  int rows, cols;
+  bool serpentine, top_down;
+  PANEL_SCAN_RATE scan;
+  bool rotate;
+};
+
+static void runLayout(const Layout &l) {
+  const int PW = 64, PH = l.scan == ONE_EIGHT_16 ? 32 : 64;
+  HUB75_I2S_CFG cfg(PW, PH, l.rows * l.cols);
+  cfg.gamma = HUB75_I2S_CFG::GAMMA_LINEAR;
+  if (l.scan != NORMAL_ONE_SIXTEEN) {
+    // 1/8 扫描的面板在 DMA 看来是两倍宽、一半高
+    cfg.mx_width = PW * 2;
+    cfg.mx_height = PH / 2;
+  }
+  MatrixPanel_I2S_DMA dma_map(cfg), dma_ref(cfg);
+  CHECK(dma_map.begin() && dma_ref.begin());
+
+  VirtualMatrixPanel mapped(dma_map, l.rows, l.cols, PW, PH, l.serpentine, l.top_down);
+  VirtualMatrixPanel ref(dma_ref, l.rows, l.cols, PW, PH, l.serpentine, l.top_down);
+  mapped.setPhysicalPanelScanRate(l.scan);
+  ref.setPhysicalPanelScanRate(l.scan);
+  mapped.setRotate(l.rotate);
+  ref.setRotate(l.rotate);
+  CHECK(mapped.buildCoordMap());
+
+  const int W = mapped.virtualResX, H = mapped.virtualResY;
+  HostRandom rnd(W * H + l.serpentine + l.top_down * 2 + l.rotate * 4 + l.scan * 8);
+  std::vector<uint16_t> span(W);
+  for (int i = 0; i < 2000; ++i) {
+    const int x = rnd.range(-10, W + 10), y = rnd.range(-10, H + 10);
+    const int w = rnd.range(0, W), h = rnd.range(0, H);
+    const uint16_t c = rnd.next();
+    switch (i % 5) {
+      case 0:
+        mapped.fillRect(x, y, w, h, c);
+        for (int j = y; j < y + h; ++j)
+          for (int k = x; k < x + w; ++k) ref.drawPixel(k, j, c);
+        break;
+      case 1:
+        mapped.drawFastHLine(x, y, w, c);
+        for (int k = x; k < x + w; ++k) ref.drawPixel(k, y, c);
+        break;
+      case 2:
+        mapped.drawFastVLine(x, y, h, c);
+        for (int j = y; j < y + h; ++j) ref.drawPixel(x, j, c);
+        break;
+      case 3:
+        for (auto &p : span) p = rnd.next();
+        mapped.drawSpanRGB565(x, y, span.data(), w);
+        for (int k = 0; k < w; ++k) ref.drawPixel(x + k, y, span[k]);
+        break;
+      default:
+        mapped.drawPixel(x, y, c);
+        ref.drawPixel(x, y, c);
+        break;
+    }
+  }
+
+  CHECK_MSG(capturePanel(dma_map) == capturePanel(dma_ref),
+            "%dx%d serpentine %d top_down %d scan %d rotate %d", W, H, l.serpentine, l.top_down, (int)l.scan, l.rotate);
+}
+
+int main() {
+  const Layout layouts[] = {
+    {2, 2, true,  false, NORMAL_ONE_SIXTEEN, false},
+    {2, 2, true,  true,  NORMAL_ONE_SIXTEEN, false},
+    {2, 2, false, false, NORMAL_ONE_SIXTEEN, false},
+    {2, 2, false, true,  NORMAL_ONE_SIXTEEN, true},
+    {2, 2, true,  false, NORMAL_ONE_SIXTEEN, true},
+    {1, 4, true,  false, NORMAL_ONE_SIXTEEN, false},
+    {4, 1, true,  false, NORMAL_ONE_SIXTEEN, false},
+    {1, 1, true,  false, NORMAL_ONE_SIXTEEN, false},
+    {2, 2, true,  false, ONE_EIGHT_32,       false},
+    {1, 4, false, false, ONE_EIGHT_16,       false},
+  };
+  for (const auto &l : layouts)
+    runLayout(l);
+  return hostTestResult("virtual");
+}
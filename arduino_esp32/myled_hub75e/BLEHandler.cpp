@@ -8,7 +8,11 @@
 #include <string>
 #include "esp_task_wdt.h"
 #include "ClockManager.h"
+#include "DisplayManager.h"
 #include "esp_heap_caps.h"
+#include "Profiler.h"
+#include "GIFLibrary.h"
+#include "GIFReader.h"
 
 #define FILESYSTEM LittleFS
 
@@ -189,6 +193,7 @@ bool checkMemoryForGIF(size_t requiredSize) {
 
 // 前向声明
 extern void displayGIF(char *fileName);
+extern void requestDisplayMode(DisplayManager::DisplayMode mode);
 
 // 静态成员变量初始化
 uint8_t* ControlCharacteristicCallbacks::dataBuffer = NULL;
@@ -199,6 +204,9 @@ int ControlCharacteristicCallbacks::receivedChunks = 0;
 bool ControlCharacteristicCallbacks::isReceiving = false;
 bool ControlCharacteristicCallbacks::isHeaderReceived = false;
 unsigned long ControlCharacteristicCallbacks::lastReceiveTime = 0;
+int ControlCharacteristicCallbacks::pendingGIFScaleMode = -1;
+int ControlCharacteristicCallbacks::pendingGIFSpeed = -1;
+portMUX_TYPE ControlCharacteristicCallbacks::settingsMux = portMUX_INITIALIZER_UNLOCKED;
 
 // 全局静态变量，用于保存目标时间字符串
 char savedTargetString[10] = "";
@@ -214,7 +222,17 @@ bool GIFCharacteristicCallbacks::gifIsReceiving = false;
 bool GIFCharacteristicCallbacks::gifIsHeaderReceived = false;
 unsigned long GIFCharacteristicCallbacks::gifLastReceiveTime = 0;
 bool GIFCharacteristicCallbacks::gifUseFileMode = false;
+int GIFCharacteristicCallbacks::gifReadyBytes = 0;
+portMUX_TYPE GIFCharacteristicCallbacks::gifBufferMux = portMUX_INITIALIZER_UNLOCKED;
+uint32_t GIFCharacteristicCallbacks::gifHash = GIFLibrary::HASH_SEED;
+bool GIFCharacteristicCallbacks::gifStreaming = false;
 unsigned long GIFCharacteristicCallbacks::gifResetDelayTime = 0;
+GIFCharacteristicCallbacks::StoreState GIFCharacteristicCallbacks::gifStoreState = GIFCharacteristicCallbacks::STORE_NONE;
+uint32_t GIFCharacteristicCallbacks::gifStoreHash = 0;
+bool GIFCharacteristicCallbacks::gifStoreFileMode = false;
+uint8_t* GIFCharacteristicCallbacks::gifStoreBuffer = NULL;
+int32_t GIFCharacteristicCallbacks::gifStoreSize = 0;
+bool GIFCharacteristicCallbacks::gifStoreBusy = false;
 
 // BLEHandler静态实例指针初始化
 BLEHandler* BLEHandler::instance = nullptr;
@@ -239,6 +257,7 @@ ControlCharacteristicCallbacks::ControlCharacteristicCallbacks(MatrixPanel_I2S_D
 }
 
 void ControlCharacteristicCallbacks::onWrite(BLECharacteristic *pCharacteristic) {
+    PROFILE_SCOPE(PROF_BLE_CONTROL);
     uint8_t *data = pCharacteristic->getData();
     int dataLength = pCharacteristic->getLength();
     
@@ -296,6 +315,18 @@ void ControlCharacteristicCallbacks::onWrite(BLECharacteristic *pCharacteristic)
                     case BLE_CMD_TIMER_GAME: // 计时游戏命令
                         handleTimerGameCommand(commandData);
                         break;
+                    case BLE_CMD_GAMMA: // 伽马曲线
+                        handleGammaCommand(commandData);
+                        break;
+                    case BLE_CMD_LIBRARY: // 动画库
+                        handleLibraryCommand(commandData);
+                        break;
+                    case BLE_CMD_GIF_SCALE: // GIF缩放模式
+                        handleGIFScaleCommand(commandData);
+                        break;
+                    case BLE_CMD_GIF_SPEED: // GIF播放速度
+                        handleGIFSpeedCommand(commandData);
+                        break;
                     default:
                         printInfo("ControlCharacteristicCallbacks", ("未知命令类型: " + String(commandType)).c_str());
                         break;
@@ -476,6 +507,9 @@ void ControlCharacteristicCallbacks::handleFillScreenCommand(std::string value)
     
     int isClear = atoi(value.c_str());
     
+    // 全屏填充只有黑白两色，使用低色深
+    requestDisplayMode(DisplayManager::MODE_MONO);
+    
     if (isClear) {
         clear();
     } else {
@@ -499,6 +533,10 @@ void ControlCharacteristicCallbacks::handleFillPixelCommand(std::string value) {
         }
 
         if (count == 3) {
+            // 涂鸦只有黑白两色，和全屏填充一样使用低色深（GIF播放中不切换）
+            if (!*isShowGIF) {
+                requestDisplayMode(DisplayManager::MODE_MONO);
+            }
             if (values[2] == 0) {
                 dma_display->writePixel(values[0], values[1], 0x0000); // 黑色
             } else {
@@ -519,6 +557,112 @@ void ControlCharacteristicCallbacks::handleRefreshRateCommand(std::string value)
     }
 }
 
+void ControlCharacteristicCallbacks::handleGammaCommand(std::string value) {
+    printBLEInfo("handleGammaCommand", ("ble gamma recv:" + String(value.c_str())).c_str());
+    
+    int gamma = atoi(value.c_str());
+    if (gamma >= LED_GAMMA_CIE1931 && gamma <= LED_GAMMA_LINEAR) {
+        // 只重建颜色查找表，之后绘制的内容使用新曲线（GIF下一帧/文本下一次刷新即生效）
+        dma_display->setGamma((HUB75_I2S_CFG::gamma_curve)gamma);
+    }
+}
+
+void ControlCharacteristicCallbacks::handleGIFScaleCommand(std::string value) {
+    printBLEInfo("handleGIFScaleCommand", ("ble gif scale recv:" + String(value.c_str())).c_str());
+    
+    int mode = atoi(value.c_str());
+    if (value.empty() || mode < GIF_SCALE_CENTER || mode > GIF_SCALE_FILL) {
+        printInfo("handleGIFScaleCommand", ("无效的缩放模式: " + String(value.c_str())).c_str());
+        return;
+    }
+    portENTER_CRITICAL(&settingsMux);
+    pendingGIFScaleMode = mode;
+    portEXIT_CRITICAL(&settingsMux);
+}
+
+bool ControlCharacteristicCallbacks::takeGIFScaleMode(int* mode) {
+    portENTER_CRITICAL(&settingsMux);
+    bool pending = pendingGIFScaleMode >= 0;
+    if (pending) {
+        *mode = pendingGIFScaleMode;
+        pendingGIFScaleMode = -1;
+    }
+    portEXIT_CRITICAL(&settingsMux);
+    return pending;
+}
+
+void ControlCharacteristicCallbacks::handleGIFSpeedCommand(std::string value) {
+    printBLEInfo("handleGIFSpeedCommand", ("ble gif speed recv:" + String(value.c_str())).c_str());
+    
+    int percent = atoi(value.c_str());
+    if (percent <= 0) {
+        printInfo("handleGIFSpeedCommand", ("无效的播放速度: " + String(value.c_str())).c_str());
+        return;
+    }
+    // 超出范围的值由 GIFManager::setSpeed() 限制到 GIF_MIN_SPEED_PERCENT ~ GIF_MAX_SPEED_PERCENT
+    portENTER_CRITICAL(&settingsMux);
+    pendingGIFSpeed = percent;
+    portEXIT_CRITICAL(&settingsMux);
+}
+
+bool ControlCharacteristicCallbacks::takeGIFSpeed(int* percent) {
+    portENTER_CRITICAL(&settingsMux);
+    bool pending = pendingGIFSpeed > 0;
+    if (pending) {
+        *percent = pendingGIFSpeed;
+        pendingGIFSpeed = -1;
+    }
+    portEXIT_CRITICAL(&settingsMux);
+    return pending;
+}
+
+void ControlCharacteristicCallbacks::handleLibraryCommand(std::string value) {
+    printBLEInfo("handleLibraryCommand", ("ble library recv:" + String(value.c_str())).c_str());
+    
+    if (value.empty()) {
+        return;
+    }
+    
+    // 命令格式：P<ID> 播放，D<ID> 删除，L 通知清单；ID为8位十六进制
+    char op = value[0];
+    uint32_t id = strtoul(value.c_str() + 1, NULL, 16);
+    
+    switch (op) {
+        case 'P': {
+            if (!GIFLibrary::play(id)) {
+                return;
+            }
+            // 之前上传完成、还没开始播放的GIF不再播放
+            GIFCharacteristicCallbacks::dropReadyGIF();
+            
+            // 停止其他显示，由主循环停止当前GIF并从库中的文件重新初始化
+            setClockMode(false);
+            *isScrollText = false;
+            *isShowGIF = true;
+            printInfo("handleLibraryCommand", ("切换到动画: " + String(id, HEX)).c_str());
+            break;
+        }
+        case 'D':
+            if (*isShowGIF && GIFLibrary::isActive(id)) {
+                printInfo("handleLibraryCommand", "正在播放的动画不能删除");
+                return;
+            }
+            if (!GIFLibrary::remove(id)) {
+                return;
+            }
+            break;
+        case 'L':
+            break;
+        default:
+            printInfo("handleLibraryCommand", ("未知的动画库命令: " + String(op)).c_str());
+            return;
+    }
+    
+    if (BLEHandler::instance) {
+        BLEHandler::instance->sendLibraryManifest();
+    }
+}
+
 void ControlCharacteristicCallbacks::handleImageCommand(std::string value) {
     printBLEInfo("handleImageCommand", ("图片命令接收: " + String(value.c_str())).c_str());
     
@@ -658,6 +802,7 @@ void ControlCharacteristicCallbacks::drawCompleteImage() {
     *isScrollText = false;
     delay(50);
     freeScrollText();
+    requestDisplayMode(DisplayManager::MODE_MONO);  // 单色位图，使用低色深
     clear();
     
     int imageSize = sqrt(expectedBytes * 8);
@@ -702,6 +847,7 @@ BrightnessCharacteristicCallbacks::BrightnessCharacteristicCallbacks(void (*brig
 }
 
 void BrightnessCharacteristicCallbacks::onWrite(BLECharacteristic *pCharacteristic) {
+    PROFILE_SCOPE(PROF_BLE_BRIGHTNESS);
     std::string value = pCharacteristic->getValue();
     printBLEInfo("BrightnessCharacteristicCallbacks", ("ble brightness recv:" + String(value.c_str())).c_str());
     
@@ -729,6 +875,25 @@ void BrightnessCharacteristicCallbacks::onRead(BLECharacteristic *pCharacteristi
     printBLEInfo("BrightnessCharacteristicCallbacks", (String("ble brightness onRead info:") + info).c_str());
 }
 
+// ProfilerCharacteristicCallbacks 实现
+// 读取时返回当前的性能统计文本
+void ProfilerCharacteristicCallbacks::onRead(BLECharacteristic *pCharacteristic) {
+    char text[PROFILER_TEXT_SIZE];
+    size_t len = Profiler::format(text, sizeof(text));
+    pCharacteristic->setValue((uint8_t*)text, len);
+    printBLEInfo("ProfilerCharacteristicCallbacks", (String("ble profiler onRead:") + text).c_str());
+}
+
+
+// LibraryCharacteristicCallbacks 实现
+// 读取时返回动画库清单
+void LibraryCharacteristicCallbacks::onRead(BLECharacteristic *pCharacteristic) {
+    char text[GIF_LIBRARY_TEXT_SIZE];
+    size_t len = GIFLibrary::format(text, sizeof(text));
+    pCharacteristic->setValue((uint8_t*)text, len);
+    printBLEInfo("LibraryCharacteristicCallbacks", (String("ble library onRead:") + text).c_str());
+}
+
 
 // GIFCharacteristicCallbacks 实现
 GIFCharacteristicCallbacks::GIFCharacteristicCallbacks(MatrixPanel_I2S_DMA* display, bool* scrollFlag, bool* gifFlag,
@@ -741,6 +906,7 @@ GIFCharacteristicCallbacks::GIFCharacteristicCallbacks(MatrixPanel_I2S_DMA* disp
 }
 
 void GIFCharacteristicCallbacks::onWrite(BLECharacteristic *pCharacteristic) {
+    PROFILE_SCOPE(PROF_BLE_GIF);
     uint8_t *v = pCharacteristic->getData();
     int dataLength = pCharacteristic->getLength();
     
@@ -823,6 +989,11 @@ void GIFCharacteristicCallbacks::handleGIFHeader(uint8_t* data, int length) {
     printBLEInfo("handleGIFHeader", ("头信息: 期望接收 " + String(gifExpectedBytes) + " 字节").c_str());
     printInfo("handleGIFHeader", ("头信息字节: " + String(data[0], HEX) + " " + String(data[1], HEX) + " " + String(data[2], HEX) + " " + String(data[3], HEX)).c_str());
     
+    // 上一个GIF还没被播放器取走的话，不再交给播放器
+    dropReadyGIF();
+    gifHash = GIFLibrary::HASH_SEED;
+    gifStreaming = false;
+    
     // 检查GIF文件大小是否合理
     if (gifExpectedBytes <= 0 || gifExpectedBytes > GIF_MAX_FILE_SIZE) {
         printInfo("handleGIFHeader", ("GIF文件大小不合理: " + String(gifExpectedBytes) + " 字节 (最大1MB)").c_str());
@@ -894,7 +1065,7 @@ void GIFCharacteristicCallbacks::handleGIFHeader(uint8_t* data, int length) {
         tempFile.close();
         
         // 不分配大缓冲区，使用小缓冲区进行流式处理
-        gifDataBuffer = NULL;
+        freeGIFDataBuffer();
         gifUseFileMode = true;  // 设置文件模式标志
     } else {
         // 小文件使用内存缓冲区
@@ -914,10 +1085,7 @@ void GIFCharacteristicCallbacks::handleGIFHeader(uint8_t* data, int length) {
         printInfo("handleGIFHeader", ("内存检查通过，需要 " + String(requiredMemory) + " 字节，可用 " + String(freeHeap) + " 字节").c_str());
         
         // 分配缓冲区
-        if (gifDataBuffer != NULL) {
-            psram_free(gifDataBuffer);
-            gifDataBuffer = NULL;
-        }
+        freeGIFDataBuffer();
         
         // 优先尝试PSRAM分配
         if (psramAvailable) {
@@ -995,6 +1163,13 @@ void GIFCharacteristicCallbacks::handleGIFHeader(uint8_t* data, int length) {
     // 根据实际模式设置标志
     printInfo("handleGIFHeader", ("GIF模式设置: 文件模式=" + String(gifUseFileMode ? "是" : "否")).c_str());
     
+#if GIF_STREAM_ENABLED
+    // 内存模式边接收边扫描帧边界，第一帧收完即可开始播放
+    if (!gifUseFileMode) {
+        GIFStream::begin(gifDataBuffer, gifExpectedBytes);
+    }
+#endif
+    
     // 计算期望的数据块数 - 使用动态MTU大小
     // App端发送的数据块大小是 MTU-2，即 512-2 = 510字节
     int chunkSize = 510;  // 与App端保持一致
@@ -1077,6 +1252,8 @@ void GIFCharacteristicCallbacks::handleGIFDataChunk(uint8_t* data, int length) {
         esp_task_wdt_reset();
     }
     
+    // 边接收边计算内容哈希，保存到动画库时不用再读一遍
+    gifHash = GIFLibrary::hash(data, length, gifHash);
     gifReceivedBytes += length;
     gifReceivedChunks++;
     
@@ -1089,6 +1266,16 @@ void GIFCharacteristicCallbacks::handleGIFDataChunk(uint8_t* data, int length) {
         printInfo("handleGIFDataChunk", ("GIF接收进度: " + String(gifReceivedChunks) + "/" + String(gifExpectedChunks) + " 块 (" + String((gifReceivedChunks * 100) / gifExpectedChunks) + "%), 内存: " + String(currentFreeHeap) + " 字节").c_str());
     }
     
+#if GIF_STREAM_ENABLED
+    // 内存模式：第一帧完整收到后就开始播放，播放器只解码已收完的帧
+    if (!gifUseFileMode) {
+        GIFStream::update(gifReceivedBytes);
+        if (!gifStreaming && gifReceivedBytes < gifExpectedBytes && GIFStream::frameCount() > 0) {
+            startStreaming();
+        }
+    }
+#endif
+    
     // 检查是否接收完成 - 允许一定的容错范围
     if (gifReceivedBytes >= gifExpectedBytes || gifReceivedChunks >= gifExpectedChunks) {
         printBLEInfo("handleGIFDataChunk", ("GIF数据接收完成: " + String(gifReceivedBytes) + "/" + String(gifExpectedBytes) + " 字节, " + String(gifReceivedChunks) + "/" + String(gifExpectedChunks) + " 块").c_str());
@@ -1105,6 +1292,13 @@ void GIFCharacteristicCallbacks::handleGIFDataChunk(uint8_t* data, int length) {
         
         DEBUG_PRINTLN("=== GIF数据接收完成，准备显示 ===");
         
+#if GIF_STREAM_ENABLED
+        // 边接收边播放的播放器不再等待，之后所有帧都能解码，接着从缓冲区循环播放
+        if (!gifUseFileMode) {
+            GIFStream::finish();
+        }
+#endif
+        
         // 异步处理GIF显示，不阻塞BLE接收
         prepareGIFForDisplay();
         
@@ -1121,6 +1315,39 @@ void GIFCharacteristicCallbacks::handleGIFDataChunk(uint8_t* data, int length) {
     }
 }
 
+// 第一帧已收到：先从接收缓冲区开始播放，接收完成后播放器接着循环播放，不再切换
+void GIFCharacteristicCallbacks::startStreaming() {
+    gifStreaming = true;
+    printBLEInfo("startStreaming", ("第一帧已收到，边接收边播放: " + String(gifReceivedBytes) + "/" + String(gifExpectedBytes) + " 字节").c_str());
+    
+    // 只通知主循环，滚动文本由主循环开始播放GIF时释放，BLE回调中不等待
+    *isScrollText = false;
+    
+    GIFLibrary::select(GIF_STREAM_PATH);
+    *isShowGIF = true;
+}
+
+// 释放接收缓冲区；边接收边播放的播放器还在读时不能释放，由GIFStream在播放器放开后释放
+void GIFCharacteristicCallbacks::freeGIFDataBuffer() {
+    // 主循环可能同时在 takeGIFBuffer() 中取缓冲区，只在临界区内摘下，释放放到临界区外
+    portENTER_CRITICAL(&gifBufferMux);
+    uint8_t* buffer = gifDataBuffer;
+    gifDataBuffer = NULL;
+    gifReadyBytes = 0;
+    if (dropStore(buffer)) {
+        buffer = NULL;
+    }
+    portEXIT_CRITICAL(&gifBufferMux);
+    if (buffer == NULL) {
+        return;
+    }
+    if (GIFStream::release(buffer)) {
+        DEBUG_PRINTLN("播放器仍在读取GIF接收缓冲区，停止后释放");
+    } else {
+        psram_free(buffer);
+    }
+}
+
 // 辅助函数：重置GIF接收状态但不删除文件
 void GIFCharacteristicCallbacks::resetGIFReceiveStateOnly() {
     gifReceivedBytes = 0;
@@ -1234,7 +1461,7 @@ void GIFCharacteristicCallbacks::prepareGIFForDisplay() {
         
         printBLEInfo("prepareGIFForDisplay", ("大文件GIF已保存: " + String(fileSize) + " 字节").c_str());
     } else {
-        // 小文件模式：需要将内存中的数据写入文件
+        // 小文件模式：直接从内存缓冲区解码，不再写入文件系统
         if (gifDataBuffer == NULL) {
             DEBUG_PRINTLN("GIF缓冲区为空");
             // 只重置状态，不删除文件，让主循环处理清理
@@ -1242,41 +1469,7 @@ void GIFCharacteristicCallbacks::prepareGIFForDisplay() {
             return;
         }
         
-        File tempFile = FILESYSTEM.open("/temp.gif", "w");
-        if (!tempFile) {
-            DEBUG_PRINTLN("无法创建临时GIF文件");
-            // 只重置状态，不删除文件，让主循环处理清理
-            gifReceivedBytes = 0;
-            gifExpectedBytes = 0;
-            gifExpectedChunks = 0;
-            gifReceivedChunks = 0;
-            gifIsReceiving = false;
-            gifIsHeaderReceived = false;
-            gifLastReceiveTime = 0;
-            return;
-        }
-        
-        yield(); // 喂狗
-        esp_task_wdt_reset();
-        size_t written = tempFile.write(gifDataBuffer, gifReceivedBytes);
-        yield(); // 喂狗
-        esp_task_wdt_reset();
-        tempFile.close();
-        
-        if (written != gifReceivedBytes) {
-            DEBUG_PRINTLN("GIF文件写入失败");
-            // 只重置状态，不删除文件，让主循环处理清理
-            gifReceivedBytes = 0;
-            gifExpectedBytes = 0;
-            gifExpectedChunks = 0;
-            gifReceivedChunks = 0;
-            gifIsReceiving = false;
-            gifIsHeaderReceived = false;
-            gifLastReceiveTime = 0;
-            return;
-        }
-        
-        printBLEInfo("prepareGIFForDisplay", ("小文件GIF已保存: " + String(written) + " 字节").c_str());
+        printBLEInfo("prepareGIFForDisplay", ("小文件GIF留在内存中播放: " + String(gifReceivedBytes) + " 字节").c_str());
     }
     
     // 显示GIF前再次检查内存
@@ -1296,10 +1489,18 @@ void GIFCharacteristicCallbacks::prepareGIFForDisplay() {
         return;
     }
     
-    // 停止滚动文本
+    // 停止滚动文本（由主循环开始播放GIF时释放）
     *isScrollText = false;
-    delay(50);
-    freeScrollText();
+    
+    // 内存模式的缓冲区由主循环通过 takeGIFBuffer() 交给播放器
+    if (!gifUseFileMode) {
+        portENTER_CRITICAL(&gifBufferMux);
+        gifReadyBytes = gifReceivedBytes;
+        portEXIT_CRITICAL(&gifBufferMux);
+    }
+    
+    // 由保存任务保存到动画库并选中，或者直接选中这一次上传的文件
+    queueGIFStore();
     
     // 设置GIF显示标志，让主循环处理显示
     *isShowGIF = true;
@@ -1308,20 +1509,111 @@ void GIFCharacteristicCallbacks::prepareGIFForDisplay() {
     printInfo("prepareGIFForDisplay", ("GIF文件大小: " + String(gifReceivedBytes) + " 字节").c_str());
     printInfo("prepareGIFForDisplay", ("当前可用内存: " + String(ESP.getFreeHeap()) + " 字节").c_str());
     printInfo("prepareGIFForDisplay", ("GIF显示标志已设置: isShowGIF=" + String(*isShowGIF)).c_str());
-    
-    // 验证文件确实存在
-    if (FILESYSTEM.exists("/temp.gif")) {
-        File verifyFile = FILESYSTEM.open("/temp.gif", "r");
-        if (verifyFile) {
-            size_t verifySize = verifyFile.size();
-            verifyFile.close();
-            printInfo("prepareGIFForDisplay", ("文件验证成功: /temp.gif 存在，大小 " + String(verifySize) + " 字节").c_str());
-        } else {
-            printError("prepareGIFForDisplay", "文件验证失败: 无法打开 /temp.gif");
+}
+
+// 上传完成：记下要保存到动画库的GIF，写flash和选中由主循环启动的保存任务完成；
+// 文件模式先改名为 GIF_STORE_FILE，之后开始的上传重新写临时文件时不会和保存任务冲突
+void GIFCharacteristicCallbacks::queueGIFStore() {
+#if GIF_LIBRARY_ENABLED
+    // 保存任务还在保存上一个GIF时不能覆盖它的文件和状态，这一次只播放不保存
+    portENTER_CRITICAL(&gifBufferMux);
+    bool busy = gifStoreState == STORE_RUNNING || gifStoreState == STORE_DROPPED;
+    portEXIT_CRITICAL(&gifBufferMux);
+    if (!busy && (!gifUseFileMode || FILESYSTEM.rename(GIF_FILE, GIF_STORE_FILE))) {
+        portENTER_CRITICAL(&gifBufferMux);
+        gifStoreState = STORE_PENDING;
+        gifStoreHash = gifHash;
+        gifStoreFileMode = gifUseFileMode;
+        portEXIT_CRITICAL(&gifBufferMux);
+        return;
+    }
+    printInfo("queueGIFStore", "GIF不保存到动画库，只播放这一次");
+#endif
+    // 边接收边播放的播放器接着播放，不重新选中
+    if (!gifUseFileMode && GIFStream::reading(gifDataBuffer)) {
+        return;
+    }
+    GIFLibrary::select(GIF_FILE);
+}
+
+// 写flash（内存模式最多几百KB，命中哈希时还要读回比较）放到低优先级任务中，
+// 主循环只等到保存任务选中新GIF后再打开播放器
+bool GIFCharacteristicCallbacks::storeUploadedGIF() {
+    portENTER_CRITICAL(&gifBufferMux);
+    bool pending = gifStoreState == STORE_PENDING && !gifStoreBusy;
+    if (pending) {
+        // 保存期间BLE任务的释放都推迟到保存任务，缓冲区不会被释放
+        gifStoreState = STORE_RUNNING;
+        gifStoreBuffer = gifStoreFileMode ? NULL : gifDataBuffer;
+        gifStoreSize = gifReadyBytes;
+        gifStoreBusy = true;
+    }
+    portEXIT_CRITICAL(&gifBufferMux);
+
+    if (pending) {
+        if (xTaskCreatePinnedToCore(storeTaskMain, "gifStore", GIF_STORE_TASK_STACK, NULL,
+                                    GIF_STORE_TASK_PRIORITY, NULL, GIF_STORE_TASK_CORE) != pdPASS) {
+            printError("storeUploadedGIF", "无法创建保存任务，在主循环中保存");
+            storeGIF();
+        }
+    }
+
+    portENTER_CRITICAL(&gifBufferMux);
+    bool busy = gifStoreBusy;
+    portEXIT_CRITICAL(&gifBufferMux);
+    return busy;
+}
+
+void GIFCharacteristicCallbacks::storeTaskMain(void* /*param*/) {
+    storeGIF();
+    vTaskDelete(NULL);
+}
+
+// 文件模式移入库中，内存模式写一份，之后可以用ID直接切换；
+// 保存失败时照常播放这一次上传的文件或内存。选中之后才清除保存标志，主循环不会先打开旧文件
+void GIFCharacteristicCallbacks::storeGIF() {
+    portENTER_CRITICAL(&gifBufferMux);
+    const uint32_t hash = gifStoreHash;
+    const bool fileMode = gifStoreFileMode;
+    const int32_t size = gifStoreSize;
+    portEXIT_CRITICAL(&gifBufferMux);
+
+    uint32_t assetId = 0;
+    bool stored = fileMode ? GIFLibrary::addFile(GIF_STORE_FILE, hash, &assetId)
+                           : (gifStoreBuffer != NULL && GIFLibrary::addBuffer(gifStoreBuffer, size, hash, &assetId));
+    // 边接收边播放的播放器已经在读完整的缓冲区，接着循环播放即可；重新选中会清屏并从第一帧开始
+    const bool streamed = gifStoreBuffer != NULL && GIFStream::reading(gifStoreBuffer);
+
+    portENTER_CRITICAL(&gifBufferMux);
+    const bool dropped = gifStoreState == STORE_DROPPED;
+    uint8_t* buffer = gifStoreBuffer;
+    gifStoreBuffer = NULL;
+    gifStoreState = STORE_NONE;
+    portEXIT_CRITICAL(&gifBufferMux);
+
+    if (dropped) {
+        // 保存期间开始了新的上传或切换了显示：不再选中，放弃的缓冲区和文件在这里清理
+        if (buffer != NULL && !GIFStream::release(buffer)) {
+            psram_free(buffer);
+        }
+        if (fileMode && !stored) {
+            FILESYSTEM.remove(GIF_STORE_FILE);
+        }
+    } else if (stored && (streamed ? GIFLibrary::markPlaying(assetId) : GIFLibrary::play(assetId))) {
+        printBLEInfo("storeGIF", ("GIF已保存到动画库，ID: " + String(assetId, HEX)).c_str());
+        if (BLEHandler::instance) {
+            BLEHandler::instance->sendLibraryManifest();
         }
     } else {
-        printError("prepareGIFForDisplay", "文件验证失败: /temp.gif 不存在");
+        printInfo("storeGIF", "GIF未保存到动画库，只播放这一次");
+        if (!streamed) {
+            GIFLibrary::select(fileMode ? GIF_STORE_FILE : GIF_FILE);
+        }
     }
+
+    portENTER_CRITICAL(&gifBufferMux);
+    gifStoreBusy = false;
+    portEXIT_CRITICAL(&gifBufferMux);
 }
 
 void GIFCharacteristicCallbacks::loadAndDisplayGIF() {
@@ -1335,19 +1627,24 @@ void GIFCharacteristicCallbacks::loadAndDisplayGIF() {
 
 // 当GIF显示完成或停止时调用此函数清理资源
 void GIFCharacteristicCallbacks::cleanupAfterDisplay() {
+    // 边接收边播放失败时接收还在进行，不打断它，接收完成后照常播放
+    if (gifIsHeaderReceived && gifReceivedBytes < gifExpectedBytes && gifReceivedChunks < gifExpectedChunks) {
+        DEBUG_PRINTLN("GIF仍在接收中，暂不清理");
+        return;
+    }
+    
     // 删除临时文件（只在播放完成后删除）
     if (FILESYSTEM.exists("/temp.gif")) {
         FILESYSTEM.remove("/temp.gif");
         DEBUG_PRINTLN("GIF播放完成，已删除临时文件");
     }
-    
-    // 释放内存缓冲区
-    if (gifDataBuffer != NULL) {
-        psram_free(gifDataBuffer);
-        gifDataBuffer = NULL;
-        DEBUG_PRINTLN("GIF播放完成，已释放内存缓冲区");
+    if (FILESYSTEM.exists(GIF_STORE_FILE)) {
+        FILESYSTEM.remove(GIF_STORE_FILE);
     }
     
+    // 释放内存缓冲区（同时清除还没交给播放器的就绪标记）
+    freeGIFDataBuffer();
+    
     // 重置状态变量
     gifReceivedBytes = 0;
     gifExpectedBytes = 0;
@@ -1362,11 +1659,8 @@ void GIFCharacteristicCallbacks::cleanupAfterDisplay() {
 }
 
 void GIFCharacteristicCallbacks::resetGIFReceive() {
-    // 释放内存缓冲区
-    if (gifDataBuffer != NULL) {
-        psram_free(gifDataBuffer);
-        gifDataBuffer = NULL;
-    }
+    // 释放内存缓冲区（边接收边播放的播放器看到接收中止后停止）
+    freeGIFDataBuffer();
     
     // 删除临时文件（只在接收错误时删除）
     if (FILESYSTEM.exists("/temp.gif")) {
@@ -1387,6 +1681,7 @@ void GIFCharacteristicCallbacks::resetGIFReceive() {
     gifIsHeaderReceived = false;
     gifLastReceiveTime = 0;
     gifUseFileMode = false;
+    gifStreaming = false;
     
     DEBUG_PRINTLN("GIF接收状态已重置，内存和文件已清理");
 }
@@ -1419,6 +1714,54 @@ bool GIFCharacteristicCallbacks::isReceivingGIF() {
     return gifIsReceiving;
 }
 
+uint8_t* GIFCharacteristicCallbacks::takeGIFBuffer(int32_t* size) {
+    uint8_t* buffer = NULL;
+    portENTER_CRITICAL(&gifBufferMux);
+    if (!gifUseFileMode && gifDataBuffer != NULL && gifReadyBytes > 0) {
+        // 转交所有权，之后的接收和清理都不会再释放这块内存；
+        // 边接收边播放的播放器已在切换时放开，没有放开时由GIFStream释放，不能转交
+        if (!GIFStream::release(gifDataBuffer)) {
+            buffer = gifDataBuffer;
+            *size = gifReadyBytes;
+        }
+        gifDataBuffer = NULL;
+        gifReadyBytes = 0;
+    }
+    portEXIT_CRITICAL(&gifBufferMux);
+    return buffer;
+}
+
+// 放弃等待保存或正在保存的GIF（在gifBufferMux内调用）；buffer 是正在保存的缓冲区时返回true，由保存任务释放
+bool GIFCharacteristicCallbacks::dropStore(uint8_t* buffer) {
+    if (gifStoreState == STORE_PENDING) {
+        gifStoreState = STORE_NONE;
+    } else if (gifStoreState == STORE_RUNNING) {
+        gifStoreState = STORE_DROPPED;
+    }
+    return buffer != NULL && buffer == gifStoreBuffer;
+}
+
+void GIFCharacteristicCallbacks::dropReadyGIF() {
+    // 主循环可能同时在取缓冲区，只在临界区内摘下，释放放到临界区外
+    uint8_t* buffer = NULL;
+    portENTER_CRITICAL(&gifBufferMux);
+    if (gifReadyBytes > 0) {
+        buffer = gifDataBuffer;
+        gifDataBuffer = NULL;
+        gifReadyBytes = 0;
+    }
+    if (dropStore(buffer)) {
+        buffer = NULL;
+    }
+    portEXIT_CRITICAL(&gifBufferMux);
+    if (buffer != NULL) {
+        if (!GIFStream::release(buffer)) {
+            psram_free(buffer);
+        }
+        DEBUG_PRINTLN("已释放未播放的GIF缓冲区");
+    }
+}
+
 // 系统启动时清理残留文件
 void GIFCharacteristicCallbacks::cleanupOnStartup() {
     // 删除可能存在的临时GIF文件（启动时清理残留文件）
@@ -1426,6 +1769,9 @@ void GIFCharacteristicCallbacks::cleanupOnStartup() {
         FILESYSTEM.remove("/temp.gif");
         DEBUG_PRINTLN("启动时清理：已删除残留的临时GIF文件");
     }
+    if (FILESYSTEM.exists(GIF_STORE_FILE)) {
+        FILESYSTEM.remove(GIF_STORE_FILE);
+    }
     
     // 确保状态变量被重置
     if (gifDataBuffer != NULL) {
@@ -1443,6 +1789,7 @@ void GIFCharacteristicCallbacks::cleanupOnStartup() {
     gifIsHeaderReceived = false;
     gifLastReceiveTime = 0;
     gifUseFileMode = false;
+    gifReadyBytes = 0;
     
     // 内存优化：触发内存整理
     size_t freeHeap = ESP.getFreeHeap();
@@ -1519,6 +1866,8 @@ BLEHandler::BLEHandler(MatrixPanel_I2S_DMA* display, AnimatedGIF* gifDecoder,
     isScrollText = scrollFlag;
     isShowGIF = gifFlag;
     clockManager = clockMgr;
+    pProfilerCharacteristic = nullptr;
+    pLibraryCharacteristic = nullptr;
     
     // 设置静态实例指针
     instance = this;
@@ -1585,6 +1934,20 @@ void BLEHandler::createCharacteristics() {
     String deviceInfo = String("FW:") + FIRMWARE_VERSION + ",RES:" + String(PANEL_RES_X) + "x" + String(PANEL_RES_Y);
     pCharacDeviceInfo->setValue((uint8_t*)deviceInfo.c_str(), deviceInfo.length());
     pDeviceInfoCharacteristic = pCharacDeviceInfo;
+
+    // 性能统计特征 - 读取时生成，连接期间定时通知
+    BLECharacteristic *pCharacProfiler = pService->createCharacteristic(
+        BLE_CHARACTERISTIC_PROFILER_UUID,
+        BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+    pCharacProfiler->setCallbacks(new ProfilerCharacteristicCallbacks());
+    pProfilerCharacteristic = pCharacProfiler;
+    
+    // 动画库特征 - 读取时返回清单，库有变化时通知
+    BLECharacteristic *pCharacLibrary = pService->createCharacteristic(
+        BLE_CHARACTERISTIC_LIBRARY_UUID,
+        BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+    pCharacLibrary->setCallbacks(new LibraryCharacteristicCallbacks());
+    pLibraryCharacteristic = pCharacLibrary;
     
     // GIF特征值 - 单独保留
     BLECharacteristic *pCharacGIF = pService->createCharacteristic(
@@ -1657,6 +2020,26 @@ void BLEHandler::sendCurrentBrightnessStatic(int brightness) {
     }
 }
 
+void BLEHandler::sendProfilerStats() {
+    if (pProfilerCharacteristic == nullptr || pServer == nullptr || pServer->getConnectedCount() == 0) {
+        return;
+    }
+    char text[PROFILER_TEXT_SIZE];
+    size_t len = Profiler::format(text, sizeof(text));
+    pProfilerCharacteristic->setValue((uint8_t*)text, len);
+    pProfilerCharacteristic->notify();
+}
+
+void BLEHandler::sendLibraryManifest() {
+    if (pLibraryCharacteristic == nullptr || pServer == nullptr || pServer->getConnectedCount() == 0) {
+        return;
+    }
+    char text[GIF_LIBRARY_TEXT_SIZE];
+    size_t len = GIFLibrary::format(text, sizeof(text));
+    pLibraryCharacteristic->setValue((uint8_t*)text, len);
+    pLibraryCharacteristic->notify();
+}
+
 int BLEHandler::getCurrentBrightness() {
     if (getCurrentBrightnessFunc != nullptr) {
         return getCurrentBrightnessFunc();
@@ -106,6 +106,11 @@ private:
     static bool isHeaderReceived;
     static unsigned long lastReceiveTime;
     
+    // BLE设置的GIF缩放模式和播放速度，-1为没有新的设置；由主循环取走后应用
+    static int pendingGIFScaleMode;
+    static int pendingGIFSpeed;
+    static portMUX_TYPE settingsMux;
+    
 public:
     ControlCharacteristicCallbacks(MatrixPanel_I2S_DMA* display, bool* scrollFlag, bool* gifFlag,
                                   void (*textSizeFunc)(int), void (*scrollSpeedFunc)(int),
@@ -116,6 +121,12 @@ public:
     
     static void checkTimeout();
     
+    // 主循环取走BLE设置的GIF缩放模式，没有新的设置时返回false
+    // （播放中切换缩放要停止并重启解码任务，不能在BLE回调中进行）
+    static bool takeGIFScaleMode(int* mode);
+    // 主循环取走BLE设置的GIF播放速度百分比，没有新的设置时返回false
+    static bool takeGIFSpeed(int* percent);
+    
     // 更新计时游戏显示
     void updateTimerGameDisplay();
     
@@ -129,6 +140,10 @@ private:
     void handleFillScreenCommand(std::string value);
     void handleFillPixelCommand(std::string value);
     void handleRefreshRateCommand(std::string value);
+    void handleGammaCommand(std::string value);
+    void handleLibraryCommand(std::string value);
+    void handleGIFScaleCommand(std::string value);
+    void handleGIFSpeedCommand(std::string value);
     void handleTimerGameCommand(std::string value);
     void handleTimerGameStart();
     void handleTimerGameTimerStart();
@@ -156,6 +171,22 @@ public:
     void onWrite(BLECharacteristic *pCharacteristic);
 };
 
+/**
+ * 性能统计特征值回调
+ */
+class ProfilerCharacteristicCallbacks : public BLECharacteristicCallbacks {
+public:
+    void onRead(BLECharacteristic *pCharacteristic) override;
+};
+
+/**
+ * 动画库特征值回调
+ */
+class LibraryCharacteristicCallbacks : public BLECharacteristicCallbacks {
+public:
+    void onRead(BLECharacteristic *pCharacteristic) override;
+};
+
 /**
  * GIF显示特征值回调
  */
@@ -178,8 +209,26 @@ private:
     static unsigned long gifLastReceiveTime;
     //标记是否使用文件模式
     static bool gifUseFileMode;
+    //内存模式下已接收完整、可交给播放器的字节数
+    static int gifReadyBytes;
+    //保护接收缓冲区在BLE任务与主循环之间的转交
+    static portMUX_TYPE gifBufferMux;
+    //已接收数据的内容哈希，保存到动画库时作为ID
+    static uint32_t gifHash;
+    //这一次接收已经开始边接收边播放
+    static bool gifStreaming;
     //延迟重置时间
     static unsigned long gifResetDelayTime; 
+    //上传完成的GIF保存到动画库的进度（gifBufferMux保护）：等待主循环、主循环保存中、保存中被放弃
+    enum StoreState { STORE_NONE, STORE_PENDING, STORE_RUNNING, STORE_DROPPED };
+    static StoreState gifStoreState;
+    static uint32_t gifStoreHash;
+    static bool gifStoreFileMode;
+    //保存任务正在保存的内存GIF，保存期间被放弃时由保存任务释放
+    static uint8_t* gifStoreBuffer;
+    static int32_t gifStoreSize;
+    //保存任务正在运行（gifBufferMux保护），保存并选中后才清除
+    static bool gifStoreBusy;
     
 public:
     GIFCharacteristicCallbacks(MatrixPanel_I2S_DMA* display, bool* scrollFlag, bool* gifFlag,
@@ -193,11 +242,24 @@ public:
     static void cleanupAfterDisplay();
     //检查是否正在接收GIF数据
     static bool isReceivingGIF(); 
+    //取走内存模式下接收完成的GIF缓冲区（之后由调用方释放），文件模式或没有数据时返回NULL
+    static uint8_t* takeGIFBuffer(int32_t* size);
+    //切换到动画库中的动画或开始接收新的GIF时，丢弃已接收完成但还没交给播放器的内存GIF
+    static void dropReadyGIF();
+    //主循环调用：启动后台任务把上传完成的GIF保存到动画库并选中，写flash不占用BLE回调和主循环；
+    //保存任务还在运行时返回true
+    static bool storeUploadedGIF();
     
 private:
     void handleGIFHeader(uint8_t* data, int length);
     void handleGIFDataChunk(uint8_t* data, int length);
     void prepareGIFForDisplay();
+    void queueGIFStore();
+    void startStreaming();
+    static void freeGIFDataBuffer();
+    static bool dropStore(uint8_t* buffer);
+    static void storeTaskMain(void* param);
+    static void storeGIF();
     void loadAndDisplayGIF();
     void handleImageDisplay();
     static void resetGIFReceive();
@@ -235,6 +297,8 @@ private:
     BLECharacteristic* pControlCharacteristic;
     BLECharacteristic* pBrightnessCharacteristic;
     BLECharacteristic* pDeviceInfoCharacteristic;
+    BLECharacteristic* pProfilerCharacteristic;
+    BLECharacteristic* pLibraryCharacteristic;
     
     // 回调函数指针
     void (*setTextSizeFunc)(int);
@@ -283,6 +347,12 @@ public:
     // 获取当前亮度值
     int getCurrentBrightness();
     
+    // 有客户端连接时通知性能统计结果
+    void sendProfilerStats();
+    
+    // 有客户端连接时通知动画库清单
+    void sendLibraryManifest();
+    
     // 更新计时游戏显示
     void updateTimerGameDisplay();
     
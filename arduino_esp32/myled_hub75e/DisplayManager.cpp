@@ -1,9 +1,10 @@
 #include "DisplayManager.h"
+#include "Profiler.h"
 #include <LittleFS.h>
 
 #define FILESYSTEM LittleFS
 
-DisplayManager::DisplayManager() : dma_display(nullptr), currentBrightness(LED_DEFAULT_BRIGHTNAESS) {
+DisplayManager::DisplayManager() : dma_display(nullptr), currentBrightness(LED_DEFAULT_BRIGHTNAESS), currentMode(MODE_GIF), pendingMode(-1) {
 }
 
 DisplayManager::~DisplayManager() {
@@ -38,6 +39,9 @@ bool DisplayManager::initLED() {
     
     mxconfig.clkphase = false;
     mxconfig.driver = HUB75_I2S_CFG::FM6124;
+    mxconfig.gamma = (HUB75_I2S_CFG::gamma_curve)LED_DEFAULT_GAMMA;
+    mxconfig.double_buff = LED_DOUBLE_BUFFER;
+    mxconfig.triple_buff = LED_TRIPLE_BUFFER;
 
     // 创建矩阵对象
     dma_display = new MatrixPanel_I2S_DMA(mxconfig);
@@ -51,6 +55,30 @@ bool DisplayManager::initLED() {
         return false;
     }
 
+    // DMA内存布局：块数、占用字节与浪费字节
+    const dmaArena& arena = dma_display->getDMAArena();
+    ::printInfo("initLED", ("DMA内存: " + String(arena.blocks) + "块, 共" + String(arena.reserved()) +
+                            "字节, 浪费" + String(arena.wasted()) + "字节").c_str());
+
+    if (LED_TRIPLE_BUFFER) {
+        dma_display->setFramePacing(LED_FRAME_PACING);
+    }
+
+    // 启用RGB565影子帧缓冲，失败时直接写DMA缓冲区
+    if (LED_SHADOW_BUFFER) {
+        if (dma_display->setShadowBuffer(true)) {
+            ::printInfo("initLED", "RGB565影子帧缓冲已启用");
+        } else {
+            ::printError("initLED", "影子帧缓冲分配失败，直接绘制到DMA缓冲区");
+        }
+    }
+
+    // 按初始的GIF模式设置色深和时间抖动
+    dma_display->setColorDepth(LED_COLOR_DEPTH_GIF);
+    if (LED_TEMPORAL_DITHER && !dma_display->setDither(true)) {
+        ::printError("initLED", "时间抖动需要影子帧缓冲，未开启");
+    }
+
     pinMode(0, INPUT);
     
     // 初始化颜色定义
@@ -75,37 +103,100 @@ void DisplayManager::clear() {
     }
 }
 
+void DisplayManager::present() {
+    if (dma_display != nullptr) {
+        // BLE回调请求的模式切换在这里执行，不会和loop()中的绘制同时进行
+        portENTER_CRITICAL(&modeMux);
+        int mode = pendingMode;
+        pendingMode = -1;
+        portEXIT_CRITICAL(&modeMux);
+        if (mode >= 0) {
+            setDisplayMode((DisplayMode)mode);
+        }
+
+        // 先把影子帧缓冲的改动区域转换到DMA位平面（未启用时不做任何事）
+        {
+            PROFILE_SCOPE(PROF_COMMIT);
+            dma_display->commit();
+        }
+        // 没有改动的行时不会翻页；单缓冲模式下直接返回
+        {
+            PROFILE_SCOPE(PROF_FLIP);
+            dma_display->presentIncremental();
+        }
+    }
+}
+
 void DisplayManager::setLedBrightness(int value) {
     currentBrightness = value;
     if (dma_display != nullptr) {
-        dma_display->setBrightness8(value);
+        // 只改动OE位，不影响画面内容；配置了渐变时长才由刷新中断平滑过渡（启动前直接生效）
+        if (LED_BRIGHTNESS_FADE_MS > 0) {
+            dma_display->fadeTo(value, LED_BRIGHTNESS_FADE_MS);
+        } else {
+            dma_display->setBrightness8(value);
+        }
     }
 }
 
 void DisplayManager::setRefreshRate(int refreshRate) {
     if (dma_display != nullptr) {
         // 刷新率范围检查  
-        // todo 双缓冲解决闪烁
         if (refreshRate < LED_MIN_REFRESH_RATE) refreshRate = LED_MIN_REFRESH_RATE;   // 最低刷新率，避免明显闪烁
         if (refreshRate > LED_MAX_REFRESH_RATE) refreshRate = LED_MAX_REFRESH_RATE;   // 最高刷新率，避免过高功耗
         
         ::printInfo("setRefreshRate", ("设置刷新频率: " + String(refreshRate) + "Hz").c_str());
         
-        // 计算需要的I2S时钟频率
-        // 刷新率 = I2S时钟频率 / (像素数 * 颜色深度 * 行数)
-        // 对于64x32的屏幕，每行64像素，32行，16位颜色深度
-        int totalPixels = PANEL_RES_X * PANEL_RES_Y * PANEL_CHAIN;
-        int colorDepth = 16; // 16位颜色
-        int rows = PANEL_RES_Y;
-        
-        // 计算所需的I2S时钟频率
-        unsigned long requiredClock = (unsigned long)refreshRate * totalPixels * colorDepth * rows;
+        // 由驱动重新计算I2S时钟分频、lsbMsbTransitionBit并重新链接DMA描述符
+        // 刷新率越高闪烁越少，但占用更多DMA总线带宽，超出启动时的档位还会损失低位色深
+        int actualRate = dma_display->setRefreshRate(refreshRate);
         
-        ::printInfo("setRefreshRate", ("计算所需时钟频率: " + String(requiredClock) + "Hz").c_str());
-        
-        // 注意：实际的I2S时钟频率设置需要在库层面实现
-        // 这里只是计算和记录，实际控制需要修改库代码
+        ::printInfo("setRefreshRate", ("实际刷新频率: " + String(actualRate) + "Hz").c_str());
+    }
+}
+
+void DisplayManager::requestDisplayMode(DisplayMode mode) {
+    // 没有影子帧缓冲时BLE回调已经画进DMA缓冲区的内容会被切换清掉，保持当前色深
+    if (dma_display == nullptr || !dma_display->hasShadowBuffer()) {
+        return;
     }
+    portENTER_CRITICAL(&modeMux);
+    pendingMode = mode;
+    portEXIT_CRITICAL(&modeMux);
+}
+
+void DisplayManager::setDisplayMode(DisplayMode mode) {
+    // 直接切换的模式优先于尚未执行的请求
+    portENTER_CRITICAL(&modeMux);
+    pendingMode = -1;
+    portEXIT_CRITICAL(&modeMux);
+
+    if (dma_display == nullptr || mode == currentMode) {
+        return;
+    }
+    currentMode = mode;
+
+    int depth;
+    switch (mode) {
+        case MODE_MONO: depth = LED_COLOR_DEPTH_MONO; break;
+        case MODE_TEXT: depth = LED_COLOR_DEPTH_TEXT; break;
+        default:        depth = LED_COLOR_DEPTH_GIF;  break;
+    }
+
+    // 默认只重新链接DMA描述符；开启 LED_COLOR_DEPTH_RESIZE 且有影子帧缓冲时按色深重新分配DMA缓冲区
+    // （升色深内存不够时会少几位，一点都分配不到时面板停止输出）；
+    // 切换后DMA缓冲区都被清空，影子帧缓冲在本轮 present() 中整屏重新提交，没有时由调用方重新绘制
+    int actualDepth = dma_display->setColorDepth(depth, LED_COLOR_DEPTH_RESIZE && dma_display->hasShadowBuffer());
+    if (actualDepth == 0) {
+        ::printError("setDisplayMode", "DMA内存不足，无法分配显示缓冲区");
+        return;
+    }
+
+    // 低色深的GIF渐变靠时间抖动补足，文本和单色图像不需要
+    dma_display->setDither(LED_TEMPORAL_DITHER && mode == MODE_GIF);
+
+    ::printInfo("setDisplayMode", ("色深: " + String(actualDepth) + "位, 刷新频率: " + String(dma_display->calculated_refresh_rate) +
+                "Hz, DMA内存: " + String(dma_display->getDMAArena().reserved()) + " 字节").c_str());
 }
 
 void DisplayManager::setTextSize(int size) {
@@ -163,6 +254,7 @@ void DisplayManager::displayText(char *textContent, bool isScroll) {
         } else {
             dma_display->setCursor(0, 0);
             dma_display->setTextWrap(true);
+            PROFILE_SCOPE(PROF_PRINT_UTF8);
             dma_display->printlnUTF8(textContent);
         }
     }
@@ -176,16 +268,8 @@ void DisplayManager::displayGIF(char *fileName) {
 
 int DisplayManager::getCurrentRefreshRate() const {
     if (dma_display != nullptr) {
-        // 计算当前刷新率
-        int totalPixels = PANEL_RES_X * PANEL_RES_Y * PANEL_CHAIN;
-        int colorDepth = 16; // 16位颜色
-        int rows = PANEL_RES_Y;
-        
-        // 假设默认I2S时钟频率为10MHz (库默认值)
-        unsigned long defaultClock = 10000000; // 10MHz
-        int refreshRate = defaultClock / (totalPixels * colorDepth * rows);
-        
-        return refreshRate;
+        // 根据DMA帧结束中断计数测得的实际刷新率：一次调用开始计数，隔至少半秒的下一次调用得到结果，之前返回计算值
+        return dma_display->getRefreshRate();
     }
     return 0;
 }
@@ -6,9 +6,22 @@
 #include "ESP32-HUB75-MatrixPanel-I2S-DMA.h"
 
 class DisplayManager {
+public:
+    // 显示模式，决定DMA链中使用的色深
+    enum DisplayMode {
+        MODE_TEXT,   // 文本、时钟
+        MODE_MONO,   // 单色图像
+        MODE_GIF     // GIF动画
+    };
+
 private:
     MatrixPanel_I2S_DMA* dma_display;
     int currentBrightness;
+    DisplayMode currentMode;
+
+    // BLE回调请求的显示模式，由loop()中的present()切换（-1表示没有请求）
+    int pendingMode;
+    portMUX_TYPE modeMux = portMUX_INITIALIZER_UNLOCKED;
     
 public:
     DisplayManager();
@@ -20,8 +33,11 @@ public:
     
     // 显示控制
     void clear();
+    void present();  // 提交本轮绘制（先切换请求的显示模式，影子缓冲转换到DMA，双缓冲时翻页并只同步改动的行）
     void setLedBrightness(int value);
     void setRefreshRate(int refreshRate);
+    void setDisplayMode(DisplayMode mode);      // 立即切换色深并清空DMA缓冲区，只能在loop()所在任务调用
+    void requestDisplayMode(DisplayMode mode);  // 供BLE回调使用，在下一次 present() 时切换
     void setTextSize(int size);
     void setTextColor(uint16_t color);
     void setTextWrap(bool wrap);
@@ -33,6 +49,7 @@ public:
     // 状态查询
     int getCurrentBrightness() const { return currentBrightness; }
     int getCurrentRefreshRate() const;
+    DisplayMode getDisplayMode() const { return currentMode; }
     MatrixPanel_I2S_DMA* getDisplay() const { return dma_display; }
     
     // 文件系统相关
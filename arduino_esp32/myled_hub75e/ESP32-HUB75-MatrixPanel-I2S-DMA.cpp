@@ -67,14 +67,14 @@
 
 
 // macro's to calculate sizes of a single buffer (double buffer takes twice as this)
-#define rowBitStructBuffSize        sizeof(ESP32_I2S_DMA_STORAGE_TYPE) * (PIXELS_PER_ROW + CLKS_DURING_LATCH) * PIXEL_COLOR_DEPTH_BITS
+#define rowBitStructBuffSize        sizeof(ESP32_I2S_DMA_STORAGE_TYPE) * (PIXELS_PER_ROW + CLKS_DURING_LATCH) * dma_planes
 #define frameStructBuffSize         ROWS_PER_FRAME * rowBitStructBuffSize
 
 /* this replicates same function in rowBitStruct, but due to induced inlining it might be MUCH faster when used in tight loops
  * while method from struct could be flushed out of instruction cache between loop cycles
  * do NOT forget about buff_id param if using this
  */
-#define getRowDataPtr(row, _dpth, buff_id) &(dma_buff.rowBits[row]->data[_dpth * dma_buff.rowBits[row]->width + buff_id*(dma_buff.rowBits[row]->width * dma_buff.rowBits[row]->color_depth)])
+#define getRowDataPtr(row, _dpth, buff_id) &(dma_buff.rowBits[row]->data[(_dpth - dma_buff.rowBits[row]->first_plane) * dma_buff.rowBits[row]->width + buff_id*(dma_buff.rowBits[row]->width * dma_buff.rowBits[row]->color_depth)])
 
 bool MatrixPanel_I2S_DMA::allocateDMAmemory()
 {
@@ -84,7 +84,7 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
     *         and do some pre-checks.
     */
 
-    int    _num_frame_buffers                   = (m_cfg.double_buff) ? 2:1;
+    int    _num_frame_buffers                   = frameBuffers();
     size_t _frame_buffer_memory_required        = frameStructBuffSize * _num_frame_buffers; 
     size_t _dma_linked_list_memory_required     = 0; 
     size_t _total_dma_capable_memory_reserved   = 0;   
@@ -94,7 +94,9 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
         Serial.printf_P(PSTR("Panel Width: %d pixels.\r\n"),  PIXELS_PER_ROW);
         Serial.printf_P(PSTR("Panel Height: %d pixels.\r\n"), m_cfg.mx_height);
 
-        if (m_cfg.double_buff) {
+        if (m_cfg.triple_buff) {
+          Serial.println(F("TRIPLE FRAME BUFFERS / TRIPLE BUFFERING IS ENABLED. TRIPLE THE RAM REQUIRED!"));
+        } else if (m_cfg.double_buff) {
           Serial.println(F("DOUBLE FRAME BUFFERS / DOUBLE BUFFERING IS ENABLED. DOUBLE THE RAM REQUIRED!"));
         }
         
@@ -118,30 +120,59 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
       return false;
     }
     
-    // Alright, theoretically we should be OK, so let us do this, so
-    // lets allocate a chunk of memory for each row (a row could span multiple panels if chaining is in place)
+    // Alright, theoretically we should be OK, so let us do this. Rather than a malloc per row (a row could
+    // span multiple panels if chaining is in place), pack as many whole rows as fit into the largest free
+    // DMA block, then the next largest, and so on. A row never straddles two blocks.
+  const size_t _row_bytes = rowBitStructBuffSize * _num_frame_buffers;
+
+  dma_buff.rowStore.reserve(ROWS_PER_FRAME);
   dma_buff.rowBits.reserve(ROWS_PER_FRAME);
 
-  // iterate through number of rows
-    for (int malloc_num =0; malloc_num < ROWS_PER_FRAME; ++malloc_num)
-    {
-    auto ptr = std::make_shared<rowBitStruct>(PIXELS_PER_ROW, PIXEL_COLOR_DEPTH_BITS, m_cfg.double_buff);
+  int _rows_left = ROWS_PER_FRAME;
+  while (_rows_left > 0)
+  {
+    const size_t _largest = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+    int fit = _largest / _row_bytes;
+    // the rest of the largest block only counts as lost when it held back a row
+    size_t _lost = _largest - fit * _row_bytes;
+    if (fit > _rows_left) {
+      fit = _rows_left;
+      _lost = 0;
+    }
 
-    if (ptr->data == nullptr){
+    // keep one block slot spare for the DMA descriptors. The largest block can shrink or get split between
+    // the query and the malloc (another task, heap overhead), so settle for fewer rows before giving up
+    if (dma_arena.blocks >= DMA_ARENA_MAX_BLOCKS - 1)
+      fit = 0;
+    while (fit > 0 && !dma_arena.grow(fit * _row_bytes, _lost)) {
+      --fit;
+      _lost = 0;
+    }
+
+    if (fit == 0) {
       #if SERIAL_DEBUG
-              Serial.printf_P(PSTR("ERROR: Couldn't malloc rowBitStruct %d! Critical fail.\r\n"), malloc_num);
+              Serial.printf_P(PSTR("ERROR: Couldn't fit frame rows %d to %d into a DMA block! Critical fail.\r\n"), ROWS_PER_FRAME - _rows_left, ROWS_PER_FRAME - 1);
       #endif
-                return false;
-          // TODO: should we release all previous rowBitStructs here???
+      releaseDMAmemory();
+      return false;
     }
 
-    dma_buff.rowBits.emplace_back(ptr);     // save new rowBitStruct into rows vector
-    ++dma_buff.rows;
     #if SERIAL_DEBUG
-        Serial.printf_P(PSTR("Malloc'ing %d bytes of memory @ address %ud for frame row %d.\r\n"), ptr->size()*_num_frame_buffers, (unsigned int)ptr->getDataPtr(), malloc_num);
-     #endif
+        Serial.printf_P(PSTR("DMA arena block %d: %d bytes @ address %ud for frame rows %d to %d.\r\n"), dma_arena.blocks - 1, fit * _row_bytes, (unsigned int)dma_arena.block[dma_arena.blocks - 1], ROWS_PER_FRAME - _rows_left, ROWS_PER_FRAME - _rows_left + fit - 1);
+    #endif
 
+    for (; fit > 0; --fit, --_rows_left)
+    {
+      auto data = (ESP32_I2S_DMA_STORAGE_TYPE *)dma_arena.carve(_row_bytes);
+      dma_buff.rowStore.emplace_back(PIXELS_PER_ROW, dma_planes, _num_frame_buffers, data);
+      ++dma_buff.rows;
     }
+  }
+
+  // rowStore won't grow any more, so pointers into it stay valid
+  for (auto &row : dma_buff.rowStore)
+    dma_buff.rowBits.push_back(&row);
+  dma_rows = dma_buff.rowStore.data();
 
     _total_dma_capable_memory_reserved += _frame_buffer_memory_required;    
 
@@ -153,9 +184,9 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
    
 
     // Calculate what colour depth is actually possible based on memory available vs. required DMA linked-list descriptors.
-    // aka. Calculate the lowest LSBMSB_TRANSITION_BIT value that will fit in memory
+    // aka. Calculate the lowest LSBMSB_TRANSITION_BIT value that will fit in memory. Planes that aren't stored can't be it
     int numDMAdescriptorsPerRow = 0;
-    lsbMsbTransitionBit = 0;
+    lsbMsbTransitionBit = firstStoredPlane();
     
 
     while(1) {
@@ -191,7 +222,7 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
         int nsPerLatch = ((PIXELS_PER_ROW + CLKS_DURING_LATCH) * psPerClock) / 1000;
 
         // add time to shift out LSBs + LSB-MSB transition bit - this ignores fractions...
-        int nsPerRow = PIXEL_COLOR_DEPTH_BITS * nsPerLatch;
+        int nsPerRow = dma_planes * nsPerLatch;
 
         // add time to shift out MSBs
         for(int i=lsbMsbTransitionBit + 1; i<PIXEL_COLOR_DEPTH_BITS; i++)
@@ -237,10 +268,10 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
     if ( rowBitStructBuffSize > DMA_MAX ) {
 
         #if SERIAL_DEBUG  
-          Serial.printf_P(PSTR("rowColorDepthStruct struct is too large, split DMA payload required. Adding %d DMA descriptors\n"), PIXEL_COLOR_DEPTH_BITS-1);
+          Serial.printf_P(PSTR("rowColorDepthStruct struct is too large, split DMA payload required. Adding %d DMA descriptors\n"), dma_planes-1);
             #endif
 
-        numDMAdescriptorsPerRow += PIXEL_COLOR_DEPTH_BITS-1; 
+        numDMAdescriptorsPerRow += dma_planes-1; 
         // Note: If numDMAdescriptorsPerRow is even just one descriptor too large, DMA linked list will not correctly loop.
     }
 
@@ -261,39 +292,35 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
 #if SERIAL_DEBUG            
        Serial.println(F("ERROR: Not enough SRAM left over for DMA linked-list descriptor memory reservation! Oh so close!\r\n"));
 #endif  
+        releaseDMAmemory();
         return false;
     } // linked list descriptors memory check
 
     // malloc the DMA linked list descriptors that i2s_parallel will need
     desccount = numDMAdescriptorsPerRow * ROWS_PER_FRAME;
+    lsbMsbTransitionBitMin = lsbMsbTransitionBit;   // setRefreshRate() can only re-link with as many descriptors or less
 
-    //lldesc_t * dmadesc_a = (lldesc_t *)heap_caps_malloc(desccount * sizeof(lldesc_t), MALLOC_CAP_DMA);
-    dmadesc_a = (lldesc_t *)heap_caps_malloc(desccount * sizeof(lldesc_t), MALLOC_CAP_DMA);
-    assert("Can't allocate descriptor framebuffer a");
-    if(!dmadesc_a) {
+    // all descriptor lists go into one block, back to back
+    const size_t _desc_bytes = desccount * sizeof(lldesc_t);
+    if (!dma_arena.grow(_desc_bytes * _num_frame_buffers)) {
 #if SERIAL_DEBUG            
-        Serial.println(F("ERROR: Could not malloc descriptor framebuffer a."));
+        Serial.println(F("ERROR: Could not malloc DMA descriptor block."));
 #endif      
+        releaseDMAmemory();
         return false;
     }
-    
+
+    dmadesc_a = (lldesc_t *)dma_arena.carve(_desc_bytes);
     if (m_cfg.double_buff) // reserve space for second framebuffer linked list
-    {
-        //lldesc_t * dmadesc_b = (lldesc_t *)heap_caps_malloc(desccount * sizeof(lldesc_t), MALLOC_CAP_DMA);
-        dmadesc_b = (lldesc_t *)heap_caps_malloc(desccount * sizeof(lldesc_t), MALLOC_CAP_DMA);
-        assert("Could not malloc descriptor framebuffer b.");
-        if(!dmadesc_b) {
-#if SERIAL_DEBUG                
-            Serial.println(F("ERROR: Could not malloc descriptor framebuffer b."));
-#endif          
-            return false;
-        }
-    }
+        dmadesc_b = (lldesc_t *)dma_arena.carve(_desc_bytes);
+    if (m_cfg.triple_buff) // and the third
+        dmadesc_c = (lldesc_t *)dma_arena.carve(_desc_bytes);
 
 #if SERIAL_DEBUG     
     Serial.println(F("*** ESP32-HUB75-MatrixPanel-I2S-DMA: Memory Allocations Complete ***"));
     Serial.printf_P(PSTR("Total memory that was reserved: %d kB.\r\n"), _total_dma_capable_memory_reserved/1024);
     Serial.printf_P(PSTR("... of which was used for the DMA Linked List(s): %d kB.\r\n"), _dma_linked_list_memory_required/1024);
+    Serial.printf_P(PSTR("DMA arena: %d blocks, %d bytes reserved, %d bytes used, %d bytes wasted.\r\n"), dma_arena.blocks, dma_arena.reserved(), dma_arena.used(), dma_arena.wasted());
     
     Serial.printf_P(PSTR("Heap Memory Available: %d bytes total. Largest free block: %d bytes.\r\n"), heap_caps_get_free_size(0), heap_caps_get_largest_free_block(0));
     Serial.printf_P(PSTR("General RAM Available: %d bytes total. Largest free block: %d bytes.\r\n"), heap_caps_get_free_size(MALLOC_CAP_DEFAULT), heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
@@ -306,26 +333,51 @@ bool MatrixPanel_I2S_DMA::allocateDMAmemory()
 
 } // end allocateDMAmemory()
 
+void MatrixPanel_I2S_DMA::releaseDMAmemory()
+{
+    dma_rows = nullptr;
+    dma_buff.rowBits.clear();
+    dma_buff.rowStore.clear();
+    dma_buff.rows = 0;
+    dmadesc_a = nullptr;
+    dmadesc_b = nullptr;
+    dmadesc_c = nullptr;
+    dma_arena.release();
+}
 
 
-void MatrixPanel_I2S_DMA::configureDMA(const HUB75_I2S_CFG& _cfg)
+
+/**
+ * @brief - link up the DMA descriptor chain(s) for the current lsbMsbTransitionBit
+ * Every row is sent once for all colour depth planes, then the planes above lsbMsbTransitionBit are
+ * repeated in binary time division. desccount must already hold the number of descriptors this needs.
+ */
+void MatrixPanel_I2S_DMA::linkDMAchains()
 {
-    #if SERIAL_DEBUG  
-      Serial.println(F("configureDMA(): Starting configuration of DMA engine.\r\n"));
-    #endif   
+    lldesc_t *previous_dmadesc[3]    = {0, 0, 0};
+    int current_dmadescriptor_offset = 0;
 
+    // one chain per buffer, all linked the same way
+    const uint8_t _buffers = frameBuffers();
+    auto link_all = [&](int row, uint8_t cd, size_t size) {
+        for (uint8_t _buff_id = 0; _buff_id < _buffers; _buff_id++) {
+          lldesc_t *chain = dmaChain(_buff_id);
+          link_dma_desc(&chain[current_dmadescriptor_offset], previous_dmadesc[_buff_id], dma_buff.rowBits[row]->getDataPtr(cd, _buff_id), size);
+          previous_dmadesc[_buff_id] = &chain[current_dmadescriptor_offset];
+        }
+        current_dmadescriptor_offset++;
+    };
 
-    lldesc_t *previous_dmadesc_a     = 0;
-    lldesc_t *previous_dmadesc_b     = 0;
-    int current_dmadescriptor_offset = 0;
+    // with a reduced colour depth only the planes from first_coloridx up to the MSB are linked
+    const uint8_t first_coloridx = firstColorPlane();
 
     // HACK: If we need to split the payload in 1/2 so that it doesn't breach DMA_MAX, lets do it by the color_depth.
-    int num_dma_payload_color_depths = PIXEL_COLOR_DEPTH_BITS;
+    int num_dma_payload_color_depths = active_color_depth;
     if ( rowBitStructBuffSize > DMA_MAX ) {
         num_dma_payload_color_depths = 1;
     }
 
-    // Fill DMA linked lists for both frames (as in, halves of the HUB75 panel) and if double buffering is enabled, link it up for both buffers.
+    // Fill DMA linked lists for both frames (as in, halves of the HUB75 panel) and if double/triple buffering is enabled, link it up for every buffer.
     for(int row = 0; row < ROWS_PER_FRAME; row++) {
 
         #if SERIAL_DEBUG          
@@ -335,34 +387,20 @@ void MatrixPanel_I2S_DMA::configureDMA(const HUB75_I2S_CFG& _cfg)
         
         // first set of data is LSB through MSB, single pass (IF TOTAL SIZE < DMA_MAX) - all color bits are displayed once, which takes care of everything below and including LSBMSB_TRANSITION_BIT
         // NOTE: size must be less than DMA_MAX - worst case for library: 16-bpp with 256 pixels per row would exceed this, need to break into two
-        link_dma_desc(&dmadesc_a[current_dmadescriptor_offset], previous_dmadesc_a, dma_buff.rowBits[row]->getDataPtr(), dma_buff.rowBits[row]->size(num_dma_payload_color_depths));
-          previous_dmadesc_a = &dmadesc_a[current_dmadescriptor_offset];
-
-        if (m_cfg.double_buff) {
-          link_dma_desc(&dmadesc_b[current_dmadescriptor_offset], previous_dmadesc_b, dma_buff.rowBits[row]->getDataPtr(0, 1), dma_buff.rowBits[row]->size(num_dma_payload_color_depths));
-          previous_dmadesc_b = &dmadesc_b[current_dmadescriptor_offset]; }
-
-        current_dmadescriptor_offset++;
+        link_all(row, first_coloridx, dma_buff.rowBits[row]->size(num_dma_payload_color_depths));
 
         // If the number of pixels per row is too great for the size of a DMA payload, so we need to split what we were going to send above.
         if ( rowBitStructBuffSize > DMA_MAX )
         {
           #if SERIAL_DEBUG     
-              Serial.printf_P(PSTR("Splitting DMA payload for %d color depths into %d byte payloads.\r\n"), PIXEL_COLOR_DEPTH_BITS-1, rowBitStructBuffSize/PIXEL_COLOR_DEPTH_BITS );
+              Serial.printf_P(PSTR("Splitting DMA payload for %d color depths into %d byte payloads.\r\n"), active_color_depth-1, rowBitStructBuffSize/dma_planes );
           #endif
           
-          for (int cd = 1; cd < PIXEL_COLOR_DEPTH_BITS; cd++) 
+          for (int cd = first_coloridx + 1; cd < PIXEL_COLOR_DEPTH_BITS; cd++) 
           {
             // first set of data is LSB through MSB, single pass - all color bits are displayed once, which takes care of everything below and including LSBMSB_TRANSITION_BIT
             // TODO: size must be less than DMA_MAX - worst case for library: 16-bpp with 256 pixels per row would exceed this, need to break into two
-            link_dma_desc(&dmadesc_a[current_dmadescriptor_offset], previous_dmadesc_a, dma_buff.rowBits[row]->getDataPtr(cd, 0), dma_buff.rowBits[row]->size(num_dma_payload_color_depths) );
-            previous_dmadesc_a = &dmadesc_a[current_dmadescriptor_offset];
-
-            if (m_cfg.double_buff) {
-              link_dma_desc(&dmadesc_b[current_dmadescriptor_offset], previous_dmadesc_b, dma_buff.rowBits[row]->getDataPtr(cd, 1), dma_buff.rowBits[row]->size(num_dma_payload_color_depths));
-              previous_dmadesc_b = &dmadesc_b[current_dmadescriptor_offset]; }
-
-            current_dmadescriptor_offset++;     
+            link_all(row, cd, dma_buff.rowBits[row]->size(num_dma_payload_color_depths));
 
           } // additional linked list items           
         }  // row depth struct
@@ -375,20 +413,12 @@ void MatrixPanel_I2S_DMA::configureDMA(const HUB75_I2S_CFG& _cfg)
             // we need 2^(i - LSBMSB_TRANSITION_BIT - 1) == 1 << (i - LSBMSB_TRANSITION_BIT - 1) passes from i to MSB
 
           #if SERIAL_DEBUG  
-            Serial.printf_P(PSTR("configureDMA(): DMA Loops for PIXEL_COLOR_DEPTH_BITS %d is: %d.\r\n"), i, (1<<(i - lsbMsbTransitionBit - 1)));
+            Serial.printf_P(PSTR("linkDMAchains(): DMA Loops for PIXEL_COLOR_DEPTH_BITS %d is: %d.\r\n"), i, (1<<(i - lsbMsbTransitionBit - 1)));
           #endif  
 
             for(int k=0; k < (1<<(i - lsbMsbTransitionBit - 1)); k++) 
             {
-                link_dma_desc(&dmadesc_a[current_dmadescriptor_offset], previous_dmadesc_a, dma_buff.rowBits[row]->getDataPtr(i, 0), dma_buff.rowBits[row]->size(PIXEL_COLOR_DEPTH_BITS - i) );
-                previous_dmadesc_a = &dmadesc_a[current_dmadescriptor_offset];
-
-                if (m_cfg.double_buff) {
-                  link_dma_desc(&dmadesc_b[current_dmadescriptor_offset], previous_dmadesc_b, dma_buff.rowBits[row]->getDataPtr(i, 1), dma_buff.rowBits[row]->size(PIXEL_COLOR_DEPTH_BITS - i) );
-                  previous_dmadesc_b = &dmadesc_b[current_dmadescriptor_offset];
-                }
-        
-                current_dmadescriptor_offset++;
+                link_all(row, i, dma_buff.rowBits[row]->size(PIXEL_COLOR_DEPTH_BITS - i));
 
             } // end color depth ^ 2 linked list
         } // end color depth loop
@@ -396,25 +426,36 @@ void MatrixPanel_I2S_DMA::configureDMA(const HUB75_I2S_CFG& _cfg)
     } // end frame rows
 
    #if SERIAL_DEBUG  
-      Serial.printf_P(PSTR("configureDMA(): Configured LL structure. %d DMA Linked List descriptors populated.\r\n"), current_dmadescriptor_offset);
+      Serial.printf_P(PSTR("linkDMAchains(): Configured LL structure. %d DMA Linked List descriptors populated.\r\n"), current_dmadescriptor_offset);
       
       if ( desccount != current_dmadescriptor_offset)
       {
-        Serial.printf_P(PSTR("configureDMA(): ERROR! Expected descriptor count of %d != actual DMA descriptors of %d!\r\n"), desccount, current_dmadescriptor_offset);        
+        Serial.printf_P(PSTR("linkDMAchains(): ERROR! Expected descriptor count of %d != actual DMA descriptors of %d!\r\n"), desccount, current_dmadescriptor_offset);        
       }
     #endif  
 
     //End markers for DMA LL
-    dmadesc_a[desccount-1].eof = 1;
-    dmadesc_a[desccount-1].qe.stqe_next=(lldesc_t*)&dmadesc_a[0];
+    for (uint8_t _buff_id = 0; _buff_id < _buffers; _buff_id++) {
+      lldesc_t *chain = dmaChain(_buff_id);
+      chain[desccount-1].eof = 1;
+      chain[desccount-1].qe.stqe_next=(lldesc_t*)&chain[0];
+    }
 
-    if (m_cfg.double_buff) {    
-      dmadesc_b[desccount-1].eof = 1;
-      dmadesc_b[desccount-1].qe.stqe_next=(lldesc_t*)&dmadesc_b[0]; 
-    } else {
+    if (!m_cfg.double_buff) {
       dmadesc_b = dmadesc_a; // link to same 'a' buffer
     }
 
+} // end linkDMAchains
+
+
+void MatrixPanel_I2S_DMA::configureDMA(const HUB75_I2S_CFG& _cfg)
+{
+    #if SERIAL_DEBUG  
+      Serial.println(F("configureDMA(): Starting configuration of DMA engine.\r\n"));
+    #endif   
+
+    linkDMAchains();
+
 #if SERIAL_DEBUG
     Serial.println(F("Performing I2S setup:"));
 #endif
@@ -429,11 +470,12 @@ void MatrixPanel_I2S_DMA::configureDMA(const HUB75_I2S_CFG& _cfg)
         .desccount_b=desccount,
         .lldesc_b=dmadesc_b,
         .clkphase=_cfg.clkphase,
-        .int_ena_out_eof=_cfg.double_buff
+        .int_ena_out_eof=true           // vsync and buffer flipping, only enabled while waited on or hooked
     };
     
     // Setup I2S
     i2s_parallel_driver_install(ESP32_I2S_DEVICE, &dma_cfg);
+    i2s_clock_hz = _cfg.i2sspeed;
     i2s_parallel_send_dma(ESP32_I2S_DEVICE, &dmadesc_a[0]);
 
     #if SERIAL_DEBUG  
@@ -476,16 +518,20 @@ void IRAM_ATTR MatrixPanel_I2S_DMA::updateMatrixDMABuffer(int16_t x_coord, int16
     return;
   }
 
-  /* LED Brightness Compensation. Because if we do a basic "red & mask" for example, 
+  // drawing goes to the shadow framebuffer, commit() does the rest
+  if (shadow_buff) {
+    shadow_buff[y_coord * PIXELS_PER_ROW + x_coord] = color565(red, green, blue);
+    markShadowDirty(x_coord, y_coord, 1, 1);
+    return;
+  }
+
+  /* LED Brightness Compensation. Because if we do a basic "red & mask" for example,
      * we'll NEVER send the dimmest possible colour, due to binary skew.
      * i.e. It's almost impossible for color_depth_idx of 0 to be sent out to the MATRIX unless the 'value' of a color is exactly '1'
    * https://ledshield.wordpress.com/2012/11/13/led-brightness-to-your-eye-gamma-correction-no/
+   * The gamma curve is folded into the colour plane lookup tables, so this is three table reads for all planes.
      */
-#ifndef NO_CIE1931
-    red   = lumConvTab[red];
-    green = lumConvTab[green];
-    blue  = lumConvTab[blue];   
-#endif
+    const uint32_t planebits = colorPlaneBits(red, green, blue);
 
     /* When using the drawPixel, we are obviously only changing the value of one x,y position, 
      * however, the two-scan panels paint TWO lines at the same time
@@ -515,25 +561,17 @@ void IRAM_ATTR MatrixPanel_I2S_DMA::updateMatrixDMABuffer(int16_t x_coord, int16
       y_coord -= ROWS_PER_FRAME;
     }
 
-    // Iterating through colour depth bits, which we assume are 8 bits per RGB subpixel (24bpp)
+    dirty_rows[back_buffer_id] |= 1UL << y_coord;
+
+    // Iterating through colour depth bits, which we assume are 8 bits per RGB subpixel (24bpp), down to the lowest one stored
+    const uint8_t first_plane = firstStoredPlane();
     uint8_t color_depth_idx = PIXEL_COLOR_DEPTH_BITS;
     do {
         --color_depth_idx;
-//        uint8_t mask = (1 << (color_depth_idx COLOR_DEPTH_LESS_THAN_8BIT_ADJUST)); // expect 24 bit color (8 bits per RGB subpixel)
-    #if PIXEL_COLOR_DEPTH_BITS < 8
-        uint8_t mask = (1 << (color_depth_idx+MASK_OFFSET)); // expect 24 bit color (8 bits per RGB subpixel)
-    #else
-        uint8_t mask = (1 << (color_depth_idx)); // expect 24 bit color (8 bits per RGB subpixel)
-    #endif      
-        uint16_t RGB_output_bits = 0;
 
         /* Per the .h file, the order of the output RGB bits is:
           * BIT_B2, BIT_G2, BIT_R2,    BIT_B1, BIT_G1, BIT_R1     */
-        RGB_output_bits |= (bool)(blue & mask);   // --B
-        RGB_output_bits <<= 1;
-        RGB_output_bits |= (bool)(green & mask);  // -BG
-        RGB_output_bits <<= 1;
-        RGB_output_bits |= (bool)(red & mask);    // BGR
+        uint16_t RGB_output_bits = COLOR_PLANE_RGB(planebits, color_depth_idx);   // BGR
         RGB_output_bits <<= _colorbitoffset;      // shift color bits to the required position
 
 
@@ -546,64 +584,438 @@ void IRAM_ATTR MatrixPanel_I2S_DMA::updateMatrixDMABuffer(int16_t x_coord, int16
         p[x_coord] &= _colorbitclear;   // reset RGB bits
         p[x_coord] |= RGB_output_bits;  // set new RGB bits
 
-    } while(color_depth_idx);  // end of color depth loop (8)
+    } while(color_depth_idx > first_plane);  // end of color depth loop (8)
 } // updateMatrixDMABuffer (specific co-ords change)
 
 
-/* Update the entire buffer with a single specific colour - quicker */
-void MatrixPanel_I2S_DMA::updateMatrixDMABuffer(uint8_t red, uint8_t green, uint8_t blue)
+/** @brief - write one pixel of a span, used for the unpaired head/tail pixels of a run
+ *  Same as updateMatrixDMABuffer() but without bounds checks and row lookups, the caller has done that already
+ */
+void IRAM_ATTR MatrixPanel_I2S_DMA::spanPixelDMA(ESP32_I2S_DMA_STORAGE_TYPE *p, size_t plane_stride, int16_t x_coord, uint32_t planebits, uint16_t _colorbitclear, uint8_t _colorbitoffset)
 {
-  if ( !initialized ) return;
-  
-    /* https://ledshield.wordpress.com/2012/11/13/led-brightness-to-your-eye-gamma-correction-no/ */     
-#ifndef NO_CIE1931
-    red     = lumConvTab[red];
-    green   = lumConvTab[green];
-    blue    = lumConvTab[blue];     
+#ifndef ESP32_SXXX
+  // Save the calculated value to the bitplane memory in reverse order to account for I2S Tx FIFO mode1 ordering
+  x_coord & 1U ? --x_coord : ++x_coord;
 #endif
 
-  for(uint8_t color_depth_idx=0; color_depth_idx<PIXEL_COLOR_DEPTH_BITS; color_depth_idx++)  // color depth - 8 iterations
+  // p is the lowest stored plane
+  p += x_coord;
+  planebits >>= firstStoredPlane() * COLOR_PLANE_LUT_BITS;
+  for (uint8_t _plane = 0; _plane < dma_planes; _plane++) {
+    ESP32_I2S_DMA_STORAGE_TYPE &v = p[_plane * plane_stride];
+    v = (v & _colorbitclear) | ((planebits & COLOR_PLANE_RGB_MASK) << _colorbitoffset);
+    planebits >>= COLOR_PLANE_LUT_BITS;
+  }
+}
+
+/** @brief - draw a horizontal run of RGB565 pixels in one pass
+ *  updateMatrixDMABuffer() pays for a bounds check, row lookup, FIFO swap and 8 x 16-bit read-modify-writes per pixel.
+ *  Here the run is clipped once, the row pointer is resolved once, and every aligned pixel pair is written to each
+ *  colour depth plane with a single 32-bit read-modify-write, with the TX FIFO ordering folded into how the pair is packed.
+ */
+void IRAM_ATTR MatrixPanel_I2S_DMA::drawSpanRGB565(int16_t x_coord, int16_t y_coord, const uint16_t *px, int16_t n)
+{
+  if ( !initialized || px == nullptr )
+    return;
+
+  if ( n < 1 || y_coord < 0 || y_coord >= m_cfg.mx_height || x_coord >= PIXELS_PER_ROW )
+    return;
+
+  // clip the run to the panel
+  if (x_coord < 0) {
+    px -= x_coord;
+    n  += x_coord;
+    x_coord = 0;
+  }
+  if (x_coord + n > PIXELS_PER_ROW)
+    n = PIXELS_PER_ROW - x_coord;
+  if (n < 1)
+    return;
+
+  if (shadow_buff) {
+    memcpy(shadow_buff + y_coord * PIXELS_PER_ROW + x_coord, px, n * sizeof(uint16_t));
+    markShadowDirty(x_coord, y_coord, n, 1);
+    return;
+  }
+
+  spanDMA(x_coord, y_coord, px, n);
+} // drawSpanRGB565()
+
+/** @brief - span conversion proper, x_coord/y_coord/n already clipped */
+void IRAM_ATTR MatrixPanel_I2S_DMA::spanDMA(int16_t x_coord, int16_t y_coord, const uint16_t *px, int16_t n, const uint8_t *dither_row)
+{
+  if (dither_row)
+    spanBitsDMA(x_coord, y_coord, n, [this, px, dither_row](int16_t i, int16_t x) -> uint32_t {
+      return colorPlaneBitsDither(px[i], dither_row[x & 3]);
+    });
+  else
+    spanBitsDMA(x_coord, y_coord, n, [this, px](int16_t i, int16_t /*x*/) -> uint32_t {
+      return colorPlaneBits565(px[i]);
+    });
+} // spanDMA()
+
+template <typename PlaneBitsAt>
+void IRAM_ATTR MatrixPanel_I2S_DMA::spanBitsDMA(int16_t x_coord, int16_t y_coord, int16_t n, PlaneBitsAt planeBitsAt)
+{
+  uint16_t _colorbitclear = BITMASK_RGB1_CLEAR;
+  uint8_t  _colorbitoffset = 0;
+
+  if (y_coord >= ROWS_PER_FRAME){    // if we are drawing to the bottom part of the panel
+    _colorbitoffset = BITS_RGB2_OFFSET;
+    _colorbitclear  = BITMASK_RGB2_CLEAR;
+    y_coord -= ROWS_PER_FRAME;
+  }
+
+  dirty_rows[back_buffer_id] |= 1UL << y_coord;
+
+  const size_t plane_stride = dma_buff.rowBits[y_coord]->width;
+  const uint8_t first_plane = firstStoredPlane();
+  ESP32_I2S_DMA_STORAGE_TYPE *p = getRowDataPtr(y_coord, first_plane, back_buffer_id);
+  int16_t i = 0;
+
+  // 32-bit access requires every plane to be word aligned, i.e. an even row width - otherwise go pixel by pixel
+  if (plane_stride & 1U) {
+    for (; i < n; i++, x_coord++)
+      spanPixelDMA(p, plane_stride, x_coord, planeBitsAt(i, x_coord), _colorbitclear, _colorbitoffset);
+    return;
+  }
+
+  // a run starting on an odd pixel has its first pixel in the second half of a word
+  if (x_coord & 1U) {
+    spanPixelDMA(p, plane_stride, x_coord, planeBitsAt(i, x_coord), _colorbitclear, _colorbitoffset);
+    ++i;
+    ++x_coord;
+  }
+
+  const uint32_t _pairbitclear = ((uint32_t)_colorbitclear << 16) | _colorbitclear;
+  const size_t   word_stride   = plane_stride >> 1;
+  uint32_t *w = (uint32_t *)(p + x_coord);
+
+  for (; i + 1 < n; i += 2) {
+    uint32_t planebits0 = planeBitsAt(i, x_coord) >> (first_plane * COLOR_PLANE_LUT_BITS);
+    uint32_t planebits1 = planeBitsAt(i + 1, x_coord + 1) >> (first_plane * COLOR_PLANE_LUT_BITS);
+    x_coord += 2;
+
+    for (uint8_t _plane = 0; _plane < dma_planes; _plane++) {
+    #ifdef ESP32_SXXX
+      // data goes out in memory order, left pixel is the low half-word
+      uint32_t RGB_output_bits = (planebits0 & COLOR_PLANE_RGB_MASK) | ((planebits1 & COLOR_PLANE_RGB_MASK) << 16);
+    #else
+      // I2S Tx FIFO mode1 swaps the half-words of every 32-bit word, so the left pixel is the high half-word
+      uint32_t RGB_output_bits = ((planebits0 & COLOR_PLANE_RGB_MASK) << 16) | (planebits1 & COLOR_PLANE_RGB_MASK);
+    #endif
+      uint32_t &v = w[_plane * word_stride];
+      v = (v & _pairbitclear) | (RGB_output_bits << _colorbitoffset);
+
+      planebits0 >>= COLOR_PLANE_LUT_BITS;
+      planebits1 >>= COLOR_PLANE_LUT_BITS;
+    }
+
+    ++w;
+  }
+
+  // odd pixel left over at the end of the run
+  if (i < n)
+    spanPixelDMA(p, plane_stride, x_coord, planeBitsAt(i, x_coord), _colorbitclear, _colorbitoffset);
+
+} // spanBitsDMA()
+
+void MatrixPanel_I2S_DMA::paletteToPlaneBits(const uint16_t *palette565, uint32_t *planebits, uint16_t count) const
+{
+  for (uint16_t i = 0; i < count; i++)
+    planebits[i] = colorPlaneBits565(palette565[i]);
+}
+
+/** @brief - palette indexed counterpart of drawSpanRGB565(), same clipping */
+void IRAM_ATTR MatrixPanel_I2S_DMA::drawSpanIndexed(int16_t x_coord, int16_t y_coord, const uint8_t *idx, int16_t n, const uint16_t *palette565, const uint32_t *planebits)
+{
+  if ( !initialized || idx == nullptr )
+    return;
+
+  if ( n < 1 || y_coord < 0 || y_coord >= m_cfg.mx_height || x_coord >= PIXELS_PER_ROW )
+    return;
+
+  // clip the run to the panel
+  if (x_coord < 0) {
+    idx -= x_coord;
+    n   += x_coord;
+    x_coord = 0;
+  }
+  if (x_coord + n > PIXELS_PER_ROW)
+    n = PIXELS_PER_ROW - x_coord;
+  if (n < 1)
+    return;
+
+  if (shadow_buff) {
+    uint16_t *d = shadow_buff + y_coord * PIXELS_PER_ROW + x_coord;
+    for (int16_t i = 0; i < n; i++)
+      d[i] = palette565[idx[i]];
+    markShadowDirty(x_coord, y_coord, n, 1);
+    return;
+  }
+
+  spanBitsDMA(x_coord, y_coord, n, [idx, planebits](int16_t i, int16_t /*x*/) -> uint32_t {
+    return planebits[idx[i]];
+  });
+} // drawSpanIndexed()
+
+/** @brief - fill a run of one DMA row with a single colour, 32 bits (a pixel pair) at a time
+ *  Both pixels of a pair get the same bits, so the TX FIFO ordering only matters for an odd pixel at either end of the run.
+ */
+void IRAM_ATTR MatrixPanel_I2S_DMA::fillSpanDMA(int16_t x_coord, int16_t row_idx, int16_t l, uint32_t planebits, uint16_t _colorbitclear, uint8_t _colorspread)
+{
+  dirty_rows[back_buffer_id] |= 1UL << row_idx;
+
+  const size_t plane_stride = dma_buff.rowBits[row_idx]->width;
+  const uint8_t first_plane = firstStoredPlane();
+  ESP32_I2S_DMA_STORAGE_TYPE *p = getRowDataPtr(row_idx, first_plane, back_buffer_id);
+
+  int16_t x_end = x_coord + l;
+
+  // 32-bit access requires every plane to be word aligned, i.e. an even row width - otherwise the whole run goes pixel by pixel
+  const bool _pairs = !(plane_stride & 1U);
+
+  // odd pixel at the start / end of the run, everything in between is whole pairs
+  const int16_t _head = (_pairs && (x_coord & 1U))   ? x_coord   : -1;
+  const int16_t _tail = (_pairs && (x_end & 1U))     ? x_end - 1 : -1;
+  if (_pairs) {
+    x_coord = (x_coord + 1) & ~1;
+    x_end  &= ~1;
+  }
+
+  const uint32_t _pairbitclear = ((uint32_t)_colorbitclear << 16) | _colorbitclear;
+
+  for (uint8_t color_depth_idx = first_plane; color_depth_idx < PIXEL_COLOR_DEPTH_BITS; color_depth_idx++, p += plane_stride)
   {
-    // let's precalculate RGB1 and RGB2 bits than flood it over the entire DMA buffer
-    uint16_t RGB_output_bits = 0;
-//    uint8_t mask = (1 << color_depth_idx COLOR_DEPTH_LESS_THAN_8BIT_ADJUST); // 24 bit color
-    #if PIXEL_COLOR_DEPTH_BITS < 8
-        uint8_t mask = (1 << (color_depth_idx+MASK_OFFSET)); // expect 24 bit color (8 bits per RGB subpixel)
+    // BGR bits copied into the RGB1 and/or RGB2 position
+    const uint16_t RGB_output_bits = COLOR_PLANE_RGB(planebits, color_depth_idx) * _colorspread;
+
+    if (!_pairs) {
+      for (int16_t _x = x_coord; _x < x_end; ++_x) {
+      #ifdef ESP32_SXXX
+        ESP32_I2S_DMA_STORAGE_TYPE &v = p[_x];
+      #else
+        // last pixel of an odd width row has no pair to swap with, don't spill into the next plane
+        ESP32_I2S_DMA_STORAGE_TYPE &v = p[(size_t)(_x ^ 1U) < plane_stride ? _x ^ 1U : _x];
+      #endif
+        v = (v & _colorbitclear) | RGB_output_bits;
+      }
+      continue;
+    }
+
+    if (_head >= 0) {
+    #ifdef ESP32_SXXX
+      ESP32_I2S_DMA_STORAGE_TYPE &v = p[_head];
     #else
-        uint8_t mask = (1 << (color_depth_idx)); // expect 24 bit color (8 bits per RGB subpixel)
-    #endif      
-
-    /* Per the .h file, the order of the output RGB bits is:
-     * BIT_B2, BIT_G2, BIT_R2,    BIT_B1, BIT_G1, BIT_R1      */
-    RGB_output_bits |= (bool)(blue & mask);   // --B
-    RGB_output_bits <<= 1;
-    RGB_output_bits |= (bool)(green & mask);  // -BG
-    RGB_output_bits <<= 1;
-    RGB_output_bits |= (bool)(red & mask);    // BGR
-    
-    // Duplicate and shift across so we have have 6 populated bits of RGB1 and RGB2 pin values suitable for DMA buffer
-    RGB_output_bits |= RGB_output_bits << BITS_RGB2_OFFSET;  //BGRBGR
-    
-    //Serial.printf("Fill with: 0x%#06x\n", RGB_output_bits);
+      ESP32_I2S_DMA_STORAGE_TYPE &v = p[_head ^ 1U];
+    #endif
+      v = (v & _colorbitclear) | RGB_output_bits;
+    }
 
-    // iterate rows
-    int matrix_frame_parallel_row = dma_buff.rowBits.size();
-    do {
-      --matrix_frame_parallel_row;
+    const uint32_t _pairbits = ((uint32_t)RGB_output_bits << 16) | RGB_output_bits;
+    uint32_t *w     = (uint32_t *)(p + x_coord);
+    uint32_t *w_end = (uint32_t *)(p + x_end);
+    while (w < w_end) {
+      *w = (*w & _pairbitclear) | _pairbits;
+      ++w;
+    }
 
-      // The destination for the pixel row bitstream
-      ESP32_I2S_DMA_STORAGE_TYPE *p = getRowDataPtr(matrix_frame_parallel_row, color_depth_idx, back_buffer_id);
+    if (_tail >= 0) {
+    #ifdef ESP32_SXXX
+      ESP32_I2S_DMA_STORAGE_TYPE &v = p[_tail];
+    #else
+      ESP32_I2S_DMA_STORAGE_TYPE &v = p[_tail ^ 1U];
+    #endif
+      v = (v & _colorbitclear) | RGB_output_bits;
+    }
+  }
+} // fillSpanDMA()
 
-      // iterate pixels in a row
-      int x_coord=dma_buff.rowBits[matrix_frame_parallel_row]->width;
-      do { 
-        --x_coord;
-        p[x_coord] &= BITMASK_RGB12_CLEAR;  // reset color bits
-        p[x_coord] |= RGB_output_bits;      // set new color bits
-      } while(x_coord);
+/** @brief - draw a block of RGB565 pixels (row-major, w*h elements), one span per row */
+void MatrixPanel_I2S_DMA::drawRectRGB565(int16_t x_coord, int16_t y_coord, int16_t w, int16_t h, const uint16_t *px)
+{
+  if ( !initialized || px == nullptr || w < 1 || h < 1 )
+    return;
+
+  for (int16_t row = 0; row < h; ++row, px += w)
+    drawSpanRGB565(x_coord, y_coord + row, px, w);
+} // drawRectRGB565()
+
+/** @brief - allocate or free the RGB565 shadow framebuffer, see header */
+bool MatrixPanel_I2S_DMA::setShadowBuffer(bool enable)
+{
+  if ( !enable ) {
+    if (shadow_buff) {
+      heap_caps_free(shadow_buff);
+      shadow_buff = nullptr;
+    }
+    shadow_x0 = shadow_y0 = INT16_MAX;
+    shadow_x1 = shadow_y1 = -1;
+    return false;
+  }
+
+  if (shadow_buff)
+    return true;
+
+  const size_t _shadow_size = (size_t)PIXELS_PER_ROW * m_cfg.mx_height * sizeof(uint16_t);
+
+  // PSRAM if there is any, only the CPU touches this buffer
+  #if SERIAL_DEBUG
+    const char *_shadow_mem = "PSRAM";
+  #endif
+  shadow_buff = (uint16_t *)heap_caps_malloc(_shadow_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!shadow_buff) {
+    #if SERIAL_DEBUG
+      _shadow_mem = "internal RAM";
+    #endif
+    shadow_buff = (uint16_t *)heap_caps_malloc(_shadow_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  }
+
+  if (!shadow_buff) {
+    #if SERIAL_DEBUG
+      Serial.printf_P(PSTR("Could not allocate %d bytes for the RGB565 shadow buffer.\r\n"), _shadow_size);
+    #endif
+    return false;
+  }
+
+  #if SERIAL_DEBUG
+    Serial.printf_P(PSTR("RGB565 shadow buffer: %d bytes in %s.\r\n"), _shadow_size, _shadow_mem);
+  #endif
+
+  memset(shadow_buff, 0, _shadow_size);
+  markShadowAllDirty();
+  return true;
+}
+
+/** @brief - fill a clipped area of the shadow framebuffer with one colour */
+void MatrixPanel_I2S_DMA::shadowFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  uint16_t *row = shadow_buff + y * PIXELS_PER_ROW + x;
+  for (int16_t _h = h; _h; --_h, row += PIXELS_PER_ROW)
+    for (int16_t _x = 0; _x < w; ++_x)
+      row[_x] = color;
+
+  markShadowDirty(x, y, w, h);
+}
+
+/** @brief - gather the R, G, B bits of one pixel from every linked colour plane, see header */
+void MatrixPanel_I2S_DMA::readDMAPixel(int16_t x_coord, int16_t y_coord, uint8_t &r, uint8_t &g, uint8_t &b, const uint8_t _buff_id)
+{
+  r = g = b = 0;
+
+  if ( !initialized || x_coord < 0 || y_coord < 0 || x_coord >= PIXELS_PER_ROW || y_coord >= m_cfg.mx_height )
+    return;
+
+  if (_buff_id >= frameBuffers())
+    return;
+
+  uint8_t _colorbitoffset = 0;
+  if (y_coord >= ROWS_PER_FRAME){    // bottom half of the panel is on RGB2
+    _colorbitoffset = BITS_RGB2_OFFSET;
+    y_coord -= ROWS_PER_FRAME;
+  }
+
+#ifndef ESP32_SXXX
+  // same I2S Tx FIFO mode1 ordering as when the pixel was written
+  x_coord & 1U ? --x_coord : ++x_coord;
+#endif
+
+  rowBitStruct *row = dma_buff.rowBits[y_coord];
+
+  // planes below firstColorPlane() are not sent out
+  for (uint8_t color_depth_idx = firstColorPlane(); color_depth_idx < PIXEL_COLOR_DEPTH_BITS; color_depth_idx++)
+  {
+    const uint8_t bits = (row->getDataPtr(color_depth_idx, _buff_id)[x_coord] >> _colorbitoffset) & COLOR_PLANE_RGB_MASK;
+
+  #if PIXEL_COLOR_DEPTH_BITS < 8
+    const uint8_t mask = (1 << (color_depth_idx+MASK_OFFSET));
+  #else
+    const uint8_t mask = (1 << (color_depth_idx));
+  #endif
+    if (bits & BIT_R1) r |= mask;
+    if (bits & BIT_G1) g |= mask;
+    if (bits & BIT_B1) b |= mask;
+  }
+}
+
+/** @brief - readDMAPixel() for every pixel of a buffer */
+void MatrixPanel_I2S_DMA::readDMAFrame(uint8_t *rgb, const uint8_t _buff_id)
+{
+  if ( rgb == nullptr )
+    return;
+
+  for (int16_t y = 0; y < m_cfg.mx_height; ++y)
+    for (int16_t x = 0; x < PIXELS_PER_ROW; ++x, rgb += 3)
+      readDMAPixel(x, y, rgb[0], rgb[1], rgb[2], _buff_id);
+}
+
+/* 4x4 ordered dither matrix, and the order the 16 steps are added to it from frame to frame (bit reversed, so
+ * consecutive frames are far apart). Every pixel runs through all 16 thresholds once per cycle. */
+static const uint8_t ditherBayer4[4][4] = { { 0,  8,  2, 10}, {12,  4, 14,  6}, { 3, 11,  1,  9}, {15,  7, 13,  5} };
+static const uint8_t ditherSteps[16]    = { 0,  8,  4, 12,  2, 10,  6, 14,  1,  9,  5, 13,  3, 11,  7, 15};
+
+/** @brief - one span conversion per row of the shadow dirty rectangle */
+void MatrixPanel_I2S_DMA::commit()
+{
+  if ( !initialized || !shadow_buff )
+    return;
+
+  const bool _dither = ditherActive();
+
+  // the pattern follows the refresh frame counter, only a new step needs the whole frame again
+  if (_dither) {
+    const uint8_t _phase = getFrameCount() & 15;
+    if (_phase != dither_phase) {
+      dither_phase = _phase;
+      markShadowAllDirty();
+    }
+  }
+
+  // take the rectangle and start a new one in one go, drawing on the other core lands in the next commit()
+  portENTER_CRITICAL(&shadow_mux);
+  const int16_t _x0 = shadow_x0, _y0 = shadow_y0, _x1 = shadow_x1, _y1 = shadow_y1;
+  shadow_x0 = shadow_y0 = INT16_MAX;
+  shadow_x1 = shadow_y1 = -1;
+  portEXIT_CRITICAL(&shadow_mux);
+
+  if ( _x0 > _x1 )
+    return;
+
+  // thresholds span one step of the active colour depth, i.e. the bits that are not linked
+  uint8_t dither_rows[4][4];
+  if (_dither) {
+    const uint8_t _shift = 8 - active_color_depth;
+    for (uint8_t j = 0; j < 4; j++)
+      for (uint8_t i = 0; i < 4; i++)
+        dither_rows[j][i] = (((ditherBayer4[j][i] + ditherSteps[dither_phase]) & 15) << _shift) >> 4;
+  }
+
+  const int16_t n = _x1 - _x0 + 1;
+  const uint16_t *px = shadow_buff + _y0 * PIXELS_PER_ROW + _x0;
+  for (int16_t y = _y0; y <= _y1; ++y, px += PIXELS_PER_ROW)
+    spanDMA(_x0, y, px, n, _dither ? dither_rows[y & 3] : nullptr);
+}
+
+
+/* Update the entire buffer with a single specific colour - quicker */
+void MatrixPanel_I2S_DMA::updateMatrixDMABuffer(uint8_t red, uint8_t green, uint8_t blue)
+{
+  if ( !initialized ) return;
 
-    } while(matrix_frame_parallel_row); // end row iteration
-  } // colour depth loop (8)
+  if (shadow_buff) {
+    shadowFill(0, 0, PIXELS_PER_ROW, m_cfg.mx_height, color565(red, green, blue));
+    return;
+  }
+  
+    /* https://ledshield.wordpress.com/2012/11/13/led-brightness-to-your-eye-gamma-correction-no/ */
+    const uint32_t planebits = colorPlaneBits(red, green, blue);
+
+  // every DMA row carries a row of the top and of the bottom half
+  int row_idx = ROWS_PER_FRAME;
+  do {
+    --row_idx;
+    fillSpanDMA(0, row_idx, PIXELS_PER_ROW, planebits, BITMASK_RGB12_CLEAR, COLOR_SPAN_RGB12);
+  } while(row_idx);
 } // updateMatrixDMABuffer (full frame paint)
 
 /**
@@ -614,53 +1026,54 @@ void MatrixPanel_I2S_DMA::updateMatrixDMABuffer(uint8_t red, uint8_t green, uint
  * This effectively clears buffers to blank BLACK and makes it ready to display output.
  * (Brightness control via OE bit manipulation is another case)
  */
-void MatrixPanel_I2S_DMA::clearFrameBuffer(bool _buff_id){
+void MatrixPanel_I2S_DMA::clearFrameBuffer(uint8_t _buff_id){
   if (!initialized)
     return;
 
+  dirty_rows[_buff_id] = allRowsMask();
+
   // we start with iterating all rows in dma_buff structure
   int row_idx = dma_buff.rowBits.size();
   do {
     --row_idx;
     
-    ESP32_I2S_DMA_STORAGE_TYPE* row = dma_buff.rowBits[row_idx]->getDataPtr(0, _buff_id);   // set pointer to the HEAD of a buffer holding data for the entire matrix row
+    ESP32_I2S_DMA_STORAGE_TYPE* row;
 
-    ESP32_I2S_DMA_STORAGE_TYPE abcde = (ESP32_I2S_DMA_STORAGE_TYPE)row_idx;
-    abcde <<= BITS_ADDR_OFFSET;    // shift row y-coord to match ABCDE bits in vector from 8 to 12
+    // the first colour index sent out for a row is color_index[0] (LSB), or the lowest one still linked when running
+    // with a reduced colour depth, see setColorDepth()
+    const uint8_t first_coloridx = firstColorPlane();
 
-    // get last pixel index in a row of all colordepths
-    int x_pixel = dma_buff.rowBits[row_idx]->width * dma_buff.rowBits[row_idx]->color_depth;
-    //Serial.printf(" from pixel %d, ", x_pixel);
-
-    // fill all x_pixels except color_index[0] (LSB) ones, this also clears all color data to 0's black
+    // fill all x_pixels with the row address, this also clears all color data to 0's black
+    int x_pixel;
+    const uint8_t stored_coloridx = dma_buff.rowBits[row_idx]->first_plane;
+    uint8_t coloridx = PIXEL_COLOR_DEPTH_BITS;
     do {
-      --x_pixel;
-      
-      if ( m_cfg.driver == HUB75_I2S_CFG::SM5266P) {
-        // modifications here for row shift register type SM5266P 
-        // https://github.com/mrfaptastic/ESP32-HUB75-MatrixPanel-I2S-DMA/issues/164
-        row[x_pixel] = abcde & (0x18 << BITS_ADDR_OFFSET); // mask out the bottom 3 bits which are the clk di bk inputs  
-      } else {        
-        row[x_pixel] = abcde;
-      }
-      
-    } while(x_pixel!=dma_buff.rowBits[row_idx]->width);
+      --coloridx;
 
-    // color_index[0] (LSB) x_pixels must be "marked" with a previous's row address, 'cause  it is used to display
-    //  previous row while we pump in LSB's for a new row
-    abcde = ((ESP32_I2S_DMA_STORAGE_TYPE)row_idx-1) << BITS_ADDR_OFFSET;
-    do {
-      --x_pixel;
-      
-      if ( m_cfg.driver == HUB75_I2S_CFG::SM5266P) {
-        // modifications here for row shift register type SM5266P 
-        // https://github.com/mrfaptastic/ESP32-HUB75-MatrixPanel-I2S-DMA/issues/164
-        row[x_pixel] = abcde & (0x18 << BITS_ADDR_OFFSET); // mask out the bottom 3 bits which are the clk di bk inputs  
-      } else {        
-        row[x_pixel] = abcde;
-      }   
-      //row[x_pixel] = abcde;
-    } while(x_pixel);
+      row = dma_buff.rowBits[row_idx]->getDataPtr(coloridx, _buff_id);
+
+      ESP32_I2S_DMA_STORAGE_TYPE abcde = (ESP32_I2S_DMA_STORAGE_TYPE)row_idx;
+      abcde <<= BITS_ADDR_OFFSET;    // shift row y-coord to match ABCDE bits in vector from 8 to 12
+
+      // first color_index x_pixels must be "marked" with a previous's row address, 'cause  it is used to display
+      //  previous row while we pump in LSB's for a new row
+      if (coloridx == first_coloridx)
+        abcde = (ESP32_I2S_DMA_STORAGE_TYPE)(row_idx-1) << BITS_ADDR_OFFSET;
+
+      x_pixel = dma_buff.rowBits[row_idx]->width;
+      do {
+        --x_pixel;
+        
+        if ( m_cfg.driver == HUB75_I2S_CFG::SM5266P) {
+          // modifications here for row shift register type SM5266P 
+          // https://github.com/mrfaptastic/ESP32-HUB75-MatrixPanel-I2S-DMA/issues/164
+          row[x_pixel] = abcde & (0x18 << BITS_ADDR_OFFSET); // mask out the bottom 3 bits which are the clk di bk inputs  
+        } else {        
+          row[x_pixel] = abcde;
+        }
+        
+      } while(x_pixel);
+    } while(coloridx > stored_coloridx);
     
     
     // modifications here for row shift register type SM5266P 
@@ -668,6 +1081,7 @@ void MatrixPanel_I2S_DMA::clearFrameBuffer(bool _buff_id){
     if ( m_cfg.driver == HUB75_I2S_CFG::SM5266P) {  
         uint16_t serialCount;
         uint16_t latch;
+        row = dma_buff.rowBits[row_idx]->getDataPtr(first_coloridx, _buff_id);
         x_pixel = dma_buff.rowBits[row_idx]->width - 16; // come back 8*2 pixels to allow for 8 writes
         serialCount = 8;
         do{
@@ -681,7 +1095,7 @@ void MatrixPanel_I2S_DMA::clearFrameBuffer(bool _buff_id){
 
     // let's set LAT/OE control bits for specific pixels in each color_index subrows
     // Need to consider the original ESP32's (WROOM) DMA TX FIFO reordering of bytes...
-    uint8_t coloridx = dma_buff.rowBits[row_idx]->color_depth;
+    coloridx = PIXEL_COLOR_DEPTH_BITS;
     do {
       --coloridx;
 
@@ -722,7 +1136,7 @@ void MatrixPanel_I2S_DMA::clearFrameBuffer(bool _buff_id){
 
       } while (_blank);
 
-    } while(coloridx);
+    } while(coloridx > stored_coloridx);
 
   } while(row_idx);
 }
@@ -732,15 +1146,11 @@ void MatrixPanel_I2S_DMA::clearFrameBuffer(bool _buff_id){
  * @param brt - brightness level from 0 to row_width
  * @param _buff_id - buffer id to control
  */
-void MatrixPanel_I2S_DMA::brtCtrlOE(int brt, const bool _buff_id){
+void MatrixPanel_I2S_DMA::brtCtrlOE(int brt, const uint8_t _buff_id){
   if (!initialized)
     return;
 
-  if (brt > PIXELS_PER_ROW - (MAX_LAT_BLANKING + 2))   // can't control values larger than (row_width - latch_blanking) to avoid ongoing issues being raised about brightness and ghosting.
-    brt = PIXELS_PER_ROW   - (MAX_LAT_BLANKING + 2);   // +2 for a bit of buffer...
-
-  if (brt < 0)
-    brt = 0;
+  brt = clampBrightness(brt);
 
   // start with iterating all rows in dma_buff structure
   int row_idx = dma_buff.rowBits.size();
@@ -748,62 +1158,193 @@ void MatrixPanel_I2S_DMA::brtCtrlOE(int brt, const bool _buff_id){
     --row_idx;
 
     // let's set OE control bits for specific pixels in each color_index subrows
-    uint8_t coloridx = dma_buff.rowBits[row_idx]->color_depth;
+    uint8_t coloridx = PIXEL_COLOR_DEPTH_BITS;
     do {
       --coloridx;
 
       // switch pointer to a row for a specific color index
       ESP32_I2S_DMA_STORAGE_TYPE* row = dma_buff.rowBits[row_idx]->getDataPtr(coloridx, _buff_id);
 
+      // Brightness control via OE toggle - disable matrix output from this x_coord on
+      const int _threshold = oeThreshold(brt, coloridx);
+
+      // every word is written once with its final OE state, so the panel never sees a half-updated row
       int x_coord = dma_buff.rowBits[row_idx]->width;
       do {
         --x_coord;
-        
-       // clear OE bit for all other pixels
-        row[x_coord] &= BITMASK_OE_CLEAR;       
 
-        // Brightness control via OE toggle - disable matrix output at specified x_coord
-        if((coloridx > lsbMsbTransitionBit || !coloridx) && ((x_coord) >= brt)){
-          row[x_coord] |= BIT_OE; // Disable output after this point.
-          continue;  
-        }
-        // special case for the bits *after* LSB through (lsbMsbTransitionBit) - OE is output after data is shifted, so need to set OE to fractional brightness
-        if(coloridx && coloridx <= lsbMsbTransitionBit) {
-            // divide brightness in half for each bit below lsbMsbTransitionBit
-            int lsbBrightness = brt >> (lsbMsbTransitionBit - coloridx + 1);
-            if((x_coord) >= lsbBrightness) {
-                row[x_coord] |= BIT_OE;  // Disable output after this point.
-                continue;
-            }
-        }
+        // OE is also disabled before/after latch to hide row transition, see oeBlanked()
+        const ESP32_I2S_DMA_STORAGE_TYPE _oe = (x_coord >= _threshold || oeBlanked(x_coord)) ? BIT_OE : 0;
+        row[x_coord] = (row[x_coord] & BITMASK_OE_CLEAR) | _oe;
 
- 
       } while(x_coord);
 
-      // need to disable OE before/after latch to hide row transition
-      // Should be one clock or more before latch, otherwise can get ghosting
-      uint8_t _blank = m_cfg.latch_blanking;
-      do {
-        --_blank;
+    } while(coloridx > dma_buff.rowBits[row_idx]->first_plane);
+  } while(row_idx);
+}
 
-      #ifdef ESP32_SXXX     
-            row[0 + _blank] |= BIT_OE;
-      #else 
-            // Original ESP32 WROOM FIFO Ordering Sucks
-            uint8_t _blank_row_tx_fifo_tmp = 0 + _blank;
-            (_blank_row_tx_fifo_tmp & 1U) ? --_blank_row_tx_fifo_tmp : ++_blank_row_tx_fifo_tmp; 
-            row[_blank_row_tx_fifo_tmp] |= BIT_OE;                  
-      #endif
+/**
+ * @brief - move the OE bits of a buffer from one brightness to another
+ * Only the words between the old and the new OE threshold of every plane change, so a small step
+ * (slider drag, fade) costs a few words per row instead of a rewrite of the whole buffer.
+ * The buffer must be set up for brightness 'from', i.e. by brtCtrlOE() or a previous call.
+ */
+void IRAM_ATTR MatrixPanel_I2S_DMA::brtAdjustOE(int from, int to, const uint8_t _buff_id){
+  from = clampBrightness(from);
+  to   = clampBrightness(to);
+  if (from == to || !dma_rows)
+    return;
 
-        //row[0 + _blank] |= BIT_OE;
-        // no need, has been done already
-        //row[dma_buff.rowBits[row_idx]->width - _blank - 3 ] |= BIT_OE;    // (LAT pulse is (width-2) -1 pixel to compensate array index starting at 0
-      } while (_blank);
+  // raw row structs rather than rowBits / getDataPtr(), nothing here may leave IRAM
+  int row_idx = dma_buff.rows;
+  do {
+    --row_idx;
+
+    const rowBitStruct &_row = dma_rows[row_idx];
+    ESP32_I2S_DMA_STORAGE_TYPE *_buff = _row.data + _buff_id * _row.width * _row.color_depth;
+
+    uint8_t coloridx = PIXEL_COLOR_DEPTH_BITS;
+    do {
+      --coloridx;
 
-    } while(coloridx);
+      const int _old = oeThreshold(from, coloridx);
+      const int _new = oeThreshold(to, coloridx);
+      if (_old == _new)
+        continue;
+
+      ESP32_I2S_DMA_STORAGE_TYPE* row = _buff + (coloridx - _row.first_plane) * _row.width;
+
+      // brighter: enable output up to the new threshold, dimmer: disable it from there on
+      int x_coord = _old < _new ? _old : _new;
+      const int x_end = _old < _new ? _new : _old;
+      for (; x_coord < x_end; ++x_coord) {
+        if (oeBlanked(x_coord))
+          continue;
+        if (x_coord >= _new)
+          row[x_coord] |= BIT_OE;
+        else
+          row[x_coord] &= BITMASK_OE_CLEAR;
+      }
+    } while(coloridx > _row.first_plane);
   } while(row_idx);
 }
 
+/**
+ * @brief - set the brightness now, see header
+ */
+void MatrixPanel_I2S_DMA::setPanelBrightness(int b)
+{
+  if (brt_lock)
+    xSemaphoreTake(brt_lock, portMAX_DELAY);
+
+  // a direct change ends a running fade, from here on the interrupt leaves the OE bits alone
+  portENTER_CRITICAL(&brt_mux);
+  fade_frames_left = 0;
+  const int from = brightness;
+  brightness = b;
+  portEXIT_CRITICAL(&brt_mux);
+
+  // the walk itself runs with interrupts on
+  if (initialized && b != from) {
+    for (uint8_t _buff_id = 0; _buff_id < frameBuffers(); _buff_id++)
+      brtAdjustOE(from, b, _buff_id);
+  }
+
+  if (brt_lock)
+    xSemaphoreGive(brt_lock);
+}
+
+/**
+ * @brief - start a brightness fade, stepped by the DMA EOF interrupt, see header
+ */
+void MatrixPanel_I2S_DMA::fadeTo(uint8_t b, uint32_t ms)
+{
+  const int target = b * PIXELS_PER_ROW / 256;
+
+  uint32_t frames = (uint64_t)ms * calculated_refresh_rate / 1000;
+  if ( !initialized || !frames ) {
+    setPanelBrightness(target);
+    return;
+  }
+
+  // not while a task is still rewriting OE bits for a direct change
+  xSemaphoreTake(brt_lock, portMAX_DELAY);
+  portENTER_CRITICAL(&brt_mux);
+  fade_from        = brightness;
+  fade_to          = target;
+  fade_frames      = frames;
+  fade_frames_left = frames;
+  portEXIT_CRITICAL(&brt_mux);
+  xSemaphoreGive(brt_lock);
+
+  fade_hooked = true;
+  hookVsync();
+}
+
+/**
+ * @brief - one fade step per frame sent out, runs in the DMA interrupt
+ */
+void IRAM_ATTR MatrixPanel_I2S_DMA::fadeStep()
+{
+  portENTER_CRITICAL_ISR(&brt_mux);
+
+  if (fade_frames_left) {
+    --fade_frames_left;
+
+    // linear from fade_from to fade_to over fade_frames
+    const int b = fade_to + (fade_from - fade_to) * (int32_t)fade_frames_left / (int32_t)fade_frames;
+    if (b != brightness) {
+      for (uint8_t _buff_id = 0; _buff_id < frameBuffers(); _buff_id++)
+        brtAdjustOE(brightness, b, _buff_id);
+      brightness = b;
+    }
+  }
+
+  portEXIT_CRITICAL_ISR(&brt_mux);
+}
+
+MatrixPanel_I2S_DMA *MatrixPanel_I2S_DMA::vsync_owner = nullptr;
+
+/**
+ * @brief - DMA EOF interrupt hook: present queue, fade step, then the user's vsync callback
+ */
+void IRAM_ATTR MatrixPanel_I2S_DMA::vsyncISR()
+{
+  MatrixPanel_I2S_DMA *self = vsync_owner;
+  if (!self)
+    return;
+
+  if (self->m_cfg.triple_buff)
+    self->queueStep();
+
+  if (self->fade_frames_left)
+    self->fadeStep();
+
+  if (self->vsync_cb)
+    self->vsync_cb();
+}
+
+bool MatrixPanel_I2S_DMA::setDither(bool enable)
+{
+  if (enable && !shadow_buff) {
+    #if SERIAL_DEBUG
+      Serial.println(F("Temporal dithering needs the shadow buffer, see setShadowBuffer()."));
+    #endif
+    enable = false;
+  }
+
+  if (enable == dither)
+    return dither;
+
+  dither = enable;
+  hookVsync();
+
+  // render everything again, with or without the pattern
+  if (shadow_buff)
+    markShadowAllDirty();
+
+  return dither;
+}
 
 /*
  *  overload for compatibility
@@ -841,172 +1382,512 @@ uint8_t MatrixPanel_I2S_DMA::setLatBlanking(uint8_t pulses){
     pulses = DEFAULT_LAT_BLANKING;
 
   m_cfg.latch_blanking = pulses;
-  setPanelBrightness(brightness);    // set brightness to reset OE bits to the values matching new LAT blanking setting
+
+  // blanked words moved, rebuild the OE bits for the current brightness from scratch
+  if (initialized) {
+    xSemaphoreTake(brt_lock, portMAX_DELAY);
+    portENTER_CRITICAL(&brt_mux);
+    fade_frames_left = 0;
+    portEXIT_CRITICAL(&brt_mux);
+    for (uint8_t _buff_id = 0; _buff_id < frameBuffers(); _buff_id++)
+      brtCtrlOE(brightness, _buff_id);
+    xSemaphoreGive(brt_lock);
+  }
   return m_cfg.latch_blanking;
 }
 
 
-#ifndef NO_FAST_FUNCTIONS
 /**
- * @brief - update DMA buff drawing horizontal line at specified coordinates
- * @param x_ccord - line start coordinate x
- * @param y_ccord - line start coordinate y
- * @param l - line length
- * @param r,g,b, - RGB888 color
+ * @brief - fill the per channel colour plane lookup tables for the configured gamma curve
+ * Each entry holds the (gamma corrected) channel value split into its colour depth planes, one nibble per plane,
+ * so drawing code never has to mask and shift colour bits per plane again.
  */
-void MatrixPanel_I2S_DMA::hlineDMA(int16_t x_coord, int16_t y_coord, int16_t l, uint8_t red, uint8_t green, uint8_t blue){
+void MatrixPanel_I2S_DMA::buildColorPlaneLUT()
+{
+  for (int value = 0; value < 256; value++)
+  {
+    uint8_t lum;
+    switch (m_cfg.gamma) {
+      case HUB75_I2S_CFG::GAMMA_CIE1931:
+        lum = lumConvTab[value];
+        break;
+      case HUB75_I2S_CFG::GAMMA_22:
+        lum = (uint8_t)(powf(value / 255.0f, 2.2f) * 255.0f + 0.5f);
+        break;
+      default:
+        lum = value;
+        break;
+    }
+
+    lumLUT[value] = lum;
+
+    uint32_t planes = 0;
+    for (uint8_t color_depth_idx = 0; color_depth_idx < PIXEL_COLOR_DEPTH_BITS; color_depth_idx++)
+    {
+    #if PIXEL_COLOR_DEPTH_BITS < 8
+        uint8_t mask = (1 << (color_depth_idx+MASK_OFFSET)); // expect 24 bit color (8 bits per RGB subpixel)
+    #else
+        uint8_t mask = (1 << (color_depth_idx)); // expect 24 bit color (8 bits per RGB subpixel)
+    #endif
+        if (lum & mask)
+          planes |= 1UL << (color_depth_idx * COLOR_PLANE_LUT_BITS);
+    }
+
+    colorPlaneLUT[0][value] = planes;        // R -> BIT_R1
+    colorPlaneLUT[1][value] = planes << 1;   // G -> BIT_G1
+    colorPlaneLUT[2][value] = planes << 2;   // B -> BIT_B1
+  }
+}
+
+/**
+ * @brief - select the gamma curve applied to all colours drawn from now on
+ * @param gamma_curve g - GAMMA_CIE1931, GAMMA_22 or GAMMA_LINEAR
+ */
+void MatrixPanel_I2S_DMA::setGamma(HUB75_I2S_CFG::gamma_curve g)
+{
+  m_cfg.gamma = g;
+  buildColorPlaneLUT();
+
+  // the shadow framebuffer still has the colours, re-convert everything on the next commit()
+  if (shadow_buff)
+    markShadowAllDirty();
+}
+
+/**
+ * @brief - flip buffers and sync only the changed rows into the new back buffer
+ * A row that was not touched in either buffer since the last sync is identical in both of them
+ * (control and OE bits are always written to both), so only rows flagged in either bitmap are copied.
+ */
+void MatrixPanel_I2S_DMA::presentIncremental()
+{
   if ( !initialized )
     return;
 
-  if ( x_coord < 0 || y_coord < 0 || l < 1 || x_coord >= PIXELS_PER_ROW || y_coord >= m_cfg.mx_height)
+  // the interrupt can't remove itself, drop the EOF interrupt here once a fade has run out
+  if (fade_hooked && !fade_frames_left) {
+    fade_hooked = false;
+    hookVsync();
+  }
+
+  if ( !m_cfg.double_buff ) {
+    // single buffer is on screen already, nothing to present
+    dirty_rows[0] = 0;
     return;
+  }
 
+  if ( m_cfg.triple_buff ) {
+    const int _presented = back_buffer_id;
+    if (!dirty_rows[_presented])
+      return;
 
-  l = ( (x_coord + l) >= PIXELS_PER_ROW ) ? (PIXELS_PER_ROW - x_coord):l; 
+    // every other buffer is now behind by the rows drawn into this one
+    for (uint8_t _buff_id = 0; _buff_id < 3; _buff_id++)
+      if (_buff_id != _presented)
+        stale_rows[_buff_id] |= dirty_rows[_presented];
+    dirty_rows[_presented] = 0;
 
-  //if (x_coord+l > PIXELS_PER_ROW)
-//    l = PIXELS_PER_ROW - x_coord + 1;     // reset width to end of row
+    queueFrame();
 
-  /* LED Brightness Compensation */
-#ifndef NO_CIE1931
-    red   = lumConvTab[red];
-    green = lumConvTab[green];
-    blue  = lumConvTab[blue];   
-#endif
+    // bring the new back buffer up to the frame just queued
+    syncRows(stale_rows[back_buffer_id] | dirty_rows[back_buffer_id], back_buffer_id, _presented);
+    stale_rows[back_buffer_id] = dirty_rows[back_buffer_id] = 0;
+    return;
+  }
 
-  uint16_t _colorbitclear = BITMASK_RGB1_CLEAR, _colorbitoffset = 0;
+  const uint32_t rows = dirty_rows[0] | dirty_rows[1];
+  if (!rows)
+    return;
 
-  if (y_coord >= ROWS_PER_FRAME){    // if we are drawing to the bottom part of the panel
-    _colorbitoffset = BITS_RGB2_OFFSET;
-    _colorbitclear  = BITMASK_RGB2_CLEAR;
-    y_coord -= ROWS_PER_FRAME;
-  }
+  flipDMABuffer();
+
+  // back_buffer_id now points to the buffer that was on screen until the flip
+  syncRows(rows, back_buffer_id, back_buffer_id ^ 1);
+  dirty_rows[0] = dirty_rows[1] = 0;
+}
 
-  // Iterating through color depth bits (8 iterations)
-  uint8_t color_depth_idx = PIXEL_COLOR_DEPTH_BITS;
+/**
+ * @brief - copy whole DMA rows from one buffer to another
+ * The OE bits are copied too, so no brightness change may land in between: brt_lock keeps setPanelBrightness()
+ * out for the whole sync, brt_mux holds a fade step off for one row at a time.
+ */
+void MatrixPanel_I2S_DMA::syncRows(uint32_t rows, uint8_t _to_id, uint8_t _from_id)
+{
+  if (!rows)
+    return;
+
+  xSemaphoreTake(brt_lock, portMAX_DELAY);
   do {
-    --color_depth_idx;
+    const int row_idx = __builtin_ctz(rows);
+    rows &= rows - 1;
+
+    rowBitStruct *row = dma_buff.rowBits[row_idx];
+    portENTER_CRITICAL(&brt_mux);
+    memcpy(row->getDataPtr(row->first_plane, _to_id), row->getDataPtr(row->first_plane, _from_id), row->size());
+    portEXIT_CRITICAL(&brt_mux);
+  } while(rows);
+  xSemaphoreGive(brt_lock);
+}
 
-    // let's precalculate RGB1 and RGB2 bits than flood it over the entire DMA buffer
-    uint16_t RGB_output_bits = 0;
-//    uint8_t mask = (1 << color_depth_idx COLOR_DEPTH_LESS_THAN_8BIT_ADJUST);
-    #if PIXEL_COLOR_DEPTH_BITS < 8
-        uint8_t mask = (1 << (color_depth_idx+MASK_OFFSET)); // expect 24 bit color (8 bits per RGB subpixel)
-    #else
-        uint8_t mask = (1 << (color_depth_idx)); // expect 24 bit color (8 bits per RGB subpixel)
-    #endif      
-
-    /* Per the .h file, the order of the output RGB bits is:
-      * BIT_B2, BIT_G2, BIT_R2,    BIT_B1, BIT_G1, BIT_R1     */
-    RGB_output_bits |= (bool)(blue & mask);   // --B
-    RGB_output_bits <<= 1;
-    RGB_output_bits |= (bool)(green & mask);  // -BG
-    RGB_output_bits <<= 1;
-    RGB_output_bits |= (bool)(red & mask);    // BGR
-    RGB_output_bits <<= _colorbitoffset;      // shift color bits to the required position
-
-    // Get the contents at this address,
-    // it would represent a vector pointing to the full row of pixels for the specified color depth bit at Y coordinate
-    ESP32_I2S_DMA_STORAGE_TYPE *p = dma_buff.rowBits[y_coord]->getDataPtr(color_depth_idx, back_buffer_id);
-    // inlined version works slower here, dunno why :(
-    // ESP32_I2S_DMA_STORAGE_TYPE *p = getRowDataPtr(y_coord, color_depth_idx, back_buffer_id);
-
-    int16_t _l = l;
-    do {                 // iterate pixels in a row
-        int16_t _x = x_coord + --_l;
-        
-#ifdef ESP32_SXXX       
-        // ESP 32 doesn't need byte flipping for TX FIFO.
-        uint16_t &v = p[_x];
-#else
-        // Save the calculated value to the bitplane memory in reverse order to account for I2S Tx FIFO mode1 ordering
-        uint16_t &v = p[_x & 1U ? --_x : ++_x];
-#endif      
+/**
+ * @brief - put the back buffer on the present queue and pick the next one to draw on, see presentIncremental()
+ * A queued frame the interrupt has not linked yet is stale now: it is dropped and its buffer drawn on next.
+ * Otherwise the free buffer is the one that is neither on screen, nor linked to go on screen, nor just queued.
+ * All three are busy only while the previous frame is linked, that's settled by the next EOF.
+ */
+int8_t MatrixPanel_I2S_DMA::queueFrame()
+{
+  const int8_t _presented = back_buffer_id;
+  int8_t _next = -1;
+
+  portENTER_CRITICAL(&queue_mux);
+  const int8_t _dropped = queued_buffer_id;
+  queued_buffer_id = _presented;
+  if (_dropped >= 0) {
+    ++present_stats.dropped;
+    _next = _dropped;
+  }
+  portEXIT_CRITICAL(&queue_mux);
+
+  while (_next < 0) {
+    portENTER_CRITICAL(&queue_mux);
+    for (int8_t _buff_id = 0; _buff_id < 3; _buff_id++) {
+      if (_buff_id != _presented && _buff_id != front_buffer_id && _buff_id != linked_buffer_id) {
+        _next = _buff_id;
+        break;
+      }
+    }
+    portEXIT_CRITICAL(&queue_mux);
 
-        v &= _colorbitclear;      // reset color bits
-        v |= RGB_output_bits;    // set new color bits
-    } while(_l);        // iterate pixels in a row
-  } while(color_depth_idx);  // end of color depth loop (8)
-} // hlineDMA()
+    if (_next < 0 && !waitForVsync()) {
+      // DMA output is not running, nothing is going to be shifted out of the linked buffer
+      _next = linked_buffer_id;
+      break;
+    }
+  }
+
+  #if SERIAL_DEBUG
+    Serial.printf_P(PSTR("Queued buffer %d, back buffer is now %d\n"), _presented, _next);
+  #endif
+
+  back_buffer_id = _next;
+  return _next;
+}
 
+/**
+ * @brief - point the last descriptor of every chain at the start of a buffer's chain
+ */
+void IRAM_ATTR MatrixPanel_I2S_DMA::linkChainsTo(uint8_t _buff_id)
+{
+  lldesc_t *head = &dmaChain(_buff_id)[0];
+  for (uint8_t _chain = 0; _chain < frameBuffers(); _chain++)
+    dmaChain(_chain)[desccount-1].qe.stqe_next = head;
+}
 
 /**
- * @brief - update DMA buff drawing vertical line at specified coordinates
- * @param x_ccord - line start coordinate x
- * @param y_ccord - line start coordinate y
- * @param l - line length
- * @param r,g,b, - RGB888 color
+ * @brief - one present queue step per frame sent out, runs in the DMA interrupt
+ * The chains are only ever re-linked right after an EOF, a whole frame before the DMA gets to the end of them.
  */
-void MatrixPanel_I2S_DMA::vlineDMA(int16_t x_coord, int16_t y_coord, int16_t l, uint8_t red, uint8_t green, uint8_t blue){
+void IRAM_ATTR MatrixPanel_I2S_DMA::queueStep()
+{
+  portENTER_CRITICAL_ISR(&queue_mux);
+
+  // the chains led into the linked buffer, it is on screen from now on
+  if (linked_buffer_id >= 0) {
+    front_buffer_id  = linked_buffer_id;
+    linked_buffer_id = -1;
+    front_refreshes  = 1;
+    ++present_stats.presented;
+  } else if (front_refreshes < UINT16_MAX) {
+    ++front_refreshes;
+  }
+
+  // newest finished frame goes on screen next, once the current one has had its refreshes
+  if (queued_buffer_id >= 0 && front_refreshes >= frame_pacing) {
+    if (frame_pacing && front_refreshes > frame_pacing)
+      ++present_stats.late;
+
+    linkChainsTo(queued_buffer_id);
+    linked_buffer_id = queued_buffer_id;
+    queued_buffer_id = -1;
+  }
+
+  portEXIT_CRITICAL_ISR(&queue_mux);
+}
+
+/**
+ * @brief - DMA descriptors per row, same sum as in allocateDMAmemory()
+ */
+int MatrixPanel_I2S_DMA::dmaDescriptorsPerRow(int transition_bit) const
+{
+  int num = 1;
+  for(int i=transition_bit + 1; i<PIXEL_COLOR_DEPTH_BITS; i++)
+    num += (1<<(i - transition_bit - 1));
+
+  // see DMA payload split in linkDMAchains()
+  if ( rowBitStructBuffSize > DMA_MAX )
+    num += active_color_depth-1;
+
+  return num;
+}
+
+/**
+ * @brief - I2S clocks per frame: every plane once, plus the repeated planes above the transition bit
+ */
+uint32_t MatrixPanel_I2S_DMA::clocksPerFrame(int transition_bit) const
+{
+  uint32_t latches = active_color_depth;
+  for(int i=transition_bit + 1; i<PIXEL_COLOR_DEPTH_BITS; i++)
+    latches += (1<<(i - transition_bit - 1)) * (PIXEL_COLOR_DEPTH_BITS - i);
+
+  return latches * (PIXELS_PER_ROW + CLKS_DURING_LATCH) * ROWS_PER_FRAME;
+}
+
+/**
+ * @brief - re-derive lsbMsbTransitionBit, the DMA chain and the I2S clock divider for a new refresh rate
+ */
+int MatrixPanel_I2S_DMA::setRefreshRate(uint16_t hz)
+{
+  if ( !initialized || !hz )
+    return calculated_refresh_rate;
+
+  refresh_rate_target = hz;
+  return applyScanConfig(false);
+}
+
+/**
+ * @brief - link only the 'bits' most significant colour planes, see header
+ */
+uint8_t MatrixPanel_I2S_DMA::setColorDepth(uint8_t bits, bool resize)
+{
+  if (bits < MIN_COLOR_DEPTH_BITS)   bits = MIN_COLOR_DEPTH_BITS;
+  if (bits > PIXEL_COLOR_DEPTH_BITS) bits = PIXEL_COLOR_DEPTH_BITS;
+
   if ( !initialized )
-    return;
+    return active_color_depth;
 
-  if ( x_coord < 0 || y_coord < 0 || l < 1 || x_coord >= PIXELS_PER_ROW || y_coord >= m_cfg.mx_height)
-    return;
+  if (resize && bits != dma_planes)
+    return resizeDMAmemory(bits) ? active_color_depth : 0;
 
-  // check for a length that goes beyond the height of the screen! Array out of bounds dma memory changes = screwed output #163
-  l = ( (y_coord + l) >= m_cfg.mx_height ) ? (m_cfg.mx_height - y_coord):l; 
-  //if (y_coord + l > m_cfg.mx_height)
-  ///    l = m_cfg.mx_height - y_coord + 1;     // reset width to end of col
+  // only planes that are stored can be linked
+  if (bits > dma_planes)
+    bits = dma_planes;
 
-  /* LED Brightness Compensation */
-#ifndef NO_CIE1931
-    red   = lumConvTab[red];
-    green = lumConvTab[green];
-    blue  = lumConvTab[blue];   
-#endif
+  if (bits == active_color_depth)
+    return active_color_depth;
 
-#ifndef ESP32_SXXX
-  // Save the calculated value to the bitplane memory in reverse order to account for I2S Tx FIFO mode1 ordering 
-  x_coord & 1U ? --x_coord : ++x_coord;
-#endif  
+  active_color_depth = bits;
+  applyScanConfig(true);
 
-  uint8_t color_depth_idx = PIXEL_COLOR_DEPTH_BITS;
-  do {    // Iterating through color depth bits (8 iterations)
-    --color_depth_idx;
+  return active_color_depth;
+}
 
-    // let's precalculate RGB1 and RGB2 bits than flood it over the entire DMA buffer
-//    uint8_t mask = (1 << color_depth_idx COLOR_DEPTH_LESS_THAN_8BIT_ADJUST);
-    #if PIXEL_COLOR_DEPTH_BITS < 8
-        uint8_t mask = (1 << (color_depth_idx+MASK_OFFSET)); // expect 24 bit color (8 bits per RGB subpixel)
-    #else
-        uint8_t mask = (1 << (color_depth_idx)); // expect 24 bit color (8 bits per RGB subpixel)
-    #endif      
-    uint16_t RGB_output_bits = 0;
-
-    /* Per the .h file, the order of the output RGB bits is:
-    * BIT_B2, BIT_G2, BIT_R2,    BIT_B1, BIT_G1, BIT_R1   */
-    RGB_output_bits |= (bool)(blue & mask);   // --B
-    RGB_output_bits <<= 1;
-    RGB_output_bits |= (bool)(green & mask);  // -BG
-    RGB_output_bits <<= 1;
-    RGB_output_bits |= (bool)(red & mask);    // BGR
-
-    int16_t _l = 0, _y = y_coord;
-    uint16_t _colorbitclear = BITMASK_RGB1_CLEAR;
-    do {    // iterate pixels in a column
-
-      if (_y >= ROWS_PER_FRAME){    // if y-coord overlapped bottom-half panel
-        _y -= ROWS_PER_FRAME;
-        _colorbitclear  = BITMASK_RGB2_CLEAR;
-        RGB_output_bits <<= BITS_RGB2_OFFSET;
+/**
+ * @brief - swap the DMA buffers for ones holding 'bits' colour planes, see setColorDepth()
+ */
+bool MatrixPanel_I2S_DMA::resizeDMAmemory(uint8_t bits)
+{
+  // no fade step or OE rewrite may touch the buffers while they are given back
+  xSemaphoreTake(brt_lock, portMAX_DELAY);
+  portENTER_CRITICAL(&brt_mux);
+  fade_frames_left = 0;
+  portEXIT_CRITICAL(&brt_mux);
+
+  i2s_parallel_stop_dma(ESP32_I2S_DEVICE);
+  releaseDMAmemory();
+
+  // going up can fail when the RAM was taken in the meantime, take fewer planes then. The old size fits
+  // again at worst, unless the freed blocks were grabbed by another task in between
+  dma_planes = bits;
+  while (!allocateDMAmemory() && dma_planes > MIN_COLOR_DEPTH_BITS)
+    --dma_planes;
+
+  if (!dma_buff.rows) {
+    #if SERIAL_DEBUG
+      Serial.println(F("resizeDMAmemory(): no DMA memory left for any colour depth, output stays off."));
+    #endif
+    initialized = false;
+    xSemaphoreGive(brt_lock);
+    return false;
+  }
+
+  #if SERIAL_DEBUG
+    Serial.printf_P(PSTR("resizeDMAmemory(): %d colour planes, %d bytes reserved.\r\n"), dma_planes, dma_arena.reserved());
+  #endif
+
+  active_color_depth = dma_planes;
+
+  // new chains loop on buffer 0, which goes on screen first like after begin()
+  portENTER_CRITICAL(&queue_mux);
+  front_buffer_id  = 0;
+  linked_buffer_id = -1;
+  queued_buffer_id = -1;
+  portEXIT_CRITICAL(&queue_mux);
+  back_buffer_id = m_cfg.triple_buff ? 1 : 0;
+  linkDMAchains();
+
+  xSemaphoreGive(brt_lock);
+
+  // re-links for the new depth and the refresh rate target, clears the buffers and restarts output
+  applyScanConfig(true);
+  return true;
+}
+
+/**
+ * @brief - pick lsbMsbTransitionBit and I2S clock for the refresh rate target and the active colour depth,
+ * then re-link and restart DMA output if anything changed
+ * @param bool depth_changed - the set of linked colour planes changed, buffers have to be re-initialised
+ */
+int MatrixPanel_I2S_DMA::applyScanConfig(bool depth_changed)
+{
+  const uint16_t hz = refresh_rate_target ? refresh_rate_target : m_cfg.min_refresh_rate;
+
+  const uint32_t clk_base = I2S_PARALLEL_CLOCK_HZ / i2s_parallel_get_memory_width(ESP32_I2S_DEVICE, ESP32_I2S_DMA_MODE);
+  const uint32_t clk_max  = m_cfg.i2sspeed;    // configured speed is the fastest the panels are known to take
+
+  // keep as many colour planes as possible: lowest transition bit that makes the rate at full clock,
+  // but no lower than the descriptor memory allows or than the first linked plane
+  int transition_bit = lsbMsbTransitionBitMin;
+  if (transition_bit < firstColorPlane())
+    transition_bit = firstColorPlane();
+  while (transition_bit < PIXEL_COLOR_DEPTH_BITS - 1 && (uint64_t)hz * clocksPerFrame(transition_bit) > clk_max)
+    ++transition_bit;
+
+  // then the slowest clock that still makes it, saves DMA bus bandwidth.
+  // Without a requested rate the clock stays where it is, fewer colour planes then mean a faster refresh.
+  uint32_t clk = i2s_clock_hz;
+  if (refresh_rate_target || (uint64_t)hz * clocksPerFrame(transition_bit) > i2s_clock_hz)
+  {
+    uint64_t clk_needed = (uint64_t)hz * clocksPerFrame(transition_bit);
+    uint32_t clk_div = (clk_needed < clk_base) ? clk_base / clk_needed : 0;    // rounds the clock up
+    if (clk_div < clk_base / clk_max) clk_div = clk_base / clk_max;
+    if (clk_div < 2)    clk_div = 2;
+    if (clk_div > 0xFF) clk_div = 0xFF;
+    clk = clk_base / clk_div;
+  }
+
+  if (depth_changed || transition_bit != lsbMsbTransitionBit || clk != i2s_clock_hz)
+  {
+    // OE bits get rebuilt below, a running fade stops where it is
+    xSemaphoreTake(brt_lock, portMAX_DELAY);
+    portENTER_CRITICAL(&brt_mux);
+    fade_frames_left = 0;
+    portEXIT_CRITICAL(&brt_mux);
+
+    // buffer that's on screen, chains have to loop back into it after re-linking
+    int active_buffer = (m_cfg.double_buff && dmadesc_a[desccount-1].qe.stqe_next == &dmadesc_b[0]) ? 1 : 0;
+
+    i2s_parallel_stop_dma(ESP32_I2S_DEVICE);
+
+    if (m_cfg.triple_buff) {
+      // a linked frame was about to go on screen anyway, start with it; a queued one gets linked on the next EOF
+      portENTER_CRITICAL(&queue_mux);
+      if (linked_buffer_id >= 0) {
+        front_buffer_id  = linked_buffer_id;
+        linked_buffer_id = -1;
+        ++present_stats.presented;
       }
+      active_buffer = front_buffer_id;
+      portEXIT_CRITICAL(&queue_mux);
+    }
+
+    if (depth_changed || transition_bit != lsbMsbTransitionBit) {
+      lsbMsbTransitionBit = transition_bit;
+      desccount = dmaDescriptorsPerRow(lsbMsbTransitionBit) * ROWS_PER_FRAME;
+      linkDMAchains();
+      i2s_parallel_set_dma_chains(dmadesc_a, desccount, dmadesc_b, desccount);
+      if (m_cfg.double_buff && !m_cfg.triple_buff)
+        i2s_parallel_flip_to_buffer(ESP32_I2S_DEVICE, active_buffer);
+
+      if (depth_changed) {
+        // address bits of the first linked plane moved, rebuild control bits from scratch (blanks the screen)
+        resetbuffers();
+        if (shadow_buff)
+          markShadowAllDirty();    // picture comes back on the next commit()
+      } else {
+        // OE of the planes up to the transition bit depends on it
+        for (uint8_t _buff_id = 0; _buff_id < frameBuffers(); _buff_id++)
+          brtCtrlOE(brightness, _buff_id);
+      }
+    }
+
+    if (m_cfg.triple_buff)
+      linkChainsTo(active_buffer);
+
+    if (i2s_parallel_set_clock(ESP32_I2S_DEVICE, clk, ESP32_I2S_DMA_MODE) == ESP_OK)
+      i2s_clock_hz = clk;
+
+    i2s_parallel_send_dma(ESP32_I2S_DEVICE, &dmaChain(active_buffer)[0]);
+    xSemaphoreGive(brt_lock);
+
+    // frames sent with the old configuration don't count, an open window starts again
+    rate_sample_us     = micros();
+    rate_sample_frames = getFrameCount();
+    measured_refresh_rate = 0;
+  }
+
+  calculated_refresh_rate = i2s_clock_hz / clocksPerFrame(lsbMsbTransitionBit);
+
+  #if SERIAL_DEBUG
+    Serial.printf_P(PSTR("applyScanConfig(): %d bit colour, lsbMsbTransitionBit %d, I2S clock %d Hz, %d Hz refresh\r\n"), active_color_depth, lsbMsbTransitionBit, i2s_clock_hz, calculated_refresh_rate);
+  #endif
+
+  return calculated_refresh_rate;
+}
+
+/**
+ * @brief - refresh rate from the number of EOF interrupts (one per frame) over a window the interrupt was on for
+ */
+int MatrixPanel_I2S_DMA::getRefreshRate()
+{
+  if (!rate_window_open) {
+    // the frame counter only runs with the EOF interrupt on, switch it on before the window starts
+    rate_window_open = true;
+    hookVsync();
+    rate_sample_us     = micros();
+    rate_sample_frames = getFrameCount();
+  } else {
+    const uint32_t elapsed = micros() - rate_sample_us;
+    if (elapsed >= REFRESH_RATE_WINDOW_MS * 1000UL) {
+      measured_refresh_rate = (uint64_t)(getFrameCount() - rate_sample_frames) * 1000000UL / elapsed;
+      rate_window_open = false;
+      hookVsync();
+    }
+  }
+
+  return measured_refresh_rate ? measured_refresh_rate : calculated_refresh_rate;
+}
 
-      // Get the contents at this address,
-      // it would represent a vector pointing to the full row of pixels for the specified color depth bit at Y coordinate
-      ESP32_I2S_DMA_STORAGE_TYPE *p = getRowDataPtr(_y, color_depth_idx, back_buffer_id);
 
-      p[x_coord] &= _colorbitclear;   // reset RGB bits
-      p[x_coord] |= RGB_output_bits;  // set new RGB bits
-      ++_y;
-    } while(++_l!=l);        // iterate pixels in a col
-  } while(color_depth_idx);  // end of color depth loop (8)
+#ifndef NO_FAST_FUNCTIONS
+/**
+ * @brief - update DMA buff drawing horizontal line at specified coordinates
+ * @param x_ccord - line start coordinate x
+ * @param y_ccord - line start coordinate y
+ * @param l - line length
+ * @param r,g,b, - RGB888 color
+ */
+void MatrixPanel_I2S_DMA::hlineDMA(int16_t x_coord, int16_t y_coord, int16_t l, uint8_t red, uint8_t green, uint8_t blue){
+  fillRectDMA(x_coord, y_coord, l, 1, red, green, blue);
+} // hlineDMA()
+
+
+/**
+ * @brief - update DMA buff drawing vertical line at specified coordinates
+ * @param x_ccord - line start coordinate x
+ * @param y_ccord - line start coordinate y
+ * @param l - line length
+ * @param r,g,b, - RGB888 color
+ */
+void MatrixPanel_I2S_DMA::vlineDMA(int16_t x_coord, int16_t y_coord, int16_t l, uint8_t red, uint8_t green, uint8_t blue){
+  fillRectDMA(x_coord, y_coord, 1, l, red, green, blue);
 } // vlineDMA()
 
 
 /**
  * @brief - update DMA buff drawing a rectangular at specified coordinates
  * this works much faster than multiple consecutive per-pixel calls to updateMatrixDMABuffer()
+ * The rectangle is clipped once and filled DMA row by DMA row with fillSpanDMA(). Where it covers both
+ * screen rows that share a DMA row (top and bottom half), both halves are written in the same pass.
  * @param int16_t x, int16_t y - coordinates of a top-left corner
  * @param int16_t w, int16_t h - width and height of a rectangular, min is 1 px
  * @param uint8_t r - RGB888 color
@@ -1014,22 +1895,71 @@ void MatrixPanel_I2S_DMA::vlineDMA(int16_t x_coord, int16_t y_coord, int16_t l,
  * @param uint8_t b - RGB888 color
  */
 void MatrixPanel_I2S_DMA::fillRectDMA(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t r, uint8_t g, uint8_t b){
+  if ( !initialized )
+    return;
 
-  // h-lines are >2 times faster than v-lines
-  // so will use it only for tall rects with h >2w
-  if (h>2*w){
-    // draw using v-lines
-    do {
-      --w;
-      vlineDMA(x+w, y, h, r,g,b);
-    } while(w);
-  } else {
-    // draw using h-lines
-    do {
-      --h;
-      hlineDMA(x, y+h, w, r,g,b);
-    } while(h);
+  // clip to the screen
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > PIXELS_PER_ROW)     w = PIXELS_PER_ROW - x;
+  if (y + h > m_cfg.mx_height)    h = m_cfg.mx_height - y;
+  if (w < 1 || h < 1)
+    return;
+
+  if (shadow_buff) {
+    shadowFill(x, y, w, h, color565(r, g, b));
+    return;
   }
-}
+
+  /* LED Brightness Compensation */
+  const uint32_t planebits = colorPlaneBits(r, g, b);
+
+  // DMA rows touched by the top and / or the bottom half part of the rectangle
+  const int16_t y_end   = y + h;
+  const int16_t row_lo  = (y >= ROWS_PER_FRAME) ? y - ROWS_PER_FRAME : ((y_end > ROWS_PER_FRAME) ? 0 : y);
+  const int16_t row_hi  = (y_end <= ROWS_PER_FRAME) ? y_end : ((y < ROWS_PER_FRAME) ? ROWS_PER_FRAME : y_end - ROWS_PER_FRAME);
+
+  // single column: nothing to pair up, one read-modify-write per plane and DMA row
+  if (w == 1)
+  {
+    const size_t plane_stride = dma_buff.rowBits[0]->width;
+  #ifndef ESP32_SXXX
+    // Save the calculated value to the bitplane memory in reverse order to account for I2S Tx FIFO mode1 ordering
+    if ((size_t)(x ^ 1U) < plane_stride)
+      x ^= 1U;
+  #endif
+
+    for (int16_t row_idx = row_lo; row_idx < row_hi; ++row_idx)
+    {
+      const bool top    = row_idx >= y && row_idx < y_end;
+      const bool bottom = row_idx + ROWS_PER_FRAME >= y && row_idx + ROWS_PER_FRAME < y_end;
+      if (!top && !bottom)
+        continue;
+
+      const uint16_t _colorbitclear = top ? (bottom ? BITMASK_RGB12_CLEAR : BITMASK_RGB1_CLEAR) : BITMASK_RGB2_CLEAR;
+      const uint8_t  _colorspread   = top ? (bottom ? COLOR_SPAN_RGB12 : COLOR_SPAN_RGB1) : COLOR_SPAN_RGB2;
+
+      dirty_rows[back_buffer_id] |= 1UL << row_idx;
+
+      ESP32_I2S_DMA_STORAGE_TYPE *p = getRowDataPtr(row_idx, firstStoredPlane(), back_buffer_id) + x;
+      for (uint8_t color_depth_idx = firstStoredPlane(); color_depth_idx < PIXEL_COLOR_DEPTH_BITS; color_depth_idx++, p += plane_stride)
+        *p = (*p & _colorbitclear) | (COLOR_PLANE_RGB(planebits, color_depth_idx) * _colorspread);
+    }
+    return;
+  }
+
+  for (int16_t row_idx = row_lo; row_idx < row_hi; ++row_idx)
+  {
+    const bool top    = row_idx >= y && row_idx < y_end;
+    const bool bottom = row_idx + ROWS_PER_FRAME >= y && row_idx + ROWS_PER_FRAME < y_end;
+
+    if (top && bottom)
+      fillSpanDMA(x, row_idx, w, planebits, BITMASK_RGB12_CLEAR, COLOR_SPAN_RGB12);
+    else if (top)
+      fillSpanDMA(x, row_idx, w, planebits, BITMASK_RGB1_CLEAR, COLOR_SPAN_RGB1);
+    else if (bottom)
+      fillSpanDMA(x, row_idx, w, planebits, BITMASK_RGB2_CLEAR, COLOR_SPAN_RGB2);
+  }
+} // fillRectDMA()
 
 #endif  // NO_FAST_FUNCTIONS
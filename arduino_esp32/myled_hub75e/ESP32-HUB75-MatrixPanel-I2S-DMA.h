@@ -124,8 +124,23 @@
 
 #define COLOR_CHANNELS_PER_PIXEL     3
 
+// Lowest colour depth setColorDepth() will go down to at runtime
+#ifndef MIN_COLOR_DEPTH_BITS
+ #define MIN_COLOR_DEPTH_BITS        3
+#endif
+
 // #define NO_CIE1931
 
+// Longest time (ms) to block waiting for a vsync, i.e. when DMA output has been stopped
+#ifndef VSYNC_TIMEOUT_MS
+ #define VSYNC_TIMEOUT_MS            100
+#endif
+
+// Shortest time (ms) frames are counted over to measure the refresh rate
+#ifndef REFRESH_RATE_WINDOW_MS
+ #define REFRESH_RATE_WINDOW_MS      500
+#endif
+
 
 /***************************************************************************************/
 /* Definitions below should NOT be ever changed without rewriting library logic         */
@@ -193,14 +208,15 @@ static constexpr uint8_t const MASK_OFFSET = 8-PIXEL_COLOR_DEPTH_BITS;
  */
 struct rowBitStruct {
     const size_t width;
-    const uint8_t color_depth;
-    const bool double_buff;
+    const uint8_t color_depth;  // colour planes stored, the most significant ones
+    const uint8_t first_plane;  // PIXEL_COLOR_DEPTH_BITS - color_depth, the planes below it are not stored
+    const uint8_t buffers;      // 1, 2 (double buffering) or 3 (triple buffering) copies of the row, back to back
     ESP32_I2S_DMA_STORAGE_TYPE *data;
 
     /** @brief - returns size of row of data vectorfor a SINGLE buff
      * size (in bytes) of a vector holding full DMA data for a row of pixels with _dpth color bits
-     * a SINGLE buffer only size is accounted, when using double buffers it actually takes twice as much space
-     * but returned size is for a half of double-buffer
+     * a SINGLE buffer only size is accounted, when using double/triple buffers it actually takes two/three times as much space
+     * but returned size is for one of the buffers
      * 
      * default - returns full data vector size for a SINGLE buff
      *
@@ -208,17 +224,14 @@ struct rowBitStruct {
     size_t size(uint8_t _dpth=0 ) { if (!_dpth) _dpth = color_depth; return width * _dpth * sizeof(ESP32_I2S_DMA_STORAGE_TYPE); };
 
     /** @brief - returns pointer to the row's data vector beginning at pixel[0] for _dpth color bit
-     * default - returns pointer to the data vector's head
+     * _dpth is the plane index from 0 (LSB) to PIXEL_COLOR_DEPTH_BITS - 1, first_plane or above
      * NOTE: this call might be very slow in loops. Due to poor instruction caching in esp32 it might be required a reread from flash 
      * every loop cycle, better use inlined #define instead in such cases
      */
-    ESP32_I2S_DMA_STORAGE_TYPE* getDataPtr(const uint8_t _dpth=0, const bool buff_id=0) { return &(data[_dpth*width + buff_id*(width*color_depth)]); };
+    ESP32_I2S_DMA_STORAGE_TYPE* getDataPtr(const uint8_t _dpth, const uint8_t buff_id=0) { return &(data[(_dpth - first_plane)*width + buff_id*(width*color_depth)]); };
 
-    // constructor - allocates DMA-capable memory to hold the struct data
-    rowBitStruct(const size_t _width, const uint8_t _depth, const bool _dbuff) : width(_width), color_depth(_depth), double_buff(_dbuff) {
-      data = (ESP32_I2S_DMA_STORAGE_TYPE *)heap_caps_malloc( size()+size()*double_buff, MALLOC_CAP_DMA);
-    }
-    ~rowBitStruct() { delete data;}
+    // constructor - data points to DMA-capable memory carved out of the dmaArena, size()*_buffers bytes
+    rowBitStruct(const size_t _width, const uint8_t _depth, const uint8_t _buffers, ESP32_I2S_DMA_STORAGE_TYPE *_data) : width(_width), color_depth(_depth), first_plane(PIXEL_COLOR_DEPTH_BITS - _depth), buffers(_buffers), data(_data) {}
 };
 
 
@@ -226,22 +239,93 @@ struct rowBitStruct {
  * Note: A 'frameStruct' contains ALL the data for a full-frame (i.e. BOTH 2x16-row frames are
  *       are contained in parallel within the one uint16_t that is sent in parallel to the HUB75). 
  * 
- *       This structure isn't actually allocated in one memory block anymore, as the library now allocates
- *       memory per row (per rowColorDepthStruct) instead.
+ *       The row data is carved out of the few large blocks of a dmaArena, a row never spans two blocks.
+ *       The row structs themselves live in one vector, rowBits just points into it.
  */
 struct frameStruct {
     uint8_t rows=0;    // number of rows held in current frame, not used actually, just to keep the idea of struct
-    std::vector<std::shared_ptr<rowBitStruct> > rowBits;
+    std::vector<rowBitStruct>   rowStore;
+    std::vector<rowBitStruct *> rowBits;
+};
+
+/* dmaArena
+ * A handful of large DMA-capable blocks that all row buffers and DMA descriptor lists are carved out of,
+ * instead of a heap_caps_malloc() per row. Keeps the internal RAM from being peppered with small DMA blocks,
+ * so larger chains fit and later (GIF, BLE) allocations find contiguous memory.
+ */
+#ifndef DMA_ARENA_MAX_BLOCKS
+ #define DMA_ARENA_MAX_BLOCKS        8
+#endif
+
+struct dmaArena {
+    uint8_t  blocks = 0;
+    uint8_t *block[DMA_ARENA_MAX_BLOCKS];
+    size_t   block_size[DMA_ARENA_MAX_BLOCKS];
+    size_t   block_used[DMA_ARENA_MAX_BLOCKS];
+    size_t   block_lost[DMA_ARENA_MAX_BLOCKS];           // left over in the free block it was cut from, too small for another row
+
+    /** @brief - add a DMA-capable block of 'bytes' to the arena, false if out of memory or block slots
+     *  'lost' - bytes of the free block it was sized from that could not be used, counted by wasted() */
+    bool grow(size_t bytes, size_t lost = 0) {
+      if (blocks >= DMA_ARENA_MAX_BLOCKS)
+        return false;
+      uint8_t *p = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+      if (!p)
+        return false;
+      block[blocks] = p;
+      block_size[blocks] = bytes;
+      block_used[blocks] = 0;
+      block_lost[blocks] = lost;
+      ++blocks;
+      return true;
+    }
+
+    /** @brief - carve 'bytes' (rounded up to a 32-bit word) out of the first block with room for it, nullptr if none has */
+    void *carve(size_t bytes) {
+      bytes = (bytes + 3) & ~(size_t)3;
+      for (uint8_t i = 0; i < blocks; ++i) {
+        if (block_size[i] - block_used[i] >= bytes) {
+          void *p = block[i] + block_used[i];
+          block_used[i] += bytes;
+          return p;
+        }
+      }
+      return nullptr;
+    }
+
+    size_t reserved() const { size_t n = 0; for (uint8_t i = 0; i < blocks; ++i) n += block_size[i]; return n; }
+    size_t used()     const { size_t n = 0; for (uint8_t i = 0; i < blocks; ++i) n += block_used[i]; return n; }
+    /** @brief - unused block tails plus the remainders of the free blocks the rows were packed into */
+    size_t wasted()   const { size_t n = 0; for (uint8_t i = 0; i < blocks; ++i) n += block_size[i] - block_used[i] + block_lost[i]; return n; }
+
+    void release() {
+      while (blocks)
+        heap_caps_free(block[--blocks]);
+    }
 };
 
 /***************************************************************************************/   
 //C/p'ed from https://ledshield.wordpress.com/2012/11/13/led-brightness-to-your-eye-gamma-correction-no/
 // Example calculator: https://gist.github.com/mathiasvr/19ce1d7b6caeab230934080ae1f1380e
-// need to make sure this would end up in RAM for fastest access
-#ifndef NO_CIE1931
-static const uint8_t DRAM_ATTR lumConvTab[]={ 
+// Only used as the source of the CIE1931 curve when the colour plane lookup tables are built in begin(),
+// defining NO_CIE1931 now just makes the linear curve the default one.
+static const uint8_t lumConvTab[]={ 
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 7, 7, 7, 7, 8, 8, 8, 8, 9, 9, 9, 10, 10, 10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 16, 16, 17, 17, 17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 23, 24, 24, 25, 25, 26, 27, 27, 28, 28, 29, 30, 30, 31, 31, 32, 33, 33, 34, 35, 35, 36, 37, 38, 38, 39, 40, 41, 41, 42, 43, 44, 45, 45, 46, 47, 48, 49, 50, 51, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71, 73, 74, 75, 76, 77, 78, 80, 81, 82, 83, 84, 86, 87, 88, 90, 91, 92, 93, 95, 96, 98, 99, 100, 102, 103, 105, 106, 107, 109, 110, 112, 113, 115, 116, 118, 120, 121, 123, 124, 126, 128, 129, 131, 133, 134, 136, 138, 139, 141, 143, 145, 146, 148, 150, 152, 154, 156, 157, 159, 161, 163, 165, 167, 169, 171, 173, 175, 177, 179, 181, 183, 185, 187, 189, 192, 194, 196, 198, 200, 203, 205, 207, 209, 212, 214, 216, 218, 221, 223, 226, 228, 230, 233, 235, 238, 240, 243, 245, 248, 250, 253, 255, 255};
-#endif
+
+/* Colour plane lookup tables
+ * For every 8-bit channel value the table holds that channel's output bit for every colour depth plane,
+ * gamma already applied. Plane 'n' lives in nibble 'n' of the 32-bit entry, with the R, G and B tables
+ * using bit 0, 1 and 2 of the nibble respectively, so that ORing the three channel entries of a pixel gives
+ * the BGR output bits of all planes at once, ready for the RGB1 (or, shifted, RGB2) position.
+ */
+#define COLOR_PLANE_LUT_BITS          4
+#define COLOR_PLANE_RGB_MASK          0x7
+#define COLOR_PLANE_RGB(_bits, _dpth) (((_bits) >> ((_dpth) * COLOR_PLANE_LUT_BITS)) & COLOR_PLANE_RGB_MASK)
+
+/* Multipliers that copy the BGR bits of a plane into RGB1, RGB2 or both positions of the pixel vector */
+#define COLOR_SPAN_RGB1               (1)
+#define COLOR_SPAN_RGB2               (1 << BITS_RGB2_OFFSET)
+#define COLOR_SPAN_RGB12              (COLOR_SPAN_RGB1 | COLOR_SPAN_RGB2)
 
 /** @brief - configuration values for HUB75_I2S driver
  *  This structure holds configuration vars that are used as
@@ -261,6 +345,11 @@ struct  HUB75_I2S_CFG {
    */
   enum clk_speed {HZ_10M=10000000, HZ_20M=20000000};
 
+  /**
+   * Gamma curve folded into the colour plane lookup tables
+   */
+  enum gamma_curve {GAMMA_CIE1931=0, GAMMA_22, GAMMA_LINEAR};
+
   // Structure Variables
 
   // physical width of a single matrix panel module (in pixels, usually it is 64 ;) )
@@ -283,6 +372,9 @@ struct  HUB75_I2S_CFG {
   clk_speed i2sspeed;
   // use DMA double buffer (twice as much RAM required)
   bool double_buff;
+  // use a third DMA buffer and the present queue (three times as much RAM required), implies double_buff.
+  // Not a constructor argument, set it on the struct before passing it on.
+  bool triple_buff;
   // How many clock cycles to blank OE before/after LAT signal change, default is 1 clock
   uint8_t latch_blanking;
   
@@ -305,6 +397,9 @@ struct  HUB75_I2S_CFG {
   // Minimum refresh / scan rate needs to be configured on start due to LSBMSB_TRANSITION_BIT calculation in allocateDMAmemory()
   uint8_t min_refresh_rate;
 
+  // gamma / brightness correction curve, can be changed at runtime with setGamma()
+  gamma_curve gamma;
+
   // struct constructor
   HUB75_I2S_CFG (
     uint16_t _w = MATRIX_WIDTH,
@@ -319,16 +414,23 @@ struct  HUB75_I2S_CFG {
     clk_speed _i2sspeed = HZ_10M,
     uint8_t _latblk  = 1, // Anything > 1 seems to cause artefacts on ICS panels
     bool _clockphase = true,
-    uint8_t _min_refresh_rate = 85
+    uint8_t _min_refresh_rate = 85,
+#ifndef NO_CIE1931
+    gamma_curve _gamma = GAMMA_CIE1931
+#else
+    gamma_curve _gamma = GAMMA_LINEAR
+#endif
   ) : mx_width(_w),
       mx_height(_h),
       chain_length(_chain),
       gpio(_pinmap),
       driver(_drv), i2sspeed(_i2sspeed),
       double_buff(_dbuff),
+      triple_buff(false),
       latch_blanking(_latblk),
       clkphase(_clockphase),
-      min_refresh_rate (_min_refresh_rate) {}
+      min_refresh_rate (_min_refresh_rate),
+      gamma(_gamma) {}
 }; // end of structure HUB75_I2S_CFG
 
 
@@ -371,7 +473,10 @@ class MatrixPanel_I2S_DMA {
 #elif !defined NO_GFX
       Adafruit_GFX(opts.mx_width*opts.chain_length, opts.mx_height),
 #endif        
-      m_cfg(opts) {}
+      m_cfg(opts) {
+      if (m_cfg.triple_buff)
+        m_cfg.double_buff = true;
+    }
 
     /* Propagate the DMA pin configuration, allocate DMA buffs and start data output, initially blank */
     bool begin(){
@@ -405,6 +510,12 @@ class MatrixPanel_I2S_DMA {
       * Ref: https://github.com/espressif/arduino-esp32/issues/831
       */
       if ( !allocateDMAmemory() ) {  return false; } // couldn't even get the basic ram required.
+
+      // Colour -> bit-plane tables with the configured gamma curve folded in
+      buildColorPlaneLUT();
+
+      if (!brt_lock)
+        brt_lock = xSemaphoreCreateMutex();
         
 
       // Flush the DMA buffers prior to configuring DMA - Avoid visual artefacts on boot.
@@ -413,6 +524,12 @@ class MatrixPanel_I2S_DMA {
       // Setup the ESP32 DMA Engine. Sprite_TM built this stuff.
       configureDMA(m_cfg); //DMA and I2S configuration and setup
 
+      // the present queue is run from the DMA EOF interrupt, buffer 0 is on screen and 1 is drawn on first
+      if (m_cfg.triple_buff) {
+        back_buffer_id = 1;
+        hookVsync();
+      }
+
       //showDMABuffer(); // show backbuf_id of 0
 
       #if SERIAL_DEBUG 
@@ -428,11 +545,14 @@ class MatrixPanel_I2S_DMA {
     ~MatrixPanel_I2S_DMA(){
       stopDMAoutput();
 
-      delete dmadesc_a;
+      // row buffers and descriptor lists all live in the arena
+      releaseDMAmemory();
 
-      if (m_cfg.double_buff)
-        delete dmadesc_b;
+      if (shadow_buff)
+        heap_caps_free(shadow_buff);
 
+      if (brt_lock)
+        vSemaphoreDelete(brt_lock);
     }
 
 
@@ -499,7 +619,108 @@ class MatrixPanel_I2S_DMA {
 #endif 
 
     void drawIcon (int *ico, int16_t x, int16_t y, int16_t cols, int16_t rows);
-    
+
+    /**
+     * @brief - draw a horizontal run of RGB565 pixels in one pass
+     * Much faster than consecutive drawPixel() calls: every pixel pair is converted once
+     * and written to each colour depth bit-plane with a single 32-bit read-modify-write.
+     * @param int16_t x, int16_t y - coordinates of the leftmost pixel, run is clipped to the panel
+     * @param const uint16_t *px - RGB565 pixel data
+     * @param int16_t n - number of pixels in the run
+     */
+    void drawSpanRGB565(int16_t x, int16_t y, const uint16_t *px, int16_t n);
+
+    /**
+     * @brief - convert a palette once, for drawSpanIndexed()
+     * Fills planebits[] with the gamma corrected bit-plane contribution of every RGB565 palette entry.
+     * Goes stale when the gamma curve or colour depth changes, convert again per frame or after such a change.
+     */
+    void paletteToPlaneBits(const uint16_t *palette565, uint32_t *planebits, uint16_t count) const;
+
+    /**
+     * @brief - draw a horizontal run of palette indexed pixels, i.e. a decoded GIF line
+     * With the shadow framebuffer the RGB565 palette entries are stored, otherwise the precomputed bit-plane
+     * contributions are written straight to the DMA buffer: no per-pixel colour conversion at all.
+     * @param const uint8_t *idx - palette indices
+     * @param const uint16_t *palette565 - RGB565 palette
+     * @param const uint32_t *planebits - the same palette run through paletteToPlaneBits()
+     */
+    void drawSpanIndexed(int16_t x, int16_t y, const uint8_t *idx, int16_t n, const uint16_t *palette565, const uint32_t *planebits);
+
+    /**
+     * @brief - draw a block of RGB565 pixels (row-major, w*h elements) using span writes
+     * @param int16_t x, int16_t y - coordinates of a top-left corner
+     * @param int16_t w, int16_t h - width and height of the block
+     * @param const uint16_t *px - RGB565 pixel data
+     */
+    void drawRectRGB565(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *px);
+
+    /**
+     * @brief - draw into an RGB565 shadow framebuffer instead of straight into the DMA bit-planes
+     * The buffer goes to PSRAM when available, internal RAM otherwise. While it is in use every drawing call
+     * is a plain 16-bit write that grows a dirty rectangle, and commit() converts just that rectangle into
+     * the DMA buffer with span writes. Pixels can be read back with getPixel().
+     * RGB888 colours are stored as RGB565. The shadow starts out black and is committed in full on the next commit().
+     * @param bool enable - allocate / free the shadow buffer
+     * @returns - true if the shadow buffer is in use
+     */
+    bool setShadowBuffer(bool enable);
+
+    inline bool hasShadowBuffer() const { return shadow_buff != nullptr; }
+
+    /**
+     * @brief - raw shadow framebuffer, row-major, width() x height() RGB565 pixels, nullptr when not in use
+     * Call markShadowDirty() for the area written directly.
+     */
+    inline uint16_t *getShadowBuffer() { return shadow_buff; }
+
+    /**
+     * @brief - RGB565 colour of a pixel in the shadow framebuffer, 0 (black) without one or off-screen
+     */
+    inline uint16_t getPixel(int16_t x, int16_t y) const {
+      if ( !shadow_buff || x < 0 || y < 0 || x >= PIXELS_PER_ROW || y >= m_cfg.mx_height )
+        return 0;
+      return shadow_buff[y * PIXELS_PER_ROW + x];
+    }
+
+    /**
+     * @brief - grow the shadow dirty rectangle by an area, already clipped to the screen
+     * Safe to call from another core while commit() runs, the area is picked up by this or the next commit().
+     */
+    inline void markShadowDirty(int16_t x, int16_t y, int16_t w, int16_t h) {
+      portENTER_CRITICAL(&shadow_mux);
+      if (x < shadow_x0) shadow_x0 = x;
+      if (y < shadow_y0) shadow_y0 = y;
+      if (x + w - 1 > shadow_x1) shadow_x1 = x + w - 1;
+      if (y + h - 1 > shadow_y1) shadow_y1 = y + h - 1;
+      portEXIT_CRITICAL(&shadow_mux);
+    }
+
+    /**
+     * @brief - convert the dirty rectangle of the shadow framebuffer into the DMA (back) buffer
+     * One RGB565 -> bit-plane span conversion per dirty row. Does nothing without a shadow buffer
+     * or if nothing was drawn since the last commit.
+     */
+    void commit();
+
+    /**
+     * @brief - decode a pixel back from the DMA bit-planes
+     * Returns the per channel levels that are actually clocked out to the panel, i.e. after the gamma curve and
+     * with only the colour planes that are linked at the current colour depth. Meant for checking drawing code
+     * against a reference image, not for compositing (see getPixel() for that).
+     * @param int16_t x, int16_t y - pixel coordinates, off-screen pixels read as black
+     * @param uint8_t &r, &g, &b - refs to variables where the decoded levels would be emplaced
+     * @param uint8_t _buff_id - buffer to read, 0, 1 (double buffering) or 2 (triple buffering)
+     */
+    void readDMAPixel(int16_t x, int16_t y, uint8_t &r, uint8_t &g, uint8_t &b, const uint8_t _buff_id = 0);
+
+    /**
+     * @brief - decode a whole buffer back into an RGB888 image, see readDMAPixel()
+     * @param uint8_t *rgb - width() * height() * 3 bytes, row-major
+     * @param uint8_t _buff_id - buffer to read, see readDMAPixel()
+     */
+    void readDMAFrame(uint8_t *rgb, const uint8_t _buff_id = 0);
+
     // Color 444 is a 4 bit scale, so 0 to 15, color 565 takes a 0-255 bit value, so scale up by 255/15 (i.e. 17)!
     static uint16_t color444(uint8_t r, uint8_t g, uint8_t b) { return color565(r*17,g*17,b*17); }
 
@@ -517,45 +738,112 @@ class MatrixPanel_I2S_DMA {
     static void color565to888(const uint16_t color, uint8_t &r, uint8_t &g, uint8_t &b);
 
 
-    inline void IRAM_ATTR flipDMABuffer() 
+    /**
+     * @brief - show the back buffer and make the previously displayed one the new back buffer
+     * Blocks (the calling task sleeps, no spinning) on the DMA EOF interrupt: once to flip right at the start
+     * of a frame, and once more until the old buffer has been shifted out for the last time and is safe to draw on.
+     */
+    inline void flipDMABuffer() 
     {         
       if ( !m_cfg.double_buff) return;
+
+      // the present queue flips in the DMA interrupt, no waiting unless all three buffers are busy
+      if (m_cfg.triple_buff) {
+        queueFrame();
+        return;
+      }
         
         #if SERIAL_DEBUG     
                 Serial.printf_P(PSTR("Set back buffer to: %d\n"), back_buffer_id);
         #endif      
 
-        i2s_parallel_set_previous_buffer_not_free();       
-        // Wait before we allow any writing to the buffer. Stop flicker.
-        while(i2s_parallel_is_previous_buffer_free() == false) { }       
+        // Sync to the start of a frame, leaves the whole frame time to re-link the chain
+        waitForVsync();
         
         i2s_parallel_flip_to_buffer(ESP32_I2S_DEVICE, back_buffer_id);        
         // Flip to other buffer as the backbuffer. 
         // i.e. Graphic changes happen to this buffer, but aren't displayed until flipDMABuffer() is called again.
         back_buffer_id ^= 1;        
         
-        i2s_parallel_set_previous_buffer_not_free();       
         // Wait before we allow any writing to the buffer. Stop flicker.
-        while(i2s_parallel_is_previous_buffer_free() == false) { }          
-        
-        
-
-
-        
+        waitForVsync();
     }
-        
-    inline void setPanelBrightness(int b)
+
+    /**
+     * @brief - block the calling task until the next frame starts being sent out (DMA EOF interrupt)
+     * @param uint32_t timeout_ms - give up after that long
+     * @returns - false on timeout or if DMA output is not running
+     */
+    inline bool waitForVsync(uint32_t timeout_ms = VSYNC_TIMEOUT_MS)
     {
-      // Change to set the brightness of the display, range of 1 to matrixWidth (i.e. 1 - 64)
-        brightness = b;
-        if (!initialized)
-          return;
-
-        brtCtrlOE(b);
-        if (m_cfg.double_buff)
-                brtCtrlOE(b, 1);
+      if (!initialized)
+        return false;
+      return i2s_parallel_wait_for_frame(pdMS_TO_TICKS(timeout_ms));
     }
 
+    /**
+     * @brief - number of full frames sent out to the panel since begin()
+     */
+    inline uint32_t getFrameCount() const { return i2s_parallel_get_frame_count(); }
+
+    /**
+     * @brief - set a function to be called every time a full frame has been sent out, nullptr to remove
+     * NOTE: called from the DMA interrupt, so it must be short and placed in IRAM (IRAM_ATTR)
+     */
+    inline void setVsyncCallback(callback f) { vsync_cb = f; hookVsync(); }
+
+    /**
+     * @brief - show what has been drawn since the last call and bring the new back buffer up to date
+     * Flips the buffers like flipDMABuffer(), then copies only the rows that were changed in either buffer
+     * since the last sync from the on-screen buffer into the new back buffer. So the back buffer always holds
+     * the frame being displayed and callers can draw just the bits that change instead of repainting everything.
+     * Does nothing (no flip, no wait for vsync) if no rows were touched. Without double buffering it only
+     * resets the dirty row tracking.
+     * With triple buffering the frame is put on the present queue instead and this returns straight away:
+     * the DMA interrupt switches to the newest finished frame at the end of a refresh, a finished frame that
+     * was not on screen yet is dropped for the newer one. Only blocks (one refresh at most) if the frame
+     * before is still waiting to go on screen.
+     */
+    void presentIncremental();
+
+    /**
+     * @brief - triple buffering: show a new frame at most every 'refreshes' refresh frames, for an even
+     * cadence with producers that run ahead. 0 (default) shows every frame as soon as it is finished.
+     */
+    inline void setFramePacing(uint16_t refreshes) { frame_pacing = refreshes; }
+
+    /**
+     * @brief - triple buffering present queue counters
+     * presented - frames that went on screen, dropped - finished frames replaced by a newer one before they
+     * were shown, late - frames that went on screen after their frame pacing slot (setFramePacing())
+     */
+    struct presentStats {
+      uint32_t presented;
+      uint32_t dropped;
+      uint32_t late;
+    };
+
+    inline presentStats getPresentStats() const { return present_stats; }
+    inline void resetPresentStats() { present_stats = presentStats(); }
+
+    /**
+     * @brief - bitmap of DMA rows changed in the back buffer since the last sync
+     * bit 'n' covers DMA row 'n', i.e. both screen rows 'n' and 'n + ROWS_PER_FRAME'
+     */
+    uint32_t getDirtyRows() const { return dirty_rows[back_buffer_id]; }
+
+    /**
+     * @brief - buffer drawing currently goes to, e.g. for readDMAFrame()
+     */
+    inline uint8_t getBackBufferId() const { return back_buffer_id; }
+        
+    /**
+     * @brief - set the brightness of the display, range of 1 to matrixWidth (i.e. 1 - 64)
+     * Only the OE bits between the old and the new level are touched, every word is written once,
+     * so it is cheap enough for slider drags and takes effect without a glitch. Stops a running fade.
+     */
+    void setPanelBrightness(int b);
+
     /**
      * this is just a wrapper to control brightness
      * with an 8-bit value (0-255), very popular in FastLED-based sketches :)
@@ -566,12 +854,86 @@ class MatrixPanel_I2S_DMA {
       setPanelBrightness(b * PIXELS_PER_ROW / 256);
     }
 
+    /**
+     * @brief - fade to a brightness in the background
+     * The DMA interrupt steps the OE bits once per frame sent out, the frame content and the CPU are not
+     * involved. Takes over from a running fade, setPanelBrightness() / setBrightness8() stop it.
+     * @param uint8_t b - 8-bit target brightness, same scale as setBrightness8()
+     * @param uint32_t ms - fade duration, 0 (or shorter than a frame) sets the brightness at once
+     */
+    void fadeTo(uint8_t b, uint32_t ms);
+
+    inline bool isFading() const { return fade_frames_left != 0; }
+
     /**
      * Contains the resulting refresh rate (scan rate) that will be achieved
      * based on the i2sspeed, colour depth and min_refresh_rate requested.
      */
     int calculated_refresh_rate  = 0;         
 
+    /**
+     * @brief - change the refresh (scan) rate while running
+     * Picks the lowest lsbMsbTransitionBit the DMA descriptors allocated in begin() allow that reaches 'hz'
+     * at the configured i2sspeed, then lowers the I2S clock as far as the rate still allows.
+     * Higher rates flicker less but cost more DMA bus bandwidth and, above what begin() picked, colour depth
+     * in the least significant bits. The output is stopped for a moment while the chain is re-linked.
+     * @param uint16_t hz - requested refresh rate
+     * @returns - resulting calculated refresh rate, also put into calculated_refresh_rate
+     */
+    int setRefreshRate(uint16_t hz);
+
+    /**
+     * @brief - refresh rate measured by counting DMA EOF interrupts
+     * A call opens a measurement window, which keeps the EOF interrupt on so that no frame goes uncounted.
+     * The first call at least REFRESH_RATE_WINDOW_MS later closes it, reports the frames counted over it and
+     * lets the interrupt go off again if nothing else needs it. Until a window has been closed (and again
+     * after the scan configuration changed) calculated_refresh_rate is returned.
+     */
+    int getRefreshRate();
+
+    /**
+     * @brief - change the colour depth while running
+     * Only the 'bits' most significant colour planes are linked into the DMA chain, so a frame takes fewer
+     * clocks and the same refresh rate is reached at a lower I2S clock (or a higher rate at the same clock).
+     * Without 'resize' the DMA memory stays as allocated and 'bits' can't go above getStoredColorDepth().
+     * With 'resize' the DMA memory is given back and allocated again for just 'bits' planes, which frees RAM
+     * going down. Going up can fail if the RAM was taken meanwhile, the depth then drops to the most that fits.
+     * If not even MIN_COLOR_DEPTH_BITS fit any more the working buffers are gone and output stays off, so only
+     * resize while no other task allocates DMA capable memory (e.g. before WiFi/BLE are started).
+     * Output stops while the memory is swapped, nothing may draw into the DMA buffers from another task then.
+     * All buffers are cleared, the caller has to redraw (the shadow framebuffer is committed again in full).
+     * @param uint8_t bits - MIN_COLOR_DEPTH_BITS to PIXEL_COLOR_DEPTH_BITS
+     * @param bool resize - allocate the DMA buffers for 'bits' planes
+     * @returns - colour depth now active, 0 if no DMA memory could be allocated at all
+     */
+    uint8_t setColorDepth(uint8_t bits, bool resize = false);
+
+    inline uint8_t getColorDepth() const { return active_color_depth; }
+
+    /**
+     * @brief - colour planes the DMA buffers hold, PIXEL_COLOR_DEPTH_BITS unless setColorDepth() resized them
+     */
+    inline uint8_t getStoredColorDepth() const { return dma_planes; }
+
+    /**
+     * @brief - temporal dithering of the colour bits below the active colour depth
+     * A 4x4 ordered dither pattern steps through 16 phases with the refresh frame counter, and a commit() that
+     * finds the phase changed renders the whole shadow framebuffer again with it. Each pixel is rounded up or
+     * down by one step of the reduced depth in the right proportion of frames, so 5 or 6 linked planes average
+     * out to the 8-bit colour instead of banding. Needs the shadow framebuffer, does nothing at 8-bit colour depth.
+     * Costs one full commit() per phase change, and the redraw can tear without double buffering.
+     * @param bool enable
+     * @returns - true if dithering is on
+     */
+    bool setDither(bool enable);
+
+    inline bool getDither() const { return dither; }
+
+    /**
+     * @brief - DMA memory layout: number of blocks, their sizes, bytes used and wasted (see dmaArena)
+     */
+    inline const dmaArena& getDMAArena() const { return dma_arena; }
+
     /**
      * @brief - Sets how many clock cycles to blank OE before/after LAT signal change
      * @param uint8_t pulses - clocks before/after OE
@@ -581,6 +943,14 @@ class MatrixPanel_I2S_DMA {
      */
     uint8_t setLatBlanking(uint8_t pulses);
 
+    /**
+     * @brief - select the gamma curve applied to all colours drawn from now on
+     * Rebuilds the colour plane lookup tables, whatever is already in the DMA buffer is not touched,
+     * so repaint the screen afterwards.
+     * @param gamma_curve g - GAMMA_CIE1931, GAMMA_22 or GAMMA_LINEAR
+     */
+    void setGamma(HUB75_I2S_CFG::gamma_curve g);
+
     /**
      * Get a class configuration struct
      * 
@@ -610,7 +980,7 @@ class MatrixPanel_I2S_DMA {
      * This effectively clears buffers to blank BLACK and makes it ready to display output.
      * (Brightness control via OE bit manipulation is another case)
      */
-    void clearFrameBuffer(bool _buff_id = 0);
+    void clearFrameBuffer(uint8_t _buff_id = 0);
 
     /* Update a specific pixel in the DMA buffer to a colour */
     void updateMatrixDMABuffer(int16_t x, int16_t y, uint8_t red, uint8_t green, uint8_t blue);
@@ -622,12 +992,66 @@ class MatrixPanel_I2S_DMA {
      * wipes DMA buffer(s) and reset all color/service bits
      */
     inline void resetbuffers(){
-      clearFrameBuffer();
-      brtCtrlOE(brightness);
-      if (m_cfg.double_buff){
-        clearFrameBuffer(1); 
-        brtCtrlOE(brightness, 1);
+      for (uint8_t _buff_id = 0; _buff_id < frameBuffers(); _buff_id++) {
+        clearFrameBuffer(_buff_id);
+        brtCtrlOE(brightness, _buff_id);
+        // all buffers hold the same blank frame now
+        dirty_rows[_buff_id] = stale_rows[_buff_id] = 0;
+      }
+    }
+
+    /**
+     * @brief - number of DMA buffers, 1, 2 (double buffering) or 3 (triple buffering)
+     */
+    __attribute__((always_inline)) inline uint8_t frameBuffers() const { return m_cfg.triple_buff ? 3 : (m_cfg.double_buff ? 2 : 1); }
+
+    /**
+     * @brief - DMA descriptor chain of a buffer
+     */
+    inline lldesc_t *dmaChain(uint8_t _buff_id) const { return _buff_id == 2 ? dmadesc_c : (_buff_id ? dmadesc_b : dmadesc_a); }
+
+    /* Point the end of every chain at a buffer, the DMA moves on to it when the current frame is done */
+    void linkChainsTo(uint8_t _buff_id);
+
+    /* Triple buffering: queue the back buffer, return the buffer to draw on next */
+    int8_t queueFrame();
+
+    /* Present queue step from the DMA interrupt */
+    void queueStep();
+
+    /* Copy DMA rows (bitmap of row indexes) between buffers, OE bits included, see presentIncremental() */
+    void syncRows(uint32_t rows, uint8_t _to_id, uint8_t _from_id);
+
+    /**
+     * @brief - colour plane the DMA chain starts at, planes below it are not linked with a reduced colour depth
+     */
+    __attribute__((always_inline)) inline uint8_t firstColorPlane() const { return PIXEL_COLOR_DEPTH_BITS - active_color_depth; }
+
+    /**
+     * @brief - lowest colour plane the DMA buffers hold, drawing skips the planes below it
+     */
+    __attribute__((always_inline)) inline uint8_t firstStoredPlane() const { return PIXEL_COLOR_DEPTH_BITS - dma_planes; }
+
+    /**
+     * @brief - bitmap with a bit set for every DMA row, ROWS_PER_FRAME is at most 32 (5 address lines ABCDE)
+     */
+    inline uint32_t allRowsMask() const { return (uint32_t)((1ULL << ROWS_PER_FRAME) - 1); }
+
+    /**
+     * @brief - flag DMA row(s) of the back buffer as changed
+     * @param int16_t y_coord - first screen row (0 - mx_height-1), rows of the bottom half fold onto the same DMA rows
+     * @param int16_t l - number of screen rows
+     */
+    inline void markRowsDirty(int16_t y_coord, int16_t l = 1){
+      if (l >= ROWS_PER_FRAME) {
+        dirty_rows[back_buffer_id] = allRowsMask();
+        return;
       }
+      if (y_coord >= ROWS_PER_FRAME)
+        y_coord -= ROWS_PER_FRAME;
+      uint64_t rows = ((1ULL << l) - 1) << y_coord;
+      rows |= rows >> ROWS_PER_FRAME;           // part of the run that crossed into the bottom half
+      dirty_rows[back_buffer_id] |= (uint32_t)rows & allRowsMask();
     }
 
 
@@ -652,7 +1076,7 @@ class MatrixPanel_I2S_DMA {
 
     /**
      * @brief - update DMA buff drawing a rectangular at specified coordinates
-     * uses Fast H/V line draw internally, works faster than multiple consecutive pixel by pixel calls to updateMatrixDMABuffer()
+     * fills DMA rows a pixel pair at a time, works faster than multiple consecutive pixel by pixel calls to updateMatrixDMABuffer()
      * @param int16_t x, int16_t y - coordinates of a top-left corner
      * @param int16_t w, int16_t h - width and height of a rectangular, min is 1 px
      * @param uint8_t r - RGB888 color
@@ -662,6 +1086,76 @@ class MatrixPanel_I2S_DMA {
     void fillRectDMA(int16_t x_coord, int16_t y_coord, int16_t w, int16_t h, uint8_t r, uint8_t g, uint8_t b);
 #endif
 
+    /**
+     * @brief - write a run of RGB565 pixels to the DMA buffer, the run must be clipped to the screen already
+     * Bypasses the shadow framebuffer, used by drawSpanRGB565() and commit()
+     * @param dither_row - 4 dither thresholds for this row (x & 3), nullptr for no dithering
+     */
+    void spanDMA(int16_t x_coord, int16_t y_coord, const uint16_t *px, int16_t n, const uint8_t *dither_row = nullptr);
+
+    /**
+     * @brief - fill a run of one DMA row with a single colour in every colour depth plane of the back buffer
+     * @param x_coord - first pixel, run must be clipped to the row already
+     * @param row_idx - DMA row (0 - ROWS_PER_FRAME-1)
+     * @param l - run length
+     * @param planebits - colour plane bits, see colorPlaneBits()
+     * @param _colorbitclear - BITMASK_RGB1_CLEAR, BITMASK_RGB2_CLEAR or BITMASK_RGB12_CLEAR
+     * @param _colorspread - matching COLOR_SPAN_RGB1, COLOR_SPAN_RGB2 or COLOR_SPAN_RGB12
+     */
+    void fillSpanDMA(int16_t x_coord, int16_t row_idx, int16_t l, uint32_t planebits, uint16_t _colorbitclear, uint8_t _colorspread);
+
+    /**
+     * @brief - fill an area of the shadow framebuffer, already clipped to the screen
+     */
+    void shadowFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+    /**
+     * @brief - whole shadow framebuffer needs to go into the DMA buffer again, i.e. after it was re-initialised
+     */
+    inline void markShadowAllDirty() { markShadowDirty(0, 0, PIXELS_PER_ROW, m_cfg.mx_height); }
+
+    /**
+     * @brief - look up the output bits of all colour depth planes for an RGB888 colour, see COLOR_PLANE_RGB()
+     */
+    inline uint32_t colorPlaneBits(uint8_t red, uint8_t green, uint8_t blue) const {
+      return colorPlaneLUT[0][red] | colorPlaneLUT[1][green] | colorPlaneLUT[2][blue];
+    }
+
+    /**
+     * @brief - same as colorPlaneBits() for an RGB565 colour
+     */
+    inline uint32_t colorPlaneBits565(uint16_t color) const {
+      uint8_t r, g, b;
+      color565to888(color, r, g, b);
+      return colorPlaneLUT[0][r] | colorPlaneLUT[1][g] | colorPlaneLUT[2][b];
+    }
+
+    /**
+     * @brief - output bits of a gamma corrected 8-bit level for one channel, every bit spread to its own LUT nibble
+     */
+    static inline uint32_t lumPlaneBits(uint16_t lum) {
+      uint32_t v = (lum > 255 ? 255 : lum);
+    #if PIXEL_COLOR_DEPTH_BITS < 8
+      v >>= MASK_OFFSET;
+    #endif
+      v = (v | (v << 12)) & 0x000F000F;
+      v = (v | (v << 6))  & 0x03030303;
+      v = (v | (v << 3))  & 0x11111111;
+      return v;
+    }
+
+    /**
+     * @brief - colorPlaneBits565() with a dither threshold added to the gamma corrected levels
+     */
+    inline uint32_t colorPlaneBitsDither(uint16_t color, uint8_t threshold) const {
+      uint8_t r, g, b;
+      color565to888(color, r, g, b);
+      return lumPlaneBits(lumLUT[r] + threshold) | (lumPlaneBits(lumLUT[g] + threshold) << 1) | (lumPlaneBits(lumLUT[b] + threshold) << 2);
+    }
+
+    /* Dithering does anything at the current colour depth */
+    inline bool ditherActive() const { return dither && shadow_buff && active_color_depth < 8; }
+
    // ------- PRIVATE -------
   private:
 
@@ -677,16 +1171,58 @@ class MatrixPanel_I2S_DMA {
     // Other private variables
     bool initialized          = false;
     int  back_buffer_id       = 0;                       // If using double buffer, which one is NOT active (ie. being displayed) to write too?
-    int  brightness           = 32;                      // If you get ghosting... reduce brightness level. 60 seems to be the limit before ghosting on a 64 pixel wide physical panel for some panels.
+    uint32_t dirty_rows[3]    = {0, 0, 0};               // Per buffer, DMA rows changed since the last presentIncremental() sync
+    uint32_t stale_rows[3]    = {0, 0, 0};               // Triple buffering: per buffer, DMA rows behind the newest presented frame
+
+    // Triple buffering present queue, see presentIncremental(). Buffer ids, -1 for none. queue_mux guards them
+    volatile int8_t front_buffer_id  = 0;                // being sent out
+    volatile int8_t linked_buffer_id = -1;               // chains lead into it, on screen from the next refresh
+    volatile int8_t queued_buffer_id = -1;               // finished, waiting for the interrupt to link it
+    volatile uint16_t front_refreshes = 0;               // refresh frames the front buffer will have been shown by the next EOF
+    uint16_t frame_pacing     = 0;                       // see setFramePacing()
+    presentStats present_stats = {0, 0, 0};
+    portMUX_TYPE queue_mux    = portMUX_INITIALIZER_UNLOCKED;
+
+    // RGB565 shadow framebuffer, see setShadowBuffer(). Dirty rectangle is empty while x0 > x1, shadow_mux guards it
+    uint16_t *shadow_buff     = nullptr;
+    int16_t  shadow_x0 = INT16_MAX, shadow_y0 = INT16_MAX, shadow_x1 = -1, shadow_y1 = -1;
+    portMUX_TYPE shadow_mux   = portMUX_INITIALIZER_UNLOCKED;
+    volatile int brightness   = 32;                      // If you get ghosting... reduce brightness level. 60 seems to be the limit before ghosting on a 64 pixel wide physical panel for some panels.
+
+    // Brightness fade stepped by the DMA EOF interrupt, see fadeTo(). brt_mux guards the fade and 'brightness',
+    // the interrupt only touches OE bits while a fade runs. brt_lock serialises OE rewrites from tasks
+    int      fade_from = 0, fade_to = 0;
+    uint32_t fade_frames = 0;
+    volatile uint32_t fade_frames_left = 0;
+    bool     fade_hooked = false;                        // vsyncISR() installed for a fade, removed by presentIncremental() once it ran out
+    callback vsync_cb = nullptr;                         // user's vsync callback, see setVsyncCallback()
+    portMUX_TYPE brt_mux = portMUX_INITIALIZER_UNLOCKED;
+    SemaphoreHandle_t brt_lock = nullptr;
+    rowBitStruct *dma_rows    = nullptr;                 // dma_buff.rowStore.data(), for the interrupt
     int  lsbMsbTransitionBit  = 0;                       // For colour depth calculations
+    int  lsbMsbTransitionBitMin = 0;                     // lsbMsbTransitionBit the DMA descriptors were allocated for, can't go lower at runtime
+    uint32_t i2s_clock_hz     = 0;                       // I2S output clock currently set
+    uint16_t refresh_rate_target = 0;                    // Last setRefreshRate() request, 0 - min_refresh_rate from the config
+    uint8_t  active_color_depth  = PIXEL_COLOR_DEPTH_BITS; // Colour planes linked into the DMA chain, see setColorDepth()
+    uint8_t  dma_planes          = PIXEL_COLOR_DEPTH_BITS; // Colour planes allocated per row, the top ones, active_color_depth or more
+
+    // Refresh rate measurement from the frame counter
+    uint32_t rate_sample_us      = 0;
+    uint32_t rate_sample_frames  = 0;
+    int      measured_refresh_rate = 0;
+    bool     rate_window_open    = false;   // getRefreshRate() is counting frames, keeps the EOF interrupt on
     
 
     // *** DMA FRAMEBUFFER structures
 
+    // DMA-capable memory the frame buffer rows and descriptor lists are carved from
+    dmaArena dma_arena;
+
     // ESP 32 DMA Linked List descriptor
     int desccount        = 0;
     lldesc_t * dmadesc_a = {0}; 
     lldesc_t * dmadesc_b = {0};
+    lldesc_t * dmadesc_c = {0};                          // triple buffering only
 
     /* Pixel data is organized from LSB to MSB sequentially by row, from row 0 to row matrixHeight/matrixRowsInParallel 
      * (two rows of pixels are refreshed in parallel) 
@@ -697,13 +1233,46 @@ class MatrixPanel_I2S_DMA {
      */
     frameStruct dma_buff;
 
+    /* Per channel (R, G, B) colour value -> output bits for every colour depth plane, gamma folded in.
+     * Built by buildColorPlaneLUT() on begin() and whenever the gamma curve changes.
+     */
+    uint32_t colorPlaneLUT[COLOR_CHANNELS_PER_PIXEL][256];
+
+    /* Colour value -> gamma corrected 8-bit level, same curve as colorPlaneLUT, for dithering */
+    uint8_t lumLUT[256];
+
+    // Temporal dithering, see setDither(). dither_phase is the frame counter step the DMA buffer was rendered with
+    bool dither = false;
+    uint8_t dither_phase = 0;
+
+    /* Fill colorPlaneLUT for the current m_cfg.gamma curve */
+    void buildColorPlaneLUT();
+
 
     /* Calculate the memory available for DMA use, do some other stuff, and allocate accordingly */
     bool allocateDMAmemory();
 
+    /* Give back everything allocateDMAmemory() carved out of the arena */
+    void releaseDMAmemory();
+
+    /* Stop output, allocate the DMA buffers again for 'bits' planes (or the most that fit) and restart */
+    bool resizeDMAmemory(uint8_t bits);
+
     /* Setup the DMA Link List chain and initiate the ESP32 DMA engine */
     void configureDMA(const HUB75_I2S_CFG& opts);
 
+    /* Link the DMA descriptor chain(s) for the current lsbMsbTransitionBit */
+    void linkDMAchains();
+
+    /* Number of DMA descriptors a row takes with the given lsbMsbTransitionBit */
+    int dmaDescriptorsPerRow(int transition_bit) const;
+
+    /* Number of I2S clocks it takes to send out a whole frame with the given lsbMsbTransitionBit */
+    uint32_t clocksPerFrame(int transition_bit) const;
+
+    /* Apply refresh_rate_target and active_color_depth to the running DMA output */
+    int applyScanConfig(bool depth_changed);
+
     /**
      * pre-init procedures for specific drivers
      * 
@@ -720,7 +1289,77 @@ class MatrixPanel_I2S_DMA {
      * @param brt - brightness level from 0 to row_width
      * @param _buff_id - buffer id to control
      */
-    void brtCtrlOE(int brt, const bool _buff_id=0);
+    void brtCtrlOE(int brt, const uint8_t _buff_id=0);
+
+    /**
+     * @brief - change OE bits of a buffer from brightness 'from' to 'to', touching only words that change
+     * Runs in the DMA interrupt during a fade, so it and the helpers below stay in IRAM (forced inline, raw row pointers)
+     * @param _buff_id - buffer id to control
+     */
+    void brtAdjustOE(int from, int to, const uint8_t _buff_id=0);
+
+    /* Can't control values larger than (row_width - latch_blanking) to avoid ongoing issues being raised about brightness and ghosting. */
+    __attribute__((always_inline)) inline int clampBrightness(int brt) const {
+      if (brt > PIXELS_PER_ROW - (MAX_LAT_BLANKING + 2))    // +2 for a bit of buffer...
+        brt = PIXELS_PER_ROW - (MAX_LAT_BLANKING + 2);
+      return brt < 0 ? 0 : brt;
+    }
+
+    /* Pixel index (in DMA memory order) from which OE disables the output for a colour plane */
+    __attribute__((always_inline)) inline int oeThreshold(int brt, uint8_t coloridx) const {
+      const uint8_t first_coloridx = firstColorPlane();
+      // first colour index sent out for a row shows the previous row at full brightness
+      if (coloridx > lsbMsbTransitionBit || coloridx == first_coloridx)
+        return brt;
+      // special case for the bits *after* LSB through (lsbMsbTransitionBit) - OE is output after data is shifted, so need to set OE to fractional brightness
+      // divide brightness in half for each bit below lsbMsbTransitionBit
+      if (coloridx > first_coloridx)
+        return brt >> (lsbMsbTransitionBit - coloridx + 1);
+      // plane is not linked, leave output enabled
+      return PIXELS_PER_ROW;
+    }
+
+    /* OE is disabled for latch_blanking clocks before/after latch to hide row transition. Should be one clock or more before latch, otherwise can get ghosting */
+    __attribute__((always_inline)) inline bool oeBlanked(int x_coord) const {
+    #ifdef ESP32_SXXX
+      return x_coord < m_cfg.latch_blanking;
+    #else
+      // Original ESP32 WROOM FIFO Ordering Sucks
+      return (x_coord ^ 1) < m_cfg.latch_blanking;
+    #endif
+    }
+
+    /**
+     * @brief - pixel pair writer behind spanDMA() and drawSpanIndexed(), the run must be clipped to the screen already
+     * @param planeBitsAt - callable (int16_t i, int16_t x) returning the colour plane bits of the i-th pixel of the run
+     */
+    template <typename PlaneBitsAt>
+    void spanBitsDMA(int16_t x_coord, int16_t y_coord, int16_t n, PlaneBitsAt planeBitsAt);
+
+    /**
+     * @brief - write a single RGB565 pixel of a span into the DMA row at its FIFO-ordered position
+     * @param ESP32_I2S_DMA_STORAGE_TYPE *p - pointer to the colour depth plane 0 of the row (back buffer)
+     * @param size_t plane_stride - distance in elements between two colour depth planes
+     * @param x_coord - pixel x coordinate (before TX FIFO reordering)
+     * @param _colorbitclear, _colorbitoffset - RGB1/RGB2 half selectors
+     */
+    void spanPixelDMA(ESP32_I2S_DMA_STORAGE_TYPE *p, size_t plane_stride, int16_t x_coord, uint32_t planebits, uint16_t _colorbitclear, uint8_t _colorbitoffset);
+
+    /* Fade step from the DMA interrupt */
+    void fadeStep();
+
+    /* Handler installed as the DMA EOF callback, runs the fade and the user's vsync callback */
+    static void vsyncISR();
+    static MatrixPanel_I2S_DMA *vsync_owner;
+
+    /* Install vsyncISR() while something needs it, remove it otherwise so the EOF interrupt can stay off */
+    inline void hookVsync()
+    {
+      vsync_owner = this;
+      // dithering only needs the frame counter, which runs while the EOF interrupt is on
+      const bool needed = m_cfg.triple_buff || fade_frames_left || dither || vsync_cb || rate_window_open;
+      setShiftCompleteCallback(needed ? vsyncISR : nullptr);
+    }
 
 
 }; // end Class header
@@ -742,6 +1381,14 @@ inline void MatrixPanel_I2S_DMA::color565to888(const uint16_t color, uint8_t &r,
 
 inline void MatrixPanel_I2S_DMA::drawPixel(int16_t x, int16_t y, uint16_t color) // adafruit virtual void override
 {
+  if (shadow_buff) {
+    if ( x < 0 || y < 0 || x >= PIXELS_PER_ROW || y >= m_cfg.mx_height )
+      return;
+    shadow_buff[y * PIXELS_PER_ROW + x] = color;
+    markShadowDirty(x, y, 1, 1);
+    return;
+  }
+
   uint8_t r,g,b;
   color565to888(color,r,g,b);
   
@@ -750,6 +1397,11 @@ inline void MatrixPanel_I2S_DMA::drawPixel(int16_t x, int16_t y, uint16_t color)
 
 inline void MatrixPanel_I2S_DMA::fillScreen(uint16_t color)  // adafruit virtual void override
 {
+  if (shadow_buff) {
+    shadowFill(0, 0, PIXELS_PER_ROW, m_cfg.mx_height, color);
+    return;
+  }
+
   uint8_t r,g,b;
   color565to888(color,r,g,b);
   
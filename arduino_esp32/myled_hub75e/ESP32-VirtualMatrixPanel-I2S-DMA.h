@@ -34,6 +34,14 @@ struct VirtualCoords {
 	  
 };
 
+/* One entry of the precomputed coordinate map (see buildCoordMap()): where the first pixel of a
+ * segment of a virtual row lands in the DMA buffer, and which way along the DMA row the rest follow. */
+struct VirtualSegment {
+  int16_t x;
+  int16_t y;
+  int8_t  dir; // +1 or -1
+};
+
 enum PANEL_SCAN_RATE {NORMAL_ONE_SIXTEEN, ONE_EIGHT_32, ONE_EIGHT_16};
 
 #ifdef USE_GFX_ROOT
@@ -95,6 +103,12 @@ class VirtualMatrixPanel
 
     }
 
+    ~VirtualMatrixPanel() { clearCoordMap(); }
+
+    // owns seg_map, a copy would free it twice
+    VirtualMatrixPanel(const VirtualMatrixPanel &) = delete;
+    VirtualMatrixPanel &operator=(const VirtualMatrixPanel &) = delete;
+
     // equivalent methods of the matrix library so it can be just swapped out.
     virtual void drawPixel(int16_t x, int16_t y, uint16_t color);
     virtual void fillScreen(uint16_t color); // overwrite adafruit implementation
@@ -112,10 +126,51 @@ class VirtualMatrixPanel
 	
 	void setPhysicalPanelScanRate(PANEL_SCAN_RATE rate);
 
+	/**
+	 * @brief - precompute the virtual->DMA co-ordinate mapping instead of working it out per pixel
+	 * Each virtual row is cut into equal power-of-two wide segments that map onto a straight run of
+	 * DMA pixels, so a pixel lookup is one table read plus a shift and a mask, and spans / rects are
+	 * forwarded to the DMA buffer as a handful of fillRect() / drawSpanRGB565() calls.
+	 * A 4x 64x64 panel chain needs a few hundred bytes. Call again after changing the chain layout
+	 * in a subclass; setPhysicalPanelScanRate() rebuilds it by itself.
+	 * @returns - false if the table could not be allocated (getCoords() keeps being used then)
+	 */
+	bool buildCoordMap();
+	void clearCoordMap();
+	inline bool hasCoordMap() const { return seg_map != nullptr; }
+
+#ifndef NO_FAST_FUNCTIONS
+    virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+    virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+    virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+      uint8_t r, g, b;
+      MatrixPanel_I2S_DMA::color565to888(color, r, g, b);
+      fillRect(x, y, w, h, r, g, b);
+    }
+    // rgb888 overload
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t r, uint8_t g, uint8_t b);
+
+	/**
+	 * @brief - draw a horizontal run of RGB565 pixels, one drawSpanRGB565() per map segment
+	 */
+    void drawSpanRGB565(int16_t x, int16_t y, const uint16_t *px, int16_t n);
+    void drawRectRGB565(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *px);
+#endif
+
   protected:
   
     virtual VirtualCoords getCoords(int16_t &x, int16_t &y); 
     VirtualCoords coords;
+
+    // getCoords() through the coordinate map when there is one
+    void mapCoords(int16_t x, int16_t y);
+
+    // fill a rect given in unrotated, clipped map co-ordinates
+    void fillMappedRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t r, uint8_t g, uint8_t b);
+
+    VirtualSegment *seg_map = nullptr; // virtualResY rows of segs_per_row entries
+    int16_t segs_per_row    = 0;
+    uint8_t seg_shift       = 0;       // segment width is 1 << seg_shift
 	
     bool _s_chain_party  = true; // Are we chained? Ain't no party like a... 
     bool _chain_top_down = false; // is the ESP at the top or bottom of the matrix of devices?
@@ -257,8 +312,105 @@ inline VirtualCoords VirtualMatrixPanel::getCoords(int16_t &x, int16_t &y) {
 	return coords; 
 }
 
+/**
+ * Build the segment table by walking getCoords() over the whole (unrotated) virtual display.
+ * First pass finds every x where the DMA pixels stop following on in a straight line from the
+ * previous one; the segment width is the largest power of two all those breaks fall on.
+ */
+inline bool VirtualMatrixPanel::buildCoordMap() {
+
+	clearCoordMap();
+
+	// rotation is applied before the lookup, keep it out of the table
+	bool rotate = _rotate;
+	_rotate = false;
+
+	uint16_t breaks = virtualResX;
+	for (int16_t y = 0; y < virtualResY; y++)
+	{
+		int16_t px = 0, py = 0, dir = 0;
+		for (int16_t x = 0; x < virtualResX; x++)
+		{
+			int16_t vx = x, vy = y;
+			getCoords(vx, vy);
+
+			int16_t dx = coords.x - px;
+			if (x == 0 || coords.y != py || (dx != 1 && dx != -1) || (dir != 0 && dx != dir)) {
+				breaks |= x;
+				dir = 0;
+			} else {
+				dir = dx;
+			}
+			px = coords.x;
+			py = coords.y;
+		}
+	}
+
+	seg_shift = 0;
+	while (!(breaks & (1 << seg_shift)))
+		seg_shift++;
+	segs_per_row = virtualResX >> seg_shift;
+
+	seg_map = (VirtualSegment *)heap_caps_malloc(virtualResY * segs_per_row * sizeof(VirtualSegment), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+	if (seg_map)
+	{
+		for (int16_t y = 0; y < virtualResY; y++)
+		{
+			for (int16_t j = 0; j < segs_per_row; j++)
+			{
+				VirtualSegment &s = seg_map[y * segs_per_row + j];
+				int16_t vx = j << seg_shift, vy = y;
+				getCoords(vx, vy);
+				s.x = coords.x;
+				s.y = coords.y;
+				s.dir = 1;
+
+				if (seg_shift) {
+					vx = (j << seg_shift) + 1; vy = y;
+					getCoords(vx, vy);
+					s.dir = coords.x - s.x;
+				}
+			}
+		}
+	}
+
+	_rotate = rotate;
+	coords.x = coords.y = -1;
+
+	return seg_map != nullptr;
+}
+
+inline void VirtualMatrixPanel::clearCoordMap() {
+	if (seg_map)
+		heap_caps_free(seg_map);
+	seg_map = nullptr;
+}
+
+inline void VirtualMatrixPanel::mapCoords(int16_t x, int16_t y) {
+
+	if (!seg_map) {
+		getCoords(x, y);
+		return;
+	}
+
+	if (_rotate) {
+		int16_t temp_x=x;
+		x=y;
+		y=virtualResY-1-temp_x;
+	}
+
+	if ( x < 0 || x >= virtualResX || y < 0 || y >= virtualResY ) {
+		coords.x = coords.y = -1;
+		return;
+	}
+
+	const VirtualSegment &s = seg_map[y * segs_per_row + (x >> seg_shift)];
+	coords.x = s.x + s.dir * (x & ((1 << seg_shift) - 1));
+	coords.y = s.y;
+}
+
 inline void VirtualMatrixPanel::drawPixel(int16_t x, int16_t y, uint16_t color) { // adafruit virtual void override
-  getCoords(x, y);
+  mapCoords(x, y);
   this->display->drawPixel(coords.x, coords.y, color);
 }
 
@@ -271,7 +423,7 @@ inline void VirtualMatrixPanel::fillScreenRGB888(uint8_t r, uint8_t g,uint8_t b)
 }
 
 inline void VirtualMatrixPanel::drawPixelRGB888(int16_t x, int16_t y, uint8_t r, uint8_t g, uint8_t b) {
-  getCoords(x, y);
+  mapCoords(x, y);
   this->display->drawPixelRGB888( coords.x, coords.y, r, g, b);
 }
 
@@ -286,8 +438,113 @@ inline void VirtualMatrixPanel::setRotate(bool rotate) {
 
 inline void VirtualMatrixPanel::setPhysicalPanelScanRate(PANEL_SCAN_RATE rate) {
 	_panelScanRate=rate;
+
+	if (seg_map)
+		buildCoordMap();
+}
+
+#ifndef NO_FAST_FUNCTIONS
+/**
+ * Walk the rect one segment column at a time. Within a segment column every virtual row is one
+ * straight DMA span; consecutive virtual rows landing on adjacent DMA rows at the same x are
+ * merged so a panel-sized area goes down as a single fillRect() on the underlying display.
+ */
+inline void VirtualMatrixPanel::fillMappedRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t r, uint8_t g, uint8_t b) {
+
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if (x + w > virtualResX) w = virtualResX - x;
+	if (y + h > virtualResY) h = virtualResY - y;
+	if (w <= 0 || h <= 0)
+		return;
+
+	for (int16_t j = x >> seg_shift; j <= (x + w - 1) >> seg_shift; j++)
+	{
+		int16_t seg_x0 = j << seg_shift;
+		int16_t xs = max(x, seg_x0) - seg_x0;                                   // first offset in the segment
+		int16_t xe = min((int16_t)(x + w), (int16_t)(seg_x0 + (1 << seg_shift))) - seg_x0; // one past the last
+		int16_t len = xe - xs;
+
+		int16_t run_x = 0, run_lo = 0, run_hi = -1;
+		for (int16_t row = y; row < y + h; row++)
+		{
+			const VirtualSegment &s = seg_map[row * segs_per_row + j];
+			int16_t dx = (s.dir > 0) ? s.x + xs : s.x - (xe - 1);
+
+			if (run_hi >= run_lo && dx == run_x && s.y == run_hi + 1) {
+				run_hi++;
+			} else if (run_hi >= run_lo && dx == run_x && s.y == run_lo - 1) {
+				run_lo--;
+			} else {
+				if (run_hi >= run_lo)
+					display->fillRect(run_x, run_lo, len, run_hi - run_lo + 1, r, g, b);
+				run_x = dx;
+				run_lo = run_hi = s.y;
+			}
+		}
+		display->fillRect(run_x, run_lo, len, run_hi - run_lo + 1, r, g, b);
+	}
+}
+
+inline void VirtualMatrixPanel::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t r, uint8_t g, uint8_t b) {
+
+	if (!seg_map) {
+		for (int16_t j = y; j < y + h; j++)
+			for (int16_t i = x; i < x + w; i++)
+				drawPixelRGB888(i, j, r, g, b);
+		return;
+	}
+
+	if (_rotate)	// same transform as getCoords(), x'=y, y'=virtualResY-1-x
+		fillMappedRect(y, virtualResY - x - w, h, w, r, g, b);
+	else
+		fillMappedRect(x, y, w, h, r, g, b);
 }
 
+inline void VirtualMatrixPanel::drawSpanRGB565(int16_t x, int16_t y, const uint16_t *px, int16_t n) {
+
+	// a rotated span runs down a column of the map, no straight DMA runs to forward
+	if (!seg_map || _rotate) {
+		for (int16_t i = 0; i < n; i++)
+			drawPixel(x + i, y, px[i]);
+		return;
+	}
+
+	if (y < 0 || y >= virtualResY)
+		return;
+	if (x < 0) { px -= x; n += x; x = 0; }
+	if (x + n > virtualResX) n = virtualResX - x;
+
+	uint16_t tmp[32];	// reversed pixels for segments that run right to left in the DMA buffer
+	while (n > 0)
+	{
+		const VirtualSegment &s = seg_map[y * segs_per_row + (x >> seg_shift)];
+		int16_t off = x & ((1 << seg_shift) - 1);
+		int16_t len = min(n, (int16_t)((1 << seg_shift) - off));
+
+		if (s.dir > 0) {
+			display->drawSpanRGB565(s.x + off, s.y, px, len);
+		} else {
+			// pixel off+i lands at s.x-off-i, write it out left to right in chunks
+			for (int16_t done = 0; done < len; ) {
+				int16_t c = min((int16_t)(len - done), (int16_t)32);
+				for (int16_t i = 0; i < c; i++)
+					tmp[i] = px[done + c - 1 - i];
+				display->drawSpanRGB565(s.x - off - done - c + 1, s.y, tmp, c);
+				done += c;
+			}
+		}
+
+		x += len; px += len; n -= len;
+	}
+}
+
+inline void VirtualMatrixPanel::drawRectRGB565(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *px) {
+	for (int16_t j = 0; j < h; j++)
+		drawSpanRGB565(x, y + j, px + j * w, w);
+}
+#endif
+
 
 
 #ifndef NO_GFX
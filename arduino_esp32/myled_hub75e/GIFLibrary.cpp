@@ -0,0 +1,512 @@
+#include "GIFLibrary.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#define FILESYSTEM LittleFS
+
+// 写入内存中的GIF时每次写入的字节数，块之间让出CPU
+#define GIF_LIBRARY_WRITE_CHUNK 4096
+// 哈希相同时比较内容，每次读取的字节数（在栈上）
+#define GIF_LIBRARY_VERIFY_CHUNK 256
+
+GIFLibrary::Entry GIFLibrary::entries[GIF_LIBRARY_MAX_ENTRIES];
+int GIFLibrary::entryCount = 0;
+uint32_t GIFLibrary::useCounter = 0;
+char GIFLibrary::selection[GIF_PATH_SIZE];
+bool GIFLibrary::selectionPending = false;
+uint32_t GIFLibrary::activeId = 0;
+bool GIFLibrary::activeValid = false;
+portMUX_TYPE GIFLibrary::mux = portMUX_INITIALIZER_UNLOCKED;
+SemaphoreHandle_t GIFLibrary::lock = NULL;
+
+// 解析 GIF_LIBRARY_DIR/<8位十六进制ID>.gif
+static bool parseAssetPath(const char *path, uint32_t *id) {
+    const size_t dirLen = strlen(GIF_LIBRARY_DIR);
+    if (strncmp(path, GIF_LIBRARY_DIR, dirLen) != 0 || path[dirLen] != '/') {
+        return false;
+    }
+    const char *name = path + dirLen + 1;
+    if (strlen(name) != 12 || strcmp(name + 8, ".gif") != 0) {
+        return false;
+    }
+    char *end;
+    unsigned long value = strtoul(name, &end, 16);
+    if (end != name + 8) {
+        return false;
+    }
+    *id = (uint32_t)value;
+    return true;
+}
+
+// ============================================================================
+// 初始化与清单
+// ============================================================================
+
+void GIFLibrary::begin() {
+    if (lock == NULL) {
+        lock = xSemaphoreCreateMutex();
+    }
+    if (!FILESYSTEM.exists(GIF_LIBRARY_DIR)) {
+        FILESYSTEM.mkdir(GIF_LIBRARY_DIR);
+    }
+    load();
+
+    // 清单中的文件必须存在且大小一致
+    bool changed = false;
+    for (int i = entryCount - 1; i >= 0; i--) {
+        char path[GIF_PATH_SIZE];
+        assetPath(entries[i].id, path, sizeof(path));
+        File file = FILESYSTEM.open(path, "r");
+        bool ok = file && (int32_t)file.size() == entries[i].size;
+        if (file) {
+            file.close();
+        }
+        if (!ok) {
+            printInfo("GIFLibrary", ("清单中的动画文件缺失或大小不符，移除: " + String(path)).c_str());
+            FILESYSTEM.remove(path);
+            removeAt(i);
+            changed = true;
+        }
+    }
+
+    // 目录中不在清单里的文件（写入中途断电等）直接删除，删除后重新遍历目录
+    bool removed = true;
+    while (removed) {
+        removed = false;
+        File dir = FILESYSTEM.open(GIF_LIBRARY_DIR);
+        if (!dir || !dir.isDirectory()) {
+            break;
+        }
+        String orphan;
+        for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+            String path = file.path();
+            file.close();
+            uint32_t id;
+            if (path == GIF_LIBRARY_MANIFEST || (parseAssetPath(path.c_str(), &id) && find(id) >= 0)) {
+                continue;
+            }
+            orphan = path;
+            break;
+        }
+        dir.close();
+        if (orphan.length() > 0) {
+            printInfo("GIFLibrary", ("删除清单外的文件: " + orphan).c_str());
+            removed = FILESYSTEM.remove(orphan.c_str());
+        }
+    }
+
+    if (changed) {
+        save();
+    }
+    printInfo("GIFLibrary", ("动画库: " + String(entryCount) + " 个动画, " + String(usedBytes()) + "/" + String(GIF_LIBRARY_BUDGET) + " 字节").c_str());
+}
+
+bool GIFLibrary::load() {
+    entryCount = 0;
+    useCounter = 0;
+
+    File file = FILESYSTEM.open(GIF_LIBRARY_MANIFEST, "r");
+    if (!file) {
+        return false;
+    }
+    // 每行 "ID 大小 最近播放序号"
+    while (file.available() && entryCount < GIF_LIBRARY_MAX_ENTRIES) {
+        String line = file.readStringUntil('\n');
+        unsigned long id, lastUse;
+        long size;
+        if (sscanf(line.c_str(), "%lx %ld %lu", &id, &size, &lastUse) != 3 || size <= 0 || find(id) >= 0) {
+            continue;
+        }
+        Entry &e = entries[entryCount++];
+        e.id = id;
+        e.size = size;
+        e.lastUse = lastUse;
+        if (lastUse > useCounter) {
+            useCounter = lastUse;
+        }
+    }
+    file.close();
+    return true;
+}
+
+bool GIFLibrary::save() {
+    // 先写临时文件再改名，写到一半断电时旧清单仍然完整
+    const String tmp = String(GIF_LIBRARY_MANIFEST) + ".tmp";
+    File file = FILESYSTEM.open(tmp.c_str(), "w");
+    if (!file) {
+        printError("GIFLibrary", "无法写入清单");
+        return false;
+    }
+    for (int i = 0; i < entryCount; i++) {
+        file.printf("%08lx %ld %lu\n", (unsigned long)entries[i].id, (long)entries[i].size, (unsigned long)entries[i].lastUse);
+    }
+    file.close();
+
+    if (!FILESYSTEM.rename(tmp.c_str(), GIF_LIBRARY_MANIFEST)) {
+        FILESYSTEM.remove(GIF_LIBRARY_MANIFEST);
+        if (!FILESYSTEM.rename(tmp.c_str(), GIF_LIBRARY_MANIFEST)) {
+            printError("GIFLibrary", "清单改名失败");
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// 添加、删除与淘汰
+// ============================================================================
+
+uint32_t GIFLibrary::hash(const uint8_t *data, size_t len, uint32_t h) {
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+bool GIFLibrary::checkExisting(uint32_t id, int32_t size, const uint8_t *data, const char *path, bool *exists) {
+    int index = find(id);
+    *exists = index >= 0;
+    if (!*exists) {
+        return true;
+    }
+    if (entries[index].size != size) {
+        printError("GIFLibrary", ("ID相同但大小不同，不保存: " + String(id, HEX)).c_str());
+        return false;
+    }
+    // 32位哈希可能碰撞，内容一致才算已在库中
+    if (!sameContent(id, size, data, path)) {
+        printError("GIFLibrary", ("ID相同但内容不同，不保存: " + String(id, HEX)).c_str());
+        return false;
+    }
+    entries[index].lastUse = ++useCounter;
+    return true;
+}
+
+bool GIFLibrary::sameContent(uint32_t id, int32_t size, const uint8_t *data, const char *path) {
+    char assetFile[GIF_PATH_SIZE];
+    assetPath(id, assetFile, sizeof(assetFile));
+    File asset = FILESYSTEM.open(assetFile, "r");
+    File other;
+    if (data == nullptr) {
+        other = FILESYSTEM.open(path, "r");
+    }
+    bool same = asset && (data != nullptr || other);
+
+    uint8_t a[GIF_LIBRARY_VERIFY_CHUNK];
+    uint8_t b[GIF_LIBRARY_VERIFY_CHUNK];
+    for (int32_t pos = 0; same && pos < size; pos += GIF_LIBRARY_VERIFY_CHUNK) {
+        int32_t n = min((int32_t)GIF_LIBRARY_VERIFY_CHUNK, size - pos);
+        if ((int32_t)asset.read(a, n) != n) {
+            same = false;
+        } else if (data != nullptr) {
+            same = memcmp(a, data + pos, n) == 0;
+        } else {
+            same = (int32_t)other.read(b, n) == n && memcmp(a, b, n) == 0;
+        }
+        if ((pos & (GIF_LIBRARY_WRITE_CHUNK - 1)) == 0) {
+            yield(); // 喂狗
+        }
+    }
+    if (asset) {
+        asset.close();
+    }
+    if (other) {
+        other.close();
+    }
+    return same;
+}
+
+bool GIFLibrary::makeRoom(int32_t size, int32_t fsBytes) {
+    if (size > GIF_LIBRARY_BUDGET) {
+        printInfo("GIFLibrary", ("动画大小 " + String(size) + " 字节超出动画库预算").c_str());
+        return false;
+    }
+    // 上传新动画时播放已经停止，所有动画（包括最近一次播放的）都可以淘汰
+    while (true) {
+        int64_t fsFree = (int64_t)FILESYSTEM.totalBytes() - (int64_t)FILESYSTEM.usedBytes();
+        if (entryCount < GIF_LIBRARY_MAX_ENTRIES && usedBytes() + size <= GIF_LIBRARY_BUDGET &&
+            fsFree >= (int64_t)fsBytes + GIF_LIBRARY_FS_RESERVE) {
+            return true;
+        }
+        if (entryCount == 0) {
+            printInfo("GIFLibrary", ("文件系统空间不足: 可用 " + String((long)fsFree) + " 字节").c_str());
+            return false;
+        }
+
+        int oldest = 0;
+        for (int i = 1; i < entryCount; i++) {
+            if (entries[i].lastUse < entries[oldest].lastUse) {
+                oldest = i;
+            }
+        }
+        char path[GIF_PATH_SIZE];
+        assetPath(entries[oldest].id, path, sizeof(path));
+        FILESYSTEM.remove(path);
+        printInfo("GIFLibrary", ("淘汰最久没有播放的动画: " + String(path)).c_str());
+        if (isActive(entries[oldest].id)) {
+            activeValid = false;
+        }
+        removeAt(oldest);
+    }
+}
+
+bool GIFLibrary::addFile(const char *path, uint32_t hash, uint32_t *id) {
+    File file = FILESYSTEM.open(path, "r");
+    if (!file) {
+        return false;
+    }
+    int32_t size = file.size();
+    file.close();
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool exists;
+    if (!checkExisting(hash, size, nullptr, path, &exists)) {
+        xSemaphoreGive(lock);
+        return false;
+    }
+    *id = hash;
+    if (exists) {
+        FILESYSTEM.remove(path);
+        save();
+        xSemaphoreGive(lock);
+        printInfo("GIFLibrary", ("动画库中已有相同内容: " + String(hash, HEX)).c_str());
+        return true;
+    }
+
+    // 文件已经占用了文件系统空间，改名不需要额外空间
+    if (!makeRoom(size, 0)) {
+        save();
+        xSemaphoreGive(lock);
+        return false;
+    }
+    char dst[GIF_PATH_SIZE];
+    assetPath(hash, dst, sizeof(dst));
+    if (!FILESYSTEM.rename(path, dst)) {
+        printError("GIFLibrary", ("文件移入动画库失败: " + String(dst)).c_str());
+        save();
+        xSemaphoreGive(lock);
+        return false;
+    }
+    insert(hash, size);
+    save();
+    xSemaphoreGive(lock);
+    printInfo("GIFLibrary", ("动画已保存: " + String(dst) + ", " + String(size) + " 字节").c_str());
+    return true;
+}
+
+bool GIFLibrary::addBuffer(const uint8_t *data, int32_t size, uint32_t hash, uint32_t *id) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    bool exists;
+    if (!checkExisting(hash, size, data, nullptr, &exists)) {
+        xSemaphoreGive(lock);
+        return false;
+    }
+    *id = hash;
+    if (exists) {
+        save();
+        xSemaphoreGive(lock);
+        printInfo("GIFLibrary", ("动画库中已有相同内容: " + String(hash, HEX)).c_str());
+        return true;
+    }
+
+    if (!makeRoom(size, size)) {
+        save();
+        xSemaphoreGive(lock);
+        return false;
+    }
+    // 写入期间不持有锁，BLE的播放、删除命令不用等待；这个ID还不在清单中，不会被它们用到，
+    // 只有主循环添加动画，腾出的空间也不会被占用
+    xSemaphoreGive(lock);
+
+    char dst[GIF_PATH_SIZE];
+    assetPath(hash, dst, sizeof(dst));
+    File file = FILESYSTEM.open(dst, "w");
+    if (!file) {
+        printError("GIFLibrary", ("无法创建动画文件: " + String(dst)).c_str());
+        return false;
+    }
+    int32_t written = 0;
+    while (written < size) {
+        int32_t n = min((int32_t)GIF_LIBRARY_WRITE_CHUNK, size - written);
+        if ((int32_t)file.write(data + written, n) != n) {
+            break;
+        }
+        written += n;
+        yield(); // 喂狗
+    }
+    file.close();
+    if (written != size) {
+        printError("GIFLibrary", ("动画文件写入失败: " + String(dst)).c_str());
+        FILESYSTEM.remove(dst);
+        return false;
+    }
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    insert(hash, size);
+    save();
+    xSemaphoreGive(lock);
+    printInfo("GIFLibrary", ("动画已保存: " + String(dst) + ", " + String(size) + " 字节").c_str());
+    return true;
+}
+
+bool GIFLibrary::remove(uint32_t id) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int index = find(id);
+    if (index < 0) {
+        xSemaphoreGive(lock);
+        return false;
+    }
+    char path[GIF_PATH_SIZE];
+    assetPath(id, path, sizeof(path));
+    FILESYSTEM.remove(path);
+    if (isActive(id)) {
+        activeValid = false;
+    }
+    removeAt(index);
+    save();
+    xSemaphoreGive(lock);
+    printInfo("GIFLibrary", ("已删除动画: " + String(path)).c_str());
+    return true;
+}
+
+// ============================================================================
+// 切换播放
+// ============================================================================
+
+bool GIFLibrary::play(uint32_t id) {
+    if (!touch(id)) {
+        return false;
+    }
+    char path[GIF_PATH_SIZE];
+    assetPath(id, path, sizeof(path));
+    select(path);
+    return true;
+}
+
+bool GIFLibrary::markPlaying(uint32_t id) {
+    if (!touch(id)) {
+        return false;
+    }
+    portENTER_CRITICAL(&mux);
+    activeId = id;
+    activeValid = true;
+    portEXIT_CRITICAL(&mux);
+    return true;
+}
+
+void GIFLibrary::select(const char *path) {
+    uint32_t id = 0;
+    bool isAsset = parseAssetPath(path, &id);
+    portENTER_CRITICAL(&mux);
+    strlcpy(selection, path, sizeof(selection));
+    selectionPending = true;
+    activeId = id;
+    activeValid = isAsset;
+    portEXIT_CRITICAL(&mux);
+}
+
+bool GIFLibrary::takeSelection(char *path, size_t size) {
+    bool pending;
+    portENTER_CRITICAL(&mux);
+    pending = selectionPending;
+    if (pending) {
+        strlcpy(path, selection, size);
+        selectionPending = false;
+    }
+    portEXIT_CRITICAL(&mux);
+    return pending;
+}
+
+bool GIFLibrary::isActive(uint32_t id) {
+    return activeValid && activeId == id;
+}
+
+size_t GIFLibrary::format(char *buf, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int n = snprintf(buf, size, "USED:%ld,%ld;", (long)usedBytes(), (long)GIF_LIBRARY_BUDGET);
+    if (n < 0 || (size_t)n >= size) {
+        xSemaphoreGive(lock);
+        buf[0] = '\0';
+        return 0;
+    }
+    size_t len = n;
+
+    // 按最近播放在前的顺序输出
+    bool listed[GIF_LIBRARY_MAX_ENTRIES] = {};
+    for (int k = 0; k < entryCount; k++) {
+        int next = -1;
+        for (int i = 0; i < entryCount; i++) {
+            if (!listed[i] && (next < 0 || entries[i].lastUse > entries[next].lastUse)) {
+                next = i;
+            }
+        }
+        listed[next] = true;
+        n = snprintf(buf + len, size - len, "%08lx:%ld;", (unsigned long)entries[next].id, (long)entries[next].size);
+        if (n < 0 || (size_t)n >= size - len) {
+            // 缓冲区不够，丢弃写了一半的这一项
+            buf[len] = '\0';
+            break;
+        }
+        len += n;
+    }
+    xSemaphoreGive(lock);
+    return len;
+}
+
+// ============================================================================
+// 内部工具
+// ============================================================================
+
+void GIFLibrary::assetPath(uint32_t id, char *path, size_t size) {
+    snprintf(path, size, "%s/%08lx.gif", GIF_LIBRARY_DIR, (unsigned long)id);
+}
+
+int GIFLibrary::find(uint32_t id) {
+    for (int i = 0; i < entryCount; i++) {
+        if (entries[i].id == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool GIFLibrary::touch(uint32_t id) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    int index = find(id);
+    if (index < 0) {
+        xSemaphoreGive(lock);
+        printInfo("GIFLibrary", ("动画不在库中: " + String(id, HEX)).c_str());
+        return false;
+    }
+    entries[index].lastUse = ++useCounter;
+    save();
+    xSemaphoreGive(lock);
+    return true;
+}
+
+int32_t GIFLibrary::usedBytes() {
+    int32_t total = 0;
+    for (int i = 0; i < entryCount; i++) {
+        total += entries[i].size;
+    }
+    return total;
+}
+
+void GIFLibrary::insert(uint32_t id, int32_t size) {
+    Entry &e = entries[entryCount++];
+    e.id = id;
+    e.size = size;
+    e.lastUse = ++useCounter;
+}
+
+void GIFLibrary::removeAt(int index) {
+    for (int i = index; i < entryCount - 1; i++) {
+        entries[i] = entries[i + 1];
+    }
+    entryCount--;
+}
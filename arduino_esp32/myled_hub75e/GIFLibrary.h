@@ -0,0 +1,87 @@
+#ifndef GIF_LIBRARY_H
+#define GIF_LIBRARY_H
+
+#include "config.h"
+#include "debug.h"
+#include <LittleFS.h>
+
+// ============================================================================
+// GIF动画库：上传过的GIF按内容哈希保存在LittleFS上（GIF_LIBRARY_DIR/<ID>.gif），
+// 之后只需一条很短的命令即可切换播放；总大小超出预算时淘汰最久没有播放的动画
+// ============================================================================
+
+/**
+ * 清单由BLE回调任务（播放、删除）和主循环（保存上传完成的GIF）修改，用互斥锁串行，
+ * 写入GIF数据时不持有锁；主循环通过 takeSelection() 取走待切换的路径，用自旋锁保护
+ */
+class GIFLibrary {
+public:
+    static const uint32_t HASH_SEED = 2166136261u;  // FNV-1a 初始值
+
+    // 创建目录、加载清单，删除与清单对不上的文件；LittleFS挂载后调用一次
+    static void begin();
+
+    // FNV-1a 32位哈希，可以分块累加（上一块的结果作为下一块的 h）
+    static uint32_t hash(const uint8_t *data, size_t len, uint32_t h = HASH_SEED);
+
+    // 把上传完成的文件移入库中（重命名，不复制）；相同内容已在库中时删除该文件。在主循环调用
+    static bool addFile(const char *path, uint32_t hash, uint32_t *id);
+    // 把内存中的GIF写入库中。在主循环调用，写入期间 data 不能释放
+    static bool addBuffer(const uint8_t *data, int32_t size, uint32_t hash, uint32_t *id);
+    // 删除库中的动画（调用方保证它没有在播放）
+    static bool remove(uint32_t id);
+
+    // 请求主循环切换到库中的动画，并记为最近播放
+    static bool play(uint32_t id);
+    // 播放器已经在放这个动画（边接收边播放刚保存的）：记为最近播放和正在播放，不切换
+    static bool markPlaying(uint32_t id);
+    // 请求主循环切换到库外的GIF文件（动画库保存失败时的临时文件）
+    static void select(const char *path);
+    // 主循环取走待切换的文件路径，没有时返回false
+    static bool takeSelection(char *path, size_t size);
+    // 该动画是否为最近一次选中播放的
+    static bool isActive(uint32_t id);
+
+    /**
+     * 格式化清单，供BLE读取/通知：
+     * "USED:已用字节,预算;ID:字节数;..." 按最近播放在前，缓冲区不够时省略最久没播放的
+     * @return 写入的字符数（不含结尾的0）
+     */
+    static size_t format(char *buf, size_t size);
+
+private:
+    struct Entry {
+        uint32_t id;            // 内容哈希
+        int32_t size;           // 文件大小
+        uint32_t lastUse;       // 最近播放的序号，越大越新
+    };
+    static Entry entries[GIF_LIBRARY_MAX_ENTRIES];
+    static int entryCount;
+    static uint32_t useCounter;
+
+    static char selection[GIF_PATH_SIZE];
+    static bool selectionPending;
+    static uint32_t activeId;
+    static bool activeValid;
+    static portMUX_TYPE mux;
+    static SemaphoreHandle_t lock;      // 保护清单和库中的文件
+
+    static void assetPath(uint32_t id, char *path, size_t size);
+    static int find(uint32_t id);
+    // 记为最近播放并保存清单，不在库中时返回false
+    static bool touch(uint32_t id);
+    static int32_t usedBytes();
+    // 已有相同内容时记为最近播放，返回true；ID相同但大小或内容不同（哈希冲突）时返回false。
+    // 新内容在内存 data 中或文件 path 中，二选一
+    static bool checkExisting(uint32_t id, int32_t size, const uint8_t *data, const char *path, bool *exists);
+    // 逐块比较库中的动画和新内容
+    static bool sameContent(uint32_t id, int32_t size, const uint8_t *data, const char *path);
+    // 淘汰最久没有播放的动画，直到能再放下 size 字节（fsBytes 为还需要的文件系统空间）
+    static bool makeRoom(int32_t size, int32_t fsBytes);
+    static void insert(uint32_t id, int32_t size);
+    static void removeAt(int index);
+    static bool load();
+    static bool save();
+};
+
+#endif // GIF_LIBRARY_H
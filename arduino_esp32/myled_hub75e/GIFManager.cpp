@@ -1,30 +1,140 @@
 #include "GIFManager.h"
+#include "Profiler.h"
+#include "GIFReader.h"
+#include "GIFLibrary.h"
+#include "esp_heap_caps.h"
+#include <algorithm>
 MatrixPanel_I2S_DMA* GIFManager::static_dma_display = nullptr;
+bool GIFManager::frameDrawn = false;
+const uint16_t* GIFManager::cachedPalette = nullptr;
+uint16_t GIFManager::palette565[256];
+uint32_t GIFManager::paletteBits[256];
+GIFManager::ScaleMap GIFManager::scaleMap;
+int16_t GIFManager::boxRow = -1;
+uint32_t GIFManager::boxSum[GIF_SCALE_MAX_WIDTH][3];
+uint16_t GIFManager::boxCount[GIF_SCALE_MAX_WIDTH];
+uint16_t* GIFManager::decodeCanvas = nullptr;
 
 GIFManager::GIFManager(MatrixPanel_I2S_DMA* display, AnimatedGIF* gifDecoder) 
-    : dma_display(display), gif(gifDecoder), f(), x_offset(0), y_offset(0),
-      gifInitialized(false), lastGifFrameTime(0), gifFrameDelay(0), 
-      gifLoopMode(true), start_tick(0) {
+    : dma_display(display), gif(gifDecoder), f(), scaleMode(GIF_SCALE_MODE),
+      gifInitialized(false), nextGifFrameTime(0), gifFrameDelay(0), gifSpeedPercent(GIF_DEFAULT_SPEED_PERCENT),
+      gifLoopMode(true), gifReachedEnd(false), start_tick(0), gifMemory(nullptr), gifMemorySize(0),
+      gifStreaming(false), streamFrameIndex(0),
+      frameCacheState(FRAME_CACHE_OFF), frameCacheCount(0), frameCacheIndex(0), frameCacheBytes(0),
+      decodeTask(nullptr), freeSlots(nullptr), readySlots(nullptr), decodeTaskDone(nullptr),
+      decodeTaskStop(false), decodeTaskFinished(false) {
     static_dma_display = display;
+    strlcpy(gifPath, GIF_FILE, sizeof(gifPath));
+    for (int i = 0; i < GIF_FRAME_QUEUE_LENGTH; i++) {
+        frameSlots[i] = nullptr;
+        frameSlotDelay[i] = 0;
+    }
 }
 
 GIFManager::~GIFManager() {
     cleanup();
 }
 
+// 依据配置的颜色顺序进行通道映射
+static inline uint16_t mapColorOrder(uint16_t color) {
+    uint8_t r = (color >> 8) & 0xF8;
+    uint8_t g = (color >> 3) & 0xFC;
+    uint8_t b = (color << 3) & 0xF8;
+    uint8_t outR, outG, outB;
+    #if (LED_COLOR_ORDER == COLOR_ORDER_RGB)
+        outR = r; outG = g; outB = b;
+    #elif (LED_COLOR_ORDER == COLOR_ORDER_RBG)
+        outR = r; outG = b; outB = g;
+    #elif (LED_COLOR_ORDER == COLOR_ORDER_GRB)
+        outR = g; outG = r; outB = b;
+    #elif (LED_COLOR_ORDER == COLOR_ORDER_GBR)
+        outR = g; outG = b; outB = r;
+    #elif (LED_COLOR_ORDER == COLOR_ORDER_BRG)
+        outR = b; outG = r; outB = g;
+    #elif (LED_COLOR_ORDER == COLOR_ORDER_BGR)
+        outR = b; outG = g; outB = r;
+    #else
+        outR = r; outG = b; outB = g; // 兼容当前默认行为（RBG）
+    #endif
+    return ((outR & 0xF8) << 8) | ((outG & 0xFC) << 3) | (outB >> 3);
+}
+
+void GIFManager::convertPalette(const uint16_t *palette) {
+    for (int i = 0; i < 256; i++) {
+        palette565[i] = mapColorOrder(palette[i]);
+    }
+    // 位平面值只在没有影子帧缓冲、直接写DMA缓冲区时用到
+    if (!static_dma_display->hasShadowBuffer()) {
+        static_dma_display->paletteToPlaneBits(palette565, paletteBits, 256);
+    }
+    cachedPalette = palette;
+}
+
+void GIFManager::drawIndexedRuns(int x, int y, const uint8_t *idx, int n, int transparent) {
+    int i = 0;
+    while (i < n) {
+        // skip a run of transparent pixels
+        while (i < n && idx[i] == transparent)
+            i++;
+        // 连续的不透明像素整段写入
+        int start = i;
+        while (i < n && idx[i] != transparent)
+            i++;
+        if (i <= start)
+            continue;
+        if (decodeCanvas != nullptr) {
+            uint16_t *dst = decodeCanvas + y * static_dma_display->width() + x;
+            for (int k = start; k < i; k++)
+                dst[k] = palette565[idx[k]];
+        } else {
+            static_dma_display->drawSpanIndexed(x + start, y, idx + start, i - start, palette565, paletteBits);
+        }
+    }
+}
+
+void GIFManager::flushBoxRow() {
+    if (boxRow < 0) {
+        return;
+    }
+    uint16_t line[GIF_SCALE_MAX_WIDTH];
+    const int w = scaleMap.dstW;
+    int i = 0;
+    while (i < w) {
+        // 区域内全部透明的像素保持原样
+        while (i < w && boxCount[i] == 0)
+            i++;
+        int start = i;
+        for (; i < w && boxCount[i] != 0; i++) {
+            uint16_t n = boxCount[i];
+            line[i] = ((boxSum[i][0] / n) << 11) | ((boxSum[i][1] / n) << 5) | (boxSum[i][2] / n);
+        }
+        if (i <= start)
+            continue;
+        if (decodeCanvas != nullptr) {
+            uint16_t *dst = decodeCanvas + (scaleMap.dstY + boxRow) * static_dma_display->width() + scaleMap.dstX;
+            memcpy(dst + start, line + start, (i - start) * sizeof(uint16_t));
+        } else {
+            static_dma_display->drawSpanRGB565(scaleMap.dstX + start, scaleMap.dstY + boxRow, line + start, i - start);
+        }
+    }
+    memset(boxSum, 0, sizeof(boxSum));
+    memset(boxCount, 0, sizeof(boxCount));
+    boxRow = -1;
+}
+
 void GIFManager::GIFDraw(GIFDRAW *pDraw) {
     uint8_t *s;
-    uint16_t *d, *usPalette, usTemp[320];
-    int x, y, iWidth;
+    uint16_t *usPalette;
+    int x, iWidth;
 
+    frameDrawn = true;
     iWidth = pDraw->iWidth;
-    if (iWidth > static_dma_display->width())
-        iWidth = static_dma_display->width();
 
     usPalette = pDraw->pPalette;
-    y = pDraw->iY + pDraw->y;  // current line
+    if (usPalette == nullptr)
+        return;
     static bool palettePrinted = false;
-    if (!palettePrinted && usPalette != nullptr) {
+    if (!palettePrinted) {
         palettePrinted = true;
         printInfo("GIFDraw", "调色板颜色值:");
         for (int i = 0; i < min(8, 256); i++) {
@@ -36,6 +146,12 @@ void GIFManager::GIFDraw(GIFDRAW *pDraw) {
         }
     }
 
+    // 调色板整体转换一次（颜色顺序、伽马、位平面），行内只剩按索引查表；
+    // 局部调色板每帧复用同一块内存，所以每帧第一行也重新转换
+    if (pDraw->y == 0 || usPalette != cachedPalette) {
+        convertPalette(usPalette);
+    }
+
     s = pDraw->pPixels;
     if (pDraw->ucDisposalMethod == 2)  // restore to background color
     {
@@ -45,148 +161,144 @@ void GIFManager::GIFDraw(GIFDRAW *pDraw) {
         }
         pDraw->ucHasTransparency = 0;
     }
-    // Apply the new pixels to the main image
-    if (pDraw->ucHasTransparency)  // if transparency used
-    {
-        uint8_t *pEnd, c, ucTransparent = pDraw->ucTransparent;
-        int x, iCount;
-        pEnd = s + pDraw->iWidth;
-        x = 0;
-        iCount = 0;  // count non-transparent pixels
-        while (x < pDraw->iWidth) {
-            c = ucTransparent - 1;
-            d = usTemp;
-            while (c != ucTransparent && s < pEnd) {
-                c = *s++;
-                if (c == ucTransparent)  // done, stop
-                {
-                    s--;  // back up to treat it like transparent
-                } else  // opaque
-                {
-                    // 依据配置的颜色顺序进行通道映射
-                    uint16_t color = usPalette[c];
-                    uint8_t r = (color >> 8) & 0xF8;
-                    uint8_t g = (color >> 3) & 0xFC;
-                    uint8_t b = (color << 3) & 0xF8;
-                    uint8_t outR, outG, outB;
-                    #if (LED_COLOR_ORDER == COLOR_ORDER_RGB)
-                        outR = r; outG = g; outB = b;
-                    #elif (LED_COLOR_ORDER == COLOR_ORDER_RBG)
-                        outR = r; outG = b; outB = g;
-                    #elif (LED_COLOR_ORDER == COLOR_ORDER_GRB)
-                        outR = g; outG = r; outB = b;
-                    #elif (LED_COLOR_ORDER == COLOR_ORDER_GBR)
-                        outR = g; outG = b; outB = r;
-                    #elif (LED_COLOR_ORDER == COLOR_ORDER_BRG)
-                        outR = b; outG = r; outB = g;
-                    #elif (LED_COLOR_ORDER == COLOR_ORDER_BGR)
-                        outR = b; outG = g; outB = r;
-                    #else
-                        outR = r; outG = b; outB = g; // 兼容当前默认行为（RBG）
-                    #endif
-                    uint16_t mapped565 = ((outR & 0xF8) << 8) | ((outG & 0xFC) << 3) | (outB >> 3);
-                    *d++ = mapped565;
-                    iCount++;
-                }
-            }            // while looking for opaque pixels
-            if (iCount)  // any opaque pixels?
-            {
-                for (int xOffset = 0; xOffset < iCount; xOffset++) {
-                    static_dma_display->drawPixel(x + xOffset, y, usTemp[xOffset]);  // 565 Color Format
-                }
-                x += iCount;
-                iCount = 0;
-            }
-            // no, look for a run of transparent pixels
-            c = ucTransparent;
-            while (c == ucTransparent && s < pEnd) {
-                c = *s++;
-                if (c == ucTransparent)
-                    iCount++;
-                else
-                    s--;
-            }
-            if (iCount) {
-                x += iCount;  // skip these
-                iCount = 0;
-            }
+    const int transparent = pDraw->ucHasTransparency ? pDraw->ucTransparent : -1;
+
+    // 本行在画布上的位置：一帧可以只覆盖画布的一部分
+    const int canvasY = pDraw->iY + pDraw->y;
+    const int canvasX = pDraw->iX;
+    const ScaleMap &m = scaleMap;
+
+    if (m.identity) {
+        // 1:1，面板外的行和列直接跳过
+        int y = canvasY - m.srcY;
+        if (y < 0 || y >= m.dstH)
+            return;
+        int first = max(0, m.srcX - canvasX);
+        int last = min(iWidth, m.srcX + m.dstW - canvasX);
+        if (last > first)
+            drawIndexedRuns(m.dstX + canvasX + first - m.srcX, m.dstY + y, s + first, last - first, transparent);
+        return;
+    }
+
+    if (m.box) {
+        // 区域平均：本行累加到所属的目标行，到该目标行的最后一个画布行或这一帧的最后一行时输出
+        int row = std::upper_bound(m.rowBox, m.rowBox + m.dstH + 1, canvasY) - m.rowBox - 1;
+        if (row < 0 || row >= m.dstH)
+            return;
+        if (row != boxRow) {
+            flushBoxRow();  // 隔行扫描的GIF行序不连续，先输出已累加的部分
+            boxRow = row;
         }
-    } else  // does not have transparency
-    {
-        s = pDraw->pPixels;
-        // Translate the 8-bit pixels through the RGB565 palette
-        for (x = 0; x < pDraw->iWidth; x++) {
-            // 依据配置的颜色顺序进行通道映射
-            uint16_t color = usPalette[*s++];
-            uint8_t r = (color >> 8) & 0xF8;
-            uint8_t g = (color >> 3) & 0xFC;
-            uint8_t b = (color << 3) & 0xF8;
-            uint8_t outR, outG, outB;
-            #if (LED_COLOR_ORDER == COLOR_ORDER_RGB)
-                outR = r; outG = g; outB = b;
-            #elif (LED_COLOR_ORDER == COLOR_ORDER_RBG)
-                outR = r; outG = b; outB = g;
-            #elif (LED_COLOR_ORDER == COLOR_ORDER_GRB)
-                outR = g; outG = r; outB = b;
-            #elif (LED_COLOR_ORDER == COLOR_ORDER_GBR)
-                outR = g; outG = b; outB = r;
-            #elif (LED_COLOR_ORDER == COLOR_ORDER_BRG)
-                outR = b; outG = r; outB = g;
-            #elif (LED_COLOR_ORDER == COLOR_ORDER_BGR)
-                outR = b; outG = g; outB = r;
-            #else
-                outR = r; outG = b; outB = g; // 兼容当前默认行为（RBG）
-            #endif
-            uint16_t mapped565 = ((outR & 0xF8) << 8) | ((outG & 0xFC) << 3) | (outB >> 3);
-            static_dma_display->drawPixel(x, y, mapped565);  // color 565
+        int col = std::upper_bound(m.colBox, m.colBox + m.dstW + 1, canvasX) - m.colBox - 1;
+        for (col = max(col, 0); col < m.dstW && m.colBox[col] < canvasX + iWidth; col++) {
+            int from = max((int)m.colBox[col], canvasX) - canvasX;
+            int to = min((int)m.colBox[col + 1], canvasX + iWidth) - canvasX;
+            for (x = from; x < to; x++) {
+                if (s[x] == transparent)
+                    continue;
+                uint16_t c = palette565[s[x]];
+                boxSum[col][0] += c >> 11;
+                boxSum[col][1] += (c >> 5) & 0x3F;
+                boxSum[col][2] += c & 0x1F;
+                boxCount[col]++;
+            }
         }
+        if (canvasY + 1 == m.rowBox[row + 1] || pDraw->y == pDraw->iHeight - 1)
+            flushBoxRow();
+        return;
     }
-}
 
-void* GIFManager::GIFOpenFile(const char *fname, int32_t *pSize) {
-    printInfo("GIFOpenFile", ("尝试打开GIF文件: " + String(fname)).c_str());
-    
-    File *file = new File(FILESYSTEM.open(fname));
-    if (*file) {
-        *pSize = file->size();
-        printInfo("GIFOpenFile", ("文件打开成功，大小: " + String(*pSize) + " 字节").c_str());
-        return (void *)file;
-    } else {
-        printError("GIFOpenFile", ("文件打开失败: " + String(fname)).c_str());
-        delete file;
-        return NULL;
+    // 最近像素：本行被哪些目标行取样，没有则跳过
+    const int16_t *rowFirst = std::lower_bound(m.rowSrc, m.rowSrc + m.dstH, canvasY);
+    const int16_t *rowEnd = std::upper_bound(rowFirst, m.rowSrc + m.dstH, canvasY);
+    if (rowFirst == rowEnd)
+        return;
+
+    // 取样点落在这一帧内的目标列
+    int first = std::lower_bound(m.colSrc, m.colSrc + m.dstW, canvasX) - m.colSrc;
+    int last = std::lower_bound(m.colSrc, m.colSrc + m.dstW, canvasX + iWidth) - m.colSrc;
+    if (last <= first)
+        return;
+    uint8_t line[GIF_SCALE_MAX_WIDTH];
+    for (x = first; x < last; x++) {
+        line[x] = s[m.colSrc[x] - canvasX];
+    }
+    for (const int16_t *row = rowFirst; row < rowEnd; row++) {
+        drawIndexedRuns(m.dstX + first, m.dstY + (row - m.rowSrc), line + first, last - first, transparent);
     }
 }
 
-void GIFManager::GIFCloseFile(void *pHandle) {
-    File *file = static_cast<File *>(pHandle);
-    if (file != NULL) {
-        file->close();
-        delete file;
+void GIFManager::computeScaleMap() {
+    const int panelW = min((int)dma_display->width(), GIF_SCALE_MAX_WIDTH);
+    const int panelH = min((int)dma_display->height(), GIF_SCALE_MAX_HEIGHT);
+    const int canvasW = max(gif->getCanvasWidth(), 1);
+    const int canvasH = max(gif->getCanvasHeight(), 1);
+
+    // 面板上 dstW x dstH 的区域显示画布中间 srcW x srcH 的部分
+    int dstW, dstH, srcW, srcH;
+    switch (scaleMode) {
+        case GIF_SCALE_FIT:
+            srcW = canvasW;
+            srcH = canvasH;
+            if (canvasW <= panelW && canvasH <= panelH) {
+                // 只缩小不放大：放得下的GIF按原尺寸居中
+                dstW = canvasW;
+                dstH = canvasH;
+            } else if ((long)canvasW * panelH <= (long)canvasH * panelW) {
+                dstH = panelH;
+                dstW = max(1, (int)((long)canvasW * panelH / canvasH));
+            } else {
+                dstW = panelW;
+                dstH = max(1, (int)((long)canvasH * panelW / canvasW));
+            }
+            break;
+        case GIF_SCALE_FILL:
+            dstW = panelW;
+            dstH = panelH;
+            if ((long)canvasW * panelH > (long)canvasH * panelW) {
+                srcH = canvasH;
+                srcW = max(1, (int)((long)canvasH * panelW / panelH));
+            } else {
+                srcW = canvasW;
+                srcH = max(1, (int)((long)canvasW * panelH / panelW));
+            }
+            break;
+        default:  // GIF_SCALE_CENTER
+            dstW = srcW = min(canvasW, panelW);
+            dstH = srcH = min(canvasH, panelH);
+            break;
     }
-}
 
-int32_t GIFManager::GIFReadFile(GIFFILE *pFile, uint8_t *pBuf, int32_t iLen) {
-    int32_t iBytesRead;
-    iBytesRead = iLen;
-    File *file = static_cast<File *>(pFile->fHandle);
-    // Note: If you read a file all the way to the last byte, seek() stops working
-    if ((pFile->iSize - pFile->iPos) < iLen)
-        iBytesRead = pFile->iSize - pFile->iPos - 1;  // <-- ugly work-around
-    if (iBytesRead <= 0)
-        return 0;
-    iBytesRead = (int32_t)file->read(pBuf, iBytesRead);
-    pFile->iPos = file->position();
-    return iBytesRead;
-}
+    ScaleMap &m = scaleMap;
+    m.dstX = (panelW - dstW) / 2;
+    m.dstY = (panelH - dstH) / 2;
+    m.dstW = dstW;
+    m.dstH = dstH;
+    m.srcX = (canvasW - srcW) / 2;
+    m.srcY = (canvasH - srcH) / 2;
+    m.identity = (srcW == dstW && srcH == dstH);
+    m.box = GIF_SCALE_BOX_FILTER && !m.identity && srcW >= dstW && srcH >= dstH;
 
-int32_t GIFManager::GIFSeekFile(GIFFILE *pFile, int32_t iPosition) {
-    int i = micros();
-    File *file = static_cast<File *>(pFile->fHandle);
-    file->seek(iPosition);
-    pFile->iPos = (int32_t)file->position();
-    i = micros() - i;
-    return pFile->iPos;
+    // 取样点在目标像素的中心；各表单调递增，GIFDraw 中二分查找
+    for (int i = 0; i < dstW; i++) {
+        m.colSrc[i] = m.srcX + (int)((2L * i + 1) * srcW / (2L * dstW));
+    }
+    for (int i = 0; i < dstH; i++) {
+        m.rowSrc[i] = m.srcY + (int)((2L * i + 1) * srcH / (2L * dstH));
+    }
+    for (int i = 0; i <= dstW; i++) {
+        m.colBox[i] = m.srcX + (int)((long)i * srcW / dstW);
+    }
+    for (int i = 0; i <= dstH; i++) {
+        m.rowBox[i] = m.srcY + (int)((long)i * srcH / dstH);
+    }
+
+    boxRow = -1;
+    memset(boxSum, 0, sizeof(boxSum));
+    memset(boxCount, 0, sizeof(boxCount));
+
+    printInfo("computeScaleMap", ("画布 " + String(canvasW) + "x" + String(canvasH) + " -> 面板区域 " + String(dstW) + "x" + String(dstH) +
+                                  " @(" + String(m.dstX) + "," + String(m.dstY) + ")" + (m.identity ? "" : (m.box ? " 区域平均" : " 最近像素"))).c_str());
 }
 
 void GIFManager::showGIF(char *name) {
@@ -204,28 +316,20 @@ void GIFManager::showGIF(char *name) {
         return;
     }
 
-    if (gif->open(name, GIFOpenFile, GIFCloseFile, GIFReadFile, GIFSeekFile, GIFDraw)) {
-        x_offset = (dma_display->width() - gif->getCanvasWidth()) / 2;
-        if (x_offset < 0) x_offset = 0;
-        y_offset = (dma_display->height() - gif->getCanvasHeight()) / 2;
-        if (y_offset < 0) y_offset = 0;
+    if (gif->open(name, GIFReader::open, GIFReader::close, GIFReader::read, GIFReader::seek, GIFDraw)) {
+        computeScaleMap();
         printInfo("ShowGIF", ("成功打开GIF; 画布尺寸 = " + String(gif->getCanvasWidth()) + " x " + String(gif->getCanvasHeight())).c_str());
         Serial.flush();
         
         // 添加帧计数和内存监控
         int frameCount = 0;
-        unsigned long lastMemoryCheck = millis();
         
         // 修改为循环播放，当播放完一帧后重新开始
         while (gifInitialized) {
             // 播放一帧
             if (!gif->playFrame(true, NULL)) {
-                // 如果播放完一帧，重新开始播放
-                gif->close();
-                if (!gif->open(name, GIFOpenFile, GIFCloseFile, GIFReadFile, GIFSeekFile, GIFDraw)) {
-                    printInfo("ShowGIF", ("无法重新打开GIF文件: " + String(name)).c_str());
-                    break;
-                }
+                // 播放完最后一帧，回到开头重新播放（不重新打开文件）
+                gif->reset();
                 continue;
             }
             
@@ -238,7 +342,6 @@ void GIFManager::showGIF(char *name) {
                     printInfo("ShowGIF", ("内存不足警告: 当前可用 " + String(currentFreeHeap) + " 字节，停止GIF播放").c_str());
                     break;
                 }
-                lastMemoryCheck = millis();
             }
             
             // 检查是否超时
@@ -262,42 +365,98 @@ void GIFManager::showGIF(char *name) {
     }
 }
 
+bool GIFManager::openGIF() {
+    if (gifMemory != nullptr) {
+        return gif->open(gifMemory, gifMemorySize, GIFDraw);
+    }
+    return gif->open(gifPath, GIFReader::open, GIFReader::close, GIFReader::read, GIFReader::seek, GIFDraw);
+}
+
+void GIFManager::setGIFMemory(uint8_t* data, int32_t size) {
+    releaseGIFSource();
+    gifMemory = data;
+    gifMemorySize = size;
+    printInfo("setGIFMemory", ("GIF直接从内存播放，大小: " + String(size) + " 字节").c_str());
+}
+
+void GIFManager::setGIFFile(const char* path) {
+    strlcpy(gifPath, path, sizeof(gifPath));
+    printInfo("setGIFFile", ("GIF从文件播放: " + String(gifPath)).c_str());
+}
+
+void GIFManager::releaseGIFSource() {
+    if (gifStreaming) {
+        // 接收缓冲区归BLE接收端，只放开；接收端已要求释放时在这里释放
+        GIFStream::detach();
+        gifStreaming = false;
+        gifMemory = nullptr;
+        gifMemorySize = 0;
+    } else if (gifMemory != nullptr) {
+        heap_caps_free(gifMemory);  // 与psram_free相同，PSRAM和内部RAM都可释放
+        gifMemory = nullptr;
+        gifMemorySize = 0;
+    }
+}
+
 bool GIFManager::initGIFPlayer() {
     if (!gifInitialized) {
-        // 检查临时GIF文件是否存在
-        if (!FILESYSTEM.exists(GIF_FILE)) {
-            printError("initGIFPlayer", ("GIF文件不存在: " + String(GIF_FILE)).c_str());
-            return false;
+#if GIF_STREAM_ENABLED
+        if (gifMemory == nullptr && strcmp(gifPath, GIF_STREAM_PATH) == 0) {
+            // 边接收边播放：直接解码接收缓冲区，第一帧已完整收到
+            if (!GIFStream::attach(&gifMemory, &gifMemorySize)) {
+                printError("initGIFPlayer", "GIF接收已结束，无法边接收边播放");
+                return false;
+            }
+            gifStreaming = true;
+            streamFrameIndex = 0;
+            printInfo("initGIFPlayer", ("GIF边接收边播放，已收到 " + String(GIFStream::frameCount()) + " 帧").c_str());
         }
-        
-        // 检查文件大小
-        File file = FILESYSTEM.open(GIF_FILE, "r");
-        if (file) {
-            size_t fileSize = file.size();
-            file.close();
-            printInfo("initGIFPlayer", ("GIF文件存在，大小: " + String(fileSize) + " 字节").c_str());
-        } else {
-            printError("initGIFPlayer", "无法打开GIF文件进行大小检查");
-            return false;
+#endif
+        if (gifMemory == nullptr) {
+            // 检查临时GIF文件是否存在
+            if (!FILESYSTEM.exists(gifPath)) {
+                printError("initGIFPlayer", ("GIF文件不存在: " + String(gifPath)).c_str());
+                return false;
+            }
+            
+            // 检查文件大小
+            File file = FILESYSTEM.open(gifPath, "r");
+            if (file) {
+                size_t fileSize = file.size();
+                file.close();
+                printInfo("initGIFPlayer", ("GIF文件存在，大小: " + String(fileSize) + " 字节").c_str());
+            } else {
+                printError("initGIFPlayer", "无法打开GIF文件进行大小检查");
+                return false;
+            }
         }
         
         // 先清屏，避免显示残留（只在初始化时清屏）
         dma_display->fillScreen(0x0000);
         
-        // 打开临时GIF文件
-        if (!gif->open(GIF_FILE, GIFOpenFile, GIFCloseFile, GIFReadFile, GIFSeekFile, GIFDraw)) {
-            printError("initGIFPlayer", ("无法打开GIF文件: " + String(GIF_FILE)).c_str());
+        // 打开GIF（内存或文件）
+        if (!openGIF()) {
+            if (gifMemory != nullptr) {
+                printError("initGIFPlayer", "无法从内存打开GIF");
+            } else {
+                printError("initGIFPlayer", ("无法打开GIF文件: " + String(gifPath)).c_str());
+            }
+            releaseGIFSource();
             return false;
         }
         
-        // 设置居中显示
-        x_offset = (dma_display->width() - gif->getCanvasWidth()) / 2;
-        if (x_offset < 0) x_offset = 0;
-        y_offset = (dma_display->height() - gif->getCanvasHeight()) / 2;
-        if (y_offset < 0) y_offset = 0;
+        // 按缩放模式计算画布到面板的映射
+        computeScaleMap();
         
         gifInitialized = true;
-        lastGifFrameTime = millis();
+        gifReachedEnd = false;
+        nextGifFrameTime = millis();
+        // 只有循环播放才值得缓存；边接收边播放的帧可能还没收完，不缓存
+        resetFrameCache(gifLoopMode && !gifStreaming);
+        // 解码任务启动失败（没有影子帧缓冲或内存不足）时在主循环中解码
+        if (GIF_DECODE_TASK_ENABLED && !startDecodeTask()) {
+            printInfo("initGIFPlayer", "GIF在主循环中解码");
+        }
         printInfo("initGIFPlayer", ("GIF播放器初始化成功，尺寸: " + String(gif->getCanvasWidth()) + " x " + String(gif->getCanvasHeight())).c_str());
     }
     return true;
@@ -308,57 +467,193 @@ bool GIFManager::playGIFFrame() {
         return false;
     }
     
-    // 尝试获取GIF的原始帧延迟，如果没有则使用设置的延迟或默认值
-    int frameDelay = 30; // 默认30ms（约33FPS）
-    
-    // 尝试获取GIF的原始帧延迟
-    if (gifFrameDelay > 0) {
-        frameDelay = gifFrameDelay; // 使用手动设置的延迟
-    } else {
-        // 尝试获取GIF的原始延迟（如果库支持的话）
-        // 注意：AnimatedGIF库可能没有getDelay()方法，这里先注释掉
-        // int originalDelay = gif->getDelay();
-        // if (originalDelay > 0) {
-        //     frameDelay = originalDelay;
-        // }
-        
+    // 解码任务运行时只从就绪队列取帧
+    if (decodeTask != nullptr) {
+        return presentQueuedFrame();
+    }
     
+    // 还没到下一帧的时间点
+    if ((long)(millis() - nextGifFrameTime) < 0) {
+        return true;
     }
     
-    // 检查是否到了播放下一帧的时间
-    if (millis() - lastGifFrameTime >= frameDelay) {
-        // 播放一帧
-        if (!gif->playFrame(true, NULL)) {
-            // 播放完整个GIF，重新开始
-            if (gifLoopMode) {
-                gif->close();
-                // 重新开始前不清屏，避免闪烁
-                // dma_display->fillScreen(0x0000);  // 注释掉清屏操作
-                if (!gif->open(GIF_FILE, GIFOpenFile, GIFCloseFile, GIFReadFile, GIFSeekFile, GIFDraw)) {
-                    DEBUG_PRINTLN("无法重新打开GIF文件");
-                    gifInitialized = false;
+    PROFILE_SCOPE(PROF_GIF_FRAME);
+    
+    // 时间点按帧延迟累加，不受解码耗时影响；落后时连续追帧，只有最后一帧会在本轮 present() 中显示
+    int frames = 0;
+    int cachedIndex = -1;
+    do {
+        int delayMs;
+        if (frameCacheState == FRAME_CACHE_READY) {
+            // 缓存回放追帧不需要拷贝中间的画面
+            cachedIndex = frameCacheIndex;
+            delayMs = frameDuration(frameCacheDelay[cachedIndex]);
+            frameCacheIndex = (frameCacheIndex + 1) % frameCacheCount;
+        } else {
+            // 边接收边播放：下一帧还没收完时等待，收到后立即显示
+            if (!streamFrameReady()) {
+                if (GIFStream::aborted()) {
+                    finishPlayback();
                     return false;
                 }
-                DEBUG_PRINTLN("GIF重新开始播放");
-            } else {
-                // 不循环播放，停止
-                gifInitialized = false;
+                nextGifFrameTime = millis();
+                break;
+            }
+            delayMs = decodeFrame();
+            if (delayMs < 0) {
+                finishPlayback();
                 return false;
             }
+            // 没有画出新帧（已到文件末尾）时不占用时间
+            delayMs = frameDrawn ? frameDuration(delayMs) : 0;
         }
-        lastGifFrameTime = millis();
+        nextGifFrameTime += delayMs;
+        frames++;
+    } while ((long)(millis() - nextGifFrameTime) >= 0 && frames < GIF_MAX_CATCHUP_FRAMES);
+    
+    if (cachedIndex >= 0) {
+        showFrame(frameCache[cachedIndex]);
+    }
+    
+    // 解码本身就比动画慢，追不上时从当前时间重新计时
+    if ((long)(millis() - nextGifFrameTime) >= 0) {
+        nextGifFrameTime = millis();
     }
     return true;
 }
 
+int GIFManager::decodeFrame() {
+    frameDrawn = false;
+    if (gifReachedEnd) {
+        return -1;
+    }
+    int delayMs = 0;
+    int rc = gif->playFrame(false, &delayMs);
+    streamFrameIndex++;
+    
+    if (frameDrawn && frameCacheState == FRAME_CACHE_FILLING) {
+        cacheFrame(delayMs);
+    }
+    // 解码出错（数据损坏或读取失败）：结束播放，不当作还有下一帧
+    if (rc < 0) {
+        printError("decodeFrame", ("GIF解码出错，第" + String(streamFrameIndex) + "帧").c_str());
+        return -1;
+    }
+    if (rc) {
+        return delayMs;
+    }
+    
+    // 第一遍结束，之后从缓存回放，不再重新打开和解码
+    if (frameCacheState == FRAME_CACHE_FILLING && frameCacheCount > 0) {
+        frameCacheState = FRAME_CACHE_READY;
+        frameCacheIndex = 0;
+        printInfo("decodeFrame", ("GIF帧缓存完成: " + String(frameCacheCount) + "帧, " + String(frameCacheBytes / 1024) + " KB").c_str());
+        return delayMs;
+    }
+    
+    // 播放完整个GIF，回到开头重新播放
+    if (gifLoopMode) {
+        // 保留解码器和文件句柄，只把读位置移回开头，下一帧重新读取文件头和全局调色板；
+        // 不关闭再打开文件，循环点不会因为分配File和查找路径而卡顿；重新开始前不清屏，避免闪烁
+        gif->reset();
+        streamFrameIndex = 0;
+        DEBUG_PRINTLN("GIF重新开始播放");
+        return delayMs;
+    }
+    
+    // 不循环播放：最后一帧照常显示完它的延迟，下一次调用时结束
+    gifReachedEnd = true;
+    return frameDrawn ? delayMs : -1;
+}
+
+void GIFManager::finishPlayback() {
+    stopDecodeTask();
+    gif->close();
+    gifInitialized = false;
+    freeDecodeBuffers();
+    releaseGIFSource();
+}
+
+bool GIFManager::streamFrameReady() const {
+    return !gifStreaming || GIFStream::frameReady(streamFrameIndex);
+}
+
+int GIFManager::frameDuration(int delayMs) const {
+    if (gifFrameDelay > 0) {
+        delayMs = gifFrameDelay;                // 手动设置的固定延迟优先
+    } else if (delayMs <= 0) {
+        delayMs = GIF_DEFAULT_FRAME_DELAY;      // GIF中没有写延迟
+    }
+    return (int)((long)delayMs * 100 / gifSpeedPercent);
+}
+
 void GIFManager::stopGIFPlayer() {
     if (gifInitialized) {
+        // 先等解码任务退出，之后解码器和画布只归主循环使用
+        stopDecodeTask();
         gif->close();
         gifInitialized = false;
         // 停止播放时清屏，避免显示残留
         dma_display->fillScreen(0x0000);
         DEBUG_PRINTLN("GIF播放器已停止");
     }
+    freeDecodeBuffers();
+    resetFrameCache(false);
+    releaseGIFSource();
+}
+
+void GIFManager::resetFrameCache(bool enable) {
+    for (int i = 0; i < frameCacheCount; i++) {
+        heap_caps_free(frameCache[i]);
+        frameCache[i] = nullptr;
+    }
+    frameCacheCount = 0;
+    frameCacheIndex = 0;
+    frameCacheBytes = 0;
+    
+    // 缓存的是影子帧缓冲的整屏画面，没有影子帧缓冲时只能实时解码
+    bool usable = GIF_FRAME_CACHE_ENABLED && dma_display->getShadowBuffer() != nullptr;
+    frameCacheState = (enable && usable) ? FRAME_CACHE_FILLING : FRAME_CACHE_OFF;
+}
+
+void GIFManager::cacheFrame(int delayMs) {
+    size_t frameBytes = (size_t)dma_display->width() * dma_display->height() * sizeof(uint16_t);
+    
+    uint16_t* frame = nullptr;
+    if (frameCacheCount < GIF_FRAME_CACHE_MAX_FRAMES && frameCacheBytes + frameBytes <= GIF_FRAME_CACHE_BUDGET) {
+        frame = (uint16_t*)heap_caps_malloc(frameBytes, MALLOC_CAP_SPIRAM);
+    }
+    if (frame == nullptr) {
+        printInfo("cacheFrame", ("GIF帧缓存超出预算或PSRAM不足（已缓存" + String(frameCacheCount) + "帧），改为实时解码").c_str());
+        resetFrameCache(false);
+        return;
+    }
+    
+    // 解码任务画在私有画布上，主循环解码直接画在影子帧缓冲上
+    memcpy(frame, decodeCanvas != nullptr ? decodeCanvas : dma_display->getShadowBuffer(), frameBytes);
+    frameCache[frameCacheCount] = frame;
+    frameCacheDelay[frameCacheCount] = (uint16_t)constrain(delayMs, 0, 65535);
+    frameCacheCount++;
+    frameCacheBytes += frameBytes;
+}
+
+void GIFManager::showFrame(const uint16_t* frame) {
+    // 逐行比较，只拷贝并提交有变化的行
+    const int w = dma_display->width();
+    const int h = dma_display->height();
+    uint16_t* shadow = dma_display->getShadowBuffer();
+    int firstRow = -1, lastRow = -1;
+    for (int y = 0; y < h; y++) {
+        const size_t offset = (size_t)y * w;
+        if (memcmp(shadow + offset, frame + offset, w * sizeof(uint16_t)) != 0) {
+            memcpy(shadow + offset, frame + offset, w * sizeof(uint16_t));
+            if (firstRow < 0) firstRow = y;
+            lastRow = y;
+        }
+    }
+    if (firstRow >= 0) {
+        dma_display->markShadowDirty(0, firstRow, w, lastRow - firstRow + 1);
+    }
 }
 
 void GIFManager::cleanup() {
@@ -370,6 +665,232 @@ void GIFManager::setFrameDelay(int delay) {
     printInfo("setFrameDelay", ("设置GIF帧延迟: " + String(delay) + "ms").c_str());
 }
 
+void GIFManager::setSpeed(int percent) {
+    gifSpeedPercent = constrain(percent, GIF_MIN_SPEED_PERCENT, GIF_MAX_SPEED_PERCENT);
+    printInfo("setSpeed", ("设置GIF播放速度: " + String(gifSpeedPercent) + "%").c_str());
+}
+
 void GIFManager::setLoopMode(bool loop) {
     gifLoopMode = loop;
+}
+
+void GIFManager::setScaleMode(int mode) {
+    if (mode < GIF_SCALE_CENTER || mode > GIF_SCALE_FILL) {
+        mode = GIF_SCALE_MODE;
+    }
+    scaleMode = mode;
+    printInfo("setScaleMode", ("设置GIF缩放模式: " + String(mode)).c_str());
+    
+    if (gifInitialized) {
+        // 旧画面和帧缓存都是按原来的映射画的；帧缓存要从第一帧开始，所以从头播放
+        bool restartTask = decodeTask != nullptr;
+        stopDecodeTask();
+        computeScaleMap();
+        dma_display->fillScreen(0x0000);
+        resetFrameCache(gifLoopMode && !gifStreaming);
+        gif->reset();
+        streamFrameIndex = 0;
+        nextGifFrameTime = millis();
+        if (restartTask) {
+            startDecodeTask();
+        }
+    }
+}
+
+// 整屏画面优先放在PSRAM，没有时用内部RAM
+static uint16_t* allocFrame(size_t bytes) {
+    uint16_t* frame = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (frame == nullptr) {
+        frame = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    }
+    return frame;
+}
+
+bool GIFManager::startDecodeTask() {
+    // 就绪帧要拷贝到影子帧缓冲，没有影子帧缓冲时只能直接画到DMA缓冲区；
+    // 取帧按毫秒时间点而不是帧结束，单缓冲时提交会写正在显示的画面，只在双缓冲下启用
+    if (decodeTask != nullptr || !dma_display->hasShadowBuffer() || !dma_display->getCfg().double_buff) {
+        return false;
+    }
+    
+    if (freeSlots == nullptr) {
+        freeSlots = xQueueCreate(GIF_FRAME_QUEUE_LENGTH, sizeof(uint8_t));
+        readySlots = xQueueCreate(GIF_FRAME_QUEUE_LENGTH, sizeof(uint8_t));
+        decodeTaskDone = xSemaphoreCreateBinary();
+        if (freeSlots == nullptr || readySlots == nullptr || decodeTaskDone == nullptr) {
+            printError("startDecodeTask", "无法创建帧队列");
+            return false;
+        }
+    }
+    
+    // 私有画布和各槽位都是整屏RGB565，优先放在PSRAM
+    const size_t frameBytes = (size_t)dma_display->width() * dma_display->height() * sizeof(uint16_t);
+    if (decodeCanvas == nullptr) {
+        decodeCanvas = allocFrame(frameBytes);
+    }
+    for (int i = 0; i < GIF_FRAME_QUEUE_LENGTH; i++) {
+        if (frameSlots[i] == nullptr) {
+            frameSlots[i] = allocFrame(frameBytes);
+        }
+    }
+    bool allocated = decodeCanvas != nullptr;
+    for (int i = 0; i < GIF_FRAME_QUEUE_LENGTH; i++) {
+        allocated = allocated && frameSlots[i] != nullptr;
+    }
+    if (!allocated) {
+        printError("startDecodeTask", "帧队列内存不足");
+        freeDecodeBuffers();
+        return false;
+    }
+    
+    // 画布从当前画面继续，之后的帧在此基础上叠加
+    memcpy(decodeCanvas, dma_display->getShadowBuffer(), frameBytes);
+    xQueueReset(freeSlots);
+    xQueueReset(readySlots);
+    xSemaphoreTake(decodeTaskDone, 0);
+    for (uint8_t i = 0; i < GIF_FRAME_QUEUE_LENGTH; i++) {
+        xQueueSend(freeSlots, &i, 0);
+    }
+    decodeTaskStop = false;
+    decodeTaskFinished = false;
+    
+    if (xTaskCreatePinnedToCore(decodeTaskMain, "gifDecode", GIF_DECODE_TASK_STACK, this,
+                                GIF_DECODE_TASK_PRIORITY, &decodeTask, GIF_DECODE_TASK_CORE) != pdPASS) {
+        decodeTask = nullptr;
+        printError("startDecodeTask", "无法创建解码任务");
+        freeDecodeBuffers();
+        return false;
+    }
+    printInfo("startDecodeTask", ("GIF解码任务已启动，就绪帧队列: " + String(GIF_FRAME_QUEUE_LENGTH) + "帧").c_str());
+    return true;
+}
+
+void GIFManager::stopDecodeTask() {
+    if (decodeTask == nullptr) {
+        return;
+    }
+    // 任务在两帧之间检查退出标志，等它给出信号后解码器才能交给调用方
+    decodeTaskStop = true;
+    xSemaphoreTake(decodeTaskDone, portMAX_DELAY);
+    decodeTask = nullptr;
+    DEBUG_PRINTLN("GIF解码任务已停止");
+}
+
+void GIFManager::freeDecodeBuffers() {
+    heap_caps_free(decodeCanvas);
+    decodeCanvas = nullptr;
+    for (int i = 0; i < GIF_FRAME_QUEUE_LENGTH; i++) {
+        heap_caps_free(frameSlots[i]);
+        frameSlots[i] = nullptr;
+    }
+}
+
+void GIFManager::decodeTaskMain(void* arg) {
+    static_cast<GIFManager*>(arg)->decodeLoop();
+    vTaskDelete(NULL);
+}
+
+void GIFManager::decodeLoop() {
+    while (!decodeTaskStop) {
+        // 没有空闲槽位说明已领先主循环几帧，等待主循环取走
+        uint8_t slot;
+        if (xQueueReceive(freeSlots, &slot, pdMS_TO_TICKS(20)) != pdTRUE) {
+            continue;
+        }
+        
+        int delayMs;
+        {
+            PROFILE_SCOPE(PROF_GIF_FRAME);
+            delayMs = produceFrame(frameSlots[slot]);
+        }
+        if (delayMs < 0) {
+            xQueueSend(freeSlots, &slot, 0);
+            decodeTaskFinished = true;
+            break;
+        }
+        frameSlotDelay[slot] = (uint16_t)constrain(delayMs, 0, 65535);
+        xQueueSend(readySlots, &slot, 0);
+        
+        // 解码比播放慢时也让出一个节拍，空闲任务才能喂狗
+        vTaskDelay(1);
+    }
+    xSemaphoreGive(decodeTaskDone);
+}
+
+int GIFManager::produceFrame(uint16_t* dst) {
+    const size_t frameBytes = (size_t)dma_display->width() * dma_display->height() * sizeof(uint16_t);
+    
+    if (frameCacheState == FRAME_CACHE_READY) {
+        int index = frameCacheIndex;
+        frameCacheIndex = (frameCacheIndex + 1) % frameCacheCount;
+        memcpy(dst, frameCache[index], frameBytes);
+        return frameCacheDelay[index];
+    }
+    
+    // 到文件末尾回到开头时本次不画新帧，再解码一次即是第一帧
+    for (int attempt = 0; attempt < 2 && !decodeTaskStop; attempt++) {
+        // 边接收边播放：等下一帧完整收到，播放速度不超过接收速度；接收中止时结束
+        while (!streamFrameReady()) {
+            if (decodeTaskStop || GIFStream::aborted()) {
+                return -1;
+            }
+            vTaskDelay(pdMS_TO_TICKS(GIF_STREAM_POLL_MS));
+        }
+        int delayMs = decodeFrame();
+        if (delayMs < 0) {
+            return -1;
+        }
+        if (frameDrawn) {
+            memcpy(dst, decodeCanvas, frameBytes);
+            return delayMs;
+        }
+    }
+    return -1;
+}
+
+bool GIFManager::presentQueuedFrame() {
+    // 还没到下一帧的时间点
+    if ((long)(millis() - nextGifFrameTime) < 0) {
+        return true;
+    }
+    
+    // 先读结束标志再取帧：任务标记结束前已经把所有帧放入队列
+    const bool finished = decodeTaskFinished;
+    
+    // 落后时连续取出多帧，只显示最后一帧，其余直接归还
+    int shown = -1;
+    int frames = 0;
+    uint8_t slot;
+    while (frames < GIF_MAX_CATCHUP_FRAMES && xQueueReceive(readySlots, &slot, 0) == pdTRUE) {
+        if (shown >= 0) {
+            uint8_t skipped = shown;
+            xQueueSend(freeSlots, &skipped, 0);
+        }
+        shown = slot;
+        nextGifFrameTime += frameDuration(frameSlotDelay[slot]);
+        frames++;
+        if ((long)(millis() - nextGifFrameTime) < 0) {
+            break;
+        }
+    }
+    
+    if (shown < 0) {
+        // 队列已空：不循环播放时已播放完，否则是解码暂时没跟上，下一帧到了立即显示
+        if (finished) {
+            finishPlayback();
+            return false;
+        }
+        return true;
+    }
+    
+    // 拷贝到影子帧缓冲后槽位即可复用，本轮 present() 提交，翻页在帧结束时生效
+    showFrame(frameSlots[shown]);
+    slot = shown;
+    xQueueSend(freeSlots, &slot, 0);
+    
+    // 解码本身就比动画慢，追不上时从当前时间重新计时
+    if ((long)(millis() - nextGifFrameTime) >= 0) {
+        nextGifFrameTime = millis();
+    }
+    return true;
 }
\ No newline at end of file
@@ -9,26 +9,123 @@
 
 #define FILESYSTEM LittleFS
 
+// 缩放映射表的大小（面板总尺寸）
+#define GIF_SCALE_MAX_WIDTH (PANEL_RES_X * PANEL_CHAIN)
+#define GIF_SCALE_MAX_HEIGHT PANEL_RES_Y
+
 class GIFManager {
 private:
     MatrixPanel_I2S_DMA* dma_display;
     AnimatedGIF* gif;
     File f;
-    int x_offset, y_offset;
+    int scaleMode;                      // GIF_SCALE_CENTER / GIF_SCALE_FIT / GIF_SCALE_FILL
     
     // GIF播放控制变量
     bool gifInitialized;
-    unsigned long lastGifFrameTime;
-    int gifFrameDelay;
+    unsigned long nextGifFrameTime;     // 下一帧的绝对时间点 (ms)
+    int gifFrameDelay;                  // 固定帧延迟 (ms)，0为使用GIF中每帧的延迟
+    int gifSpeedPercent;                // 播放速度百分比，100为原速
     bool gifLoopMode;
+    bool gifReachedEnd;                 // 不循环播放时已解码完最后一帧
     unsigned long start_tick;
     
+    // 内存中的GIF数据（为空时从 gifPath 读取），由GIFManager负责释放
+    uint8_t* gifMemory;
+    int32_t gifMemorySize;
+    char gifPath[GIF_PATH_SIZE];        // 文件模式播放的GIF，默认为GIF_FILE
+    
+    // 边接收边播放：gifMemory 指向BLE接收缓冲区（不归GIFManager释放），只解码已完整收到的帧
+    bool gifStreaming;
+    int streamFrameIndex;               // 下一次解码的帧序号
+    bool streamFrameReady() const;
+    
+    // 从内存或文件打开GIF
+    bool openGIF();
+    // 释放内存中的GIF数据，须在解码器关闭后调用
+    void releaseGIFSource();
+    
+    // 预解码帧缓存：第一遍边解码边保存，完整一遍后改为从缓存回放
+    enum FrameCacheState {
+        FRAME_CACHE_OFF,        // 不缓存，实时解码
+        FRAME_CACHE_FILLING,    // 第一遍播放中，逐帧保存
+        FRAME_CACHE_READY       // 已缓存完整一遍，从缓存回放
+    };
+    FrameCacheState frameCacheState;
+    uint16_t* frameCache[GIF_FRAME_CACHE_MAX_FRAMES];
+    uint16_t frameCacheDelay[GIF_FRAME_CACHE_MAX_FRAMES];
+    int frameCacheCount;
+    int frameCacheIndex;
+    size_t frameCacheBytes;
+    
+    void resetFrameCache(bool enable);
+    void cacheFrame(int delayMs);
+    // 把一帧整屏画面拷贝到影子帧缓冲，只标记有变化的行
+    void showFrame(const uint16_t* frame);
+    
+    // 解码任务：解码到私有画布，整帧拷贝到空闲槽位后放入就绪队列，主循环按时间点取出提交
+    TaskHandle_t decodeTask;
+    QueueHandle_t freeSlots;            // 空闲槽位号
+    QueueHandle_t readySlots;           // 按顺序排队的已解码槽位号
+    SemaphoreHandle_t decodeTaskDone;   // 任务退出前给出，停止时等待
+    volatile bool decodeTaskStop;       // 请求任务退出
+    volatile bool decodeTaskFinished;   // 不循环播放时解码到结尾
+    uint16_t* frameSlots[GIF_FRAME_QUEUE_LENGTH];
+    uint16_t frameSlotDelay[GIF_FRAME_QUEUE_LENGTH];    // GIF中的延迟，取出时再换算，调速立即生效
+    
+    bool startDecodeTask();
+    void stopDecodeTask();              // 等待任务退出，返回后解码器只归调用方使用
+    void freeDecodeBuffers();
+    static void decodeTaskMain(void* arg);
+    void decodeLoop();
+    // 产生下一帧到 dst（从缓存拷贝或解码），返回GIF中的延迟，结束或出错返回-1
+    int produceFrame(uint16_t* dst);
+    bool presentQueuedFrame();
+    
+    // 解码任务的私有画布，为空时 GIFDraw 直接画到显示缓冲区
+    static uint16_t* decodeCanvas;
+    
+    // 解码下一帧并处理循环，返回该帧在GIF中的延迟 (ms)，没有画出新帧时看 frameDrawn；
+    // 不循环播放且已播放完时返回-1
+    int decodeFrame();
+    // 播放完或出错后关闭解码器，保留最后一帧画面
+    void finishPlayback();
+    // GIF中的帧延迟换算为显示时长（固定延迟、默认延迟和播放速度）
+    int frameDuration(int delayMs) const;
+    
+    // GIFDraw 在本次 playFrame 中画过至少一行
+    static bool frameDrawn;
+    
+    // 调色板转换缓存：颜色顺序映射后的RGB565，以及没有影子帧缓冲时用的位平面值
+    static const uint16_t* cachedPalette;
+    static uint16_t palette565[256];
+    static uint32_t paletteBits[256];
+    static void convertPalette(const uint16_t *palette);
+    
+    // 画布到面板的映射，按缩放模式在打开GIF后计算，GIFDraw 逐行使用
+    struct ScaleMap {
+        int16_t dstX, dstY, dstW, dstH;         // 面板上的目标区域
+        int16_t srcX, srcY;                     // 目标区域左上角对应的画布坐标（只用于1:1）
+        bool identity;                          // 1:1显示，只有平移和裁剪
+        bool box;                               // 缩小时按区域取平均
+        int16_t colSrc[GIF_SCALE_MAX_WIDTH];    // 目标列取样的画布x（最近像素）
+        int16_t rowSrc[GIF_SCALE_MAX_HEIGHT];   // 目标行取样的画布y
+        int16_t colBox[GIF_SCALE_MAX_WIDTH + 1];    // 目标列覆盖的画布x区间边界（区域平均）
+        int16_t rowBox[GIF_SCALE_MAX_HEIGHT + 1];   // 目标行覆盖的画布y区间边界
+    };
+    static ScaleMap scaleMap;
+    void computeScaleMap();
+    
+    // 区域平均：当前目标行的逐列累加值，目标行变化或一帧结束时输出
+    static int16_t boxRow;
+    static uint32_t boxSum[GIF_SCALE_MAX_WIDTH][3];
+    static uint16_t boxCount[GIF_SCALE_MAX_WIDTH];
+    static void flushBoxRow();
+    
+    // 按索引整段写入，跳过透明像素（transparent 为-1时没有透明色）
+    static void drawIndexedRuns(int x, int y, const uint8_t *idx, int n, int transparent);
+    
     // 静态回调函数
     static void GIFDraw(GIFDRAW *pDraw);
-    static void* GIFOpenFile(const char *fname, int32_t *pSize);
-    static void GIFCloseFile(void *pHandle);
-    static int32_t GIFReadFile(GIFFILE *pFile, uint8_t *pBuf, int32_t iLen);
-    static int32_t GIFSeekFile(GIFFILE *pFile, int32_t iPosition);
     
     // 静态显示对象指针（用于回调函数）
     static MatrixPanel_I2S_DMA* static_dma_display;
@@ -45,8 +142,16 @@ public:
     void cleanup();
     
     // 设置函数
+    // 下一次 initGIFPlayer() 直接从这块内存解码（RAM或PSRAM），接管其所有权
+    void setGIFMemory(uint8_t* data, int32_t size);
+    // 下一次 initGIFPlayer() 从这个文件解码（动画库中的动画或临时文件）
+    void setGIFFile(const char* path);
     void setFrameDelay(int delay);
+    // 播放速度百分比（100为原速，200为两倍速）
+    void setSpeed(int percent);
     void setLoopMode(bool loop);
+    // 缩放模式（GIF_SCALE_CENTER / GIF_SCALE_FIT / GIF_SCALE_FILL），播放中设置时立即生效
+    void setScaleMode(int mode);
     
     // 状态查询
     bool isInitialized() const { return gifInitialized; }
@@ -0,0 +1,299 @@
+#include "GIFReader.h"
+#include "esp_heap_caps.h"
+
+#define FILESYSTEM LittleFS
+
+uint8_t* GIFStream::buffer = NULL;
+int32_t GIFStream::bufferSize = 0;
+int32_t GIFStream::receivedBytes = 0;
+int32_t GIFStream::scanPos = 0;
+int GIFStream::frames = 0;
+bool GIFStream::complete = false;
+bool GIFStream::open = false;
+uint8_t* GIFStream::readerBuffer = NULL;
+bool GIFStream::readerComplete = false;
+uint8_t* GIFStream::pendingFree = NULL;
+portMUX_TYPE GIFStream::mux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// 预读缓冲读取
+// ============================================================================
+
+void* GIFReader::open(const char *fname, int32_t *pSize) {
+    printInfo("GIFOpenFile", ("尝试打开GIF文件: " + String(fname)).c_str());
+
+    File file = FILESYSTEM.open(fname);
+    if (!file) {
+        printError("GIFOpenFile", ("文件打开失败: " + String(fname)).c_str());
+        return NULL;
+    }
+
+    Handle *h = new Handle();
+    h->file = file;
+    h->bufferStart = 0;
+    h->bufferLen = 0;
+    h->filePos = 0;
+    *pSize = file.size();
+
+    // 文件比缓冲区小时只分配文件大小，整个文件一次读入
+    int32_t bufferSize = min((int32_t)GIF_READ_BUFFER_SIZE, *pSize);
+    h->buffer = (uint8_t*)heap_caps_aligned_alloc(16, bufferSize, MALLOC_CAP_SPIRAM);
+    if (h->buffer == NULL) {
+        bufferSize = min((int32_t)GIF_READ_BUFFER_SIZE_INTERNAL, *pSize);
+        h->buffer = (uint8_t*)heap_caps_aligned_alloc(16, bufferSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (h->buffer == NULL) {
+        bufferSize = 0;
+        printInfo("GIFOpenFile", "无法分配预读缓冲区，直接读取文件");
+    }
+    h->bufferSize = bufferSize;
+
+    printInfo("GIFOpenFile", ("文件打开成功，大小: " + String(*pSize) + " 字节, 预读缓冲区: " + String(bufferSize) + " 字节").c_str());
+    return (void *)h;
+}
+
+void GIFReader::close(void *pHandle) {
+    Handle *h = static_cast<Handle *>(pHandle);
+    if (h != NULL) {
+        h->file.close();
+        heap_caps_free(h->buffer);
+        delete h;
+    }
+}
+
+int32_t GIFReader::readAt(Handle *h, int32_t offset, uint8_t *dst, int32_t len) {
+    if (h->filePos != offset) {
+        if (!h->file.seek(offset)) {
+            printError("GIFReadFile", ("seek失败: " + String(offset)).c_str());
+            return 0;
+        }
+        h->filePos = offset;
+    }
+    int32_t n = (int32_t)h->file.read(dst, len);
+    h->filePos += n;
+    return n;
+}
+
+int32_t GIFReader::read(GIFFILE *pFile, uint8_t *pBuf, int32_t iLen) {
+    Handle *h = static_cast<Handle *>(pFile->fHandle);
+    int32_t pos = pFile->iPos;
+
+    // 读取位置之后的字节全部可读，最后一个字节也不例外
+    if (iLen > pFile->iSize - pos)
+        iLen = pFile->iSize - pos;
+
+    int32_t done = 0;
+    while (done < iLen) {
+        int32_t available = h->bufferStart + h->bufferLen - pos;
+        if (pos >= h->bufferStart && available > 0) {
+            // 命中缓冲区
+            int32_t n = min(available, iLen - done);
+            memcpy(pBuf + done, h->buffer + (pos - h->bufferStart), n);
+            done += n;
+            pos += n;
+            continue;
+        }
+        if (iLen - done >= h->bufferSize) {
+            // 不小于缓冲区的读取直接读到目标里
+            int32_t n = readAt(h, pos, pBuf + done, iLen - done);
+            done += n;
+            pos += n;
+            break;
+        }
+        // 从对齐的位置重新预读一整块
+        int32_t start = pos - pos % GIF_READ_ALIGN;
+        if (pos - start >= h->bufferSize) {
+            start = pos;  // 缓冲区比对齐单位还小
+        }
+        h->bufferStart = start;
+        h->bufferLen = readAt(h, start, h->buffer, min(h->bufferSize, pFile->iSize - start));
+        if (h->bufferStart + h->bufferLen <= pos) {
+            break;  // 读取出错，返回已读到的部分
+        }
+    }
+
+    pFile->iPos = pos;
+    return done;
+}
+
+int32_t GIFReader::seek(GIFFILE *pFile, int32_t iPosition) {
+    // 只记录位置，真正的文件seek推迟到缓冲区未命中时
+    if (iPosition < 0) iPosition = 0;
+    if (iPosition > pFile->iSize) iPosition = pFile->iSize;
+    pFile->iPos = iPosition;
+    return pFile->iPos;
+}
+
+// ============================================================================
+// 边接收边播放
+// ============================================================================
+
+void GIFStream::begin(uint8_t *data, int32_t size) {
+    portENTER_CRITICAL(&mux);
+    buffer = data;
+    bufferSize = size;
+    receivedBytes = 0;
+    scanPos = 0;
+    frames = 0;
+    complete = false;
+    open = true;
+    portEXIT_CRITICAL(&mux);
+}
+
+int32_t GIFStream::skipSubBlocks(int32_t pos, int32_t end) {
+    while (pos < end) {
+        uint8_t len = buffer[pos];
+        pos += 1 + len;
+        if (len == 0) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+void GIFStream::scan(int32_t end) {
+    const uint8_t *p = buffer;
+    if (scanPos == 0) {
+        // 文件头 + 逻辑屏幕描述符 + 全局调色板
+        if (end < 13) {
+            return;
+        }
+        if (memcmp(p, "GIF8", 4) != 0) {
+            scanPos = -1;  // 不是GIF，不会开始边接收边播放
+            return;
+        }
+        int32_t pos = 13;
+        if (p[10] & 0x80) {
+            pos += 3 << ((p[10] & 0x07) + 1);
+        }
+        scanPos = pos;
+    }
+    
+    int found = 0;
+    while (scanPos > 0 && scanPos < end) {
+        int32_t pos = scanPos;
+        if (p[pos] == 0x21) {
+            // 扩展块：标签 + 数据子块
+            pos = skipSubBlocks(pos + 2, end);
+        } else if (p[pos] == 0x2C) {
+            // 图像：描述符 + 局部调色板 + LZW最小码长 + 数据子块
+            if (pos + 10 > end) {
+                break;
+            }
+            uint8_t packed = p[pos + 9];
+            pos += 10;
+            if (packed & 0x80) {
+                pos += 3 << ((packed & 0x07) + 1);
+            }
+            pos = skipSubBlocks(pos + 1, end);
+            if (pos > 0) {
+                found++;
+            }
+        } else {
+            // 结尾（0x3B）或无法识别的块，之后的帧等接收完成再解码
+            scanPos = -1;
+            break;
+        }
+        if (pos < 0) {
+            break;  // 这个块还没收完
+        }
+        scanPos = pos;
+    }
+    
+    if (found > 0) {
+        // 帧数在临界区内更新，另一个核心看到新帧数时缓冲区内容也已写入
+        portENTER_CRITICAL(&mux);
+        frames += found;
+        portEXIT_CRITICAL(&mux);
+    }
+}
+
+void GIFStream::update(int32_t received) {
+    if (buffer == NULL || !open) {
+        return;
+    }
+    receivedBytes = min(received, bufferSize);
+    scan(receivedBytes);
+}
+
+void GIFStream::finish() {
+    portENTER_CRITICAL(&mux);
+    if (open) {
+        complete = true;
+        if (readerBuffer == buffer) {
+            readerComplete = true;
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+int GIFStream::frameCount() {
+    portENTER_CRITICAL(&mux);
+    int n = frames;
+    portEXIT_CRITICAL(&mux);
+    return n;
+}
+
+bool GIFStream::release(uint8_t *data) {
+    bool deferred = false;
+    portENTER_CRITICAL(&mux);
+    if (data == buffer) {
+        open = false;
+        buffer = NULL;
+    }
+    if (data != NULL && data == readerBuffer) {
+        pendingFree = data;
+        deferred = true;
+    }
+    portEXIT_CRITICAL(&mux);
+    return deferred;
+}
+
+bool GIFStream::reading(const uint8_t *data) {
+    portENTER_CRITICAL(&mux);
+    bool r = data != NULL && data == readerBuffer;
+    portEXIT_CRITICAL(&mux);
+    return r;
+}
+
+bool GIFStream::attach(uint8_t **data, int32_t *size) {
+    bool ok = false;
+    portENTER_CRITICAL(&mux);
+    if (open && readerBuffer == NULL && frames > 0) {
+        readerBuffer = buffer;
+        readerComplete = complete;
+        *data = buffer;
+        *size = bufferSize;
+        ok = true;
+    }
+    portEXIT_CRITICAL(&mux);
+    return ok;
+}
+
+void GIFStream::detach() {
+    portENTER_CRITICAL(&mux);
+    uint8_t *toFree = pendingFree;
+    readerBuffer = NULL;
+    pendingFree = NULL;
+    portEXIT_CRITICAL(&mux);
+    
+    if (toFree != NULL) {
+        heap_caps_free(toFree);
+        printInfo("GIFStream", "播放器已放开，释放接收缓冲区");
+    }
+}
+
+bool GIFStream::frameReady(int index) {
+    portENTER_CRITICAL(&mux);
+    bool ready = readerBuffer != NULL && (readerComplete || (readerBuffer == buffer && index < frames));
+    portEXIT_CRITICAL(&mux);
+    return ready;
+}
+
+bool GIFStream::aborted() {
+    portENTER_CRITICAL(&mux);
+    // 已全部收到的缓冲区即使被接收端释放也能播放完，放开时才真正释放
+    bool stopped = readerBuffer == NULL || (!readerComplete && (readerBuffer != buffer || !open));
+    portEXIT_CRITICAL(&mux);
+    return stopped;
+}
@@ -0,0 +1,89 @@
+#ifndef GIF_READER_H
+#define GIF_READER_H
+
+#include "config.h"
+#include "debug.h"
+#include <AnimatedGIF.h>
+#include <LittleFS.h>
+
+// ============================================================================
+// GIF数据读取：LittleFS文件的预读缓冲读取，以及边接收边播放时的接收缓冲区
+// ============================================================================
+
+/**
+ * AnimatedGIF 文件模式的回调函数
+ * 解码器每次只读几十到几百字节，这里按 GIF_READ_BUFFER_SIZE 整块预读，
+ * 小块读取和缓冲区内的seek都不访问文件系统
+ */
+class GIFReader {
+public:
+    static void* open(const char *fname, int32_t *pSize);
+    static void close(void *pHandle);
+    static int32_t read(GIFFILE *pFile, uint8_t *pBuf, int32_t iLen);
+    static int32_t seek(GIFFILE *pFile, int32_t iPosition);
+
+private:
+    // 作为AnimatedGIF的文件句柄
+    struct Handle {
+        File file;
+        uint8_t* buffer;        // 预读缓冲区，分配失败时为空，直接读文件
+        int32_t bufferSize;
+        int32_t bufferStart;    // 缓冲区第一个字节在文件中的位置
+        int32_t bufferLen;      // 缓冲区中的有效字节数
+        int32_t filePos;        // 文件句柄当前的读位置，相同时不再seek
+    };
+
+    // 从文件的指定位置读取，返回实际读到的字节数
+    static int32_t readAt(Handle *h, int32_t offset, uint8_t *dst, int32_t len);
+};
+
+/**
+ * 边接收边播放：BLE接收端按块写入完整大小的内存缓冲区，播放器按内存模式直接解码同一块缓冲区，
+ * 每一帧完整收到后才允许解码。接收端写入、扫描帧边界；播放器接入/放开；两者之间用自旋锁保护。
+ * 缓冲区归接收端所有，播放器接入期间接收端要释放它时推迟到播放器放开后释放
+ */
+class GIFStream {
+public:
+    // 接收端：开始一次新的接收，size 为缓冲区（GIF文件）的完整大小
+    static void begin(uint8_t *data, int32_t size);
+    // 接收端：已写入缓冲区的字节数，扫描出其中完整收到的帧
+    static void update(int32_t received);
+    // 接收端：全部收到，之后所有帧都可以解码
+    static void finish();
+    // 已完整收到的帧数
+    static int frameCount();
+    /**
+     * 接收端释放或转交缓冲区前调用，之后播放器不能再接入
+     * @return 播放器还在读这块缓冲区时返回true，此时调用方不能释放，放开后在这里释放
+     */
+    static bool release(uint8_t *data);
+    // 播放器是否正在读这块缓冲区
+    static bool reading(const uint8_t *data);
+    
+    // 播放端：接入当前的接收缓冲区，没有进行中的接收时返回false
+    static bool attach(uint8_t **data, int32_t *size);
+    static void detach();
+    // 播放端：第 index 帧（从0开始）是否已完整收到
+    static bool frameReady(int index);
+    // 播放端：接收已中止，之后的帧不会再到达
+    static bool aborted();
+
+private:
+    static uint8_t *buffer;             // 当前接收的缓冲区
+    static int32_t bufferSize;
+    static int32_t receivedBytes;
+    static int32_t scanPos;             // 下一个还没扫描的块的位置，0为还没扫描文件头，-1为停止扫描
+    static int frames;
+    static bool complete;
+    static bool open;                   // 接收进行中，播放器可以接入
+    static uint8_t *readerBuffer;       // 播放器正在读的缓冲区，没有时为空
+    static bool readerComplete;         // 播放器正在读的缓冲区已全部收到
+    static uint8_t *pendingFree;        // 播放器放开后要释放的缓冲区
+    static portMUX_TYPE mux;
+
+    // 跳过从 pos 开始的数据子块，返回结束后的位置，还没收完时返回-1
+    static int32_t skipSubBlocks(int32_t pos, int32_t end);
+    static void scan(int32_t end);
+};
+
+#endif // GIF_READER_H
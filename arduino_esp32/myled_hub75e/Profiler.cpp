@@ -0,0 +1,96 @@
+#include "Profiler.h"
+#include <stdio.h>
+#include <string.h>
+
+Profiler::Histogram Profiler::histograms[PROF_PROBE_COUNT];
+uint32_t Profiler::cyclesPerUs = 240;
+portMUX_TYPE Profiler::mux = portMUX_INITIALIZER_UNLOCKED;
+
+void Profiler::begin() {
+    uint32_t mhz = getCpuFrequencyMhz();
+    cyclesPerUs = mhz ? mhz : 240;
+    reset();
+}
+
+void Profiler::record(ProfileProbe probe, uint32_t elapsedCycles) {
+    uint32_t us = elapsedCycles / cyclesPerUs;
+
+    uint8_t bucket = us < 2 ? 0 : 31 - __builtin_clz(us);
+    if (bucket >= PROFILER_BUCKETS) {
+        bucket = PROFILER_BUCKETS - 1;
+    }
+
+    portENTER_CRITICAL(&mux);
+    Histogram &h = histograms[probe];
+    h.count++;
+    h.totalUs += us;
+    if (us > h.maxUs) {
+        h.maxUs = us;
+    }
+    h.buckets[bucket]++;
+    portEXIT_CRITICAL(&mux);
+}
+
+void Profiler::snapshot(Histogram *out) {
+    portENTER_CRITICAL(&mux);
+    memcpy(out, histograms, sizeof(histograms));
+    portEXIT_CRITICAL(&mux);
+}
+
+void Profiler::reset() {
+    portENTER_CRITICAL(&mux);
+    memset(histograms, 0, sizeof(histograms));
+    portEXIT_CRITICAL(&mux);
+}
+
+uint32_t Profiler::percentile(const Histogram &h, uint8_t pct) {
+    if (h.count == 0) {
+        return 0;
+    }
+
+    // 向上取整，保证至少覆盖一个样本
+    uint32_t target = (uint32_t)(((uint64_t)h.count * pct + 99) / 100);
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < PROFILER_BUCKETS; i++) {
+        seen += h.buckets[i];
+        if (seen >= target) {
+            uint32_t upper = (i == PROFILER_BUCKETS - 1) ? h.maxUs : (2UL << i) - 1;
+            return upper < h.maxUs ? upper : h.maxUs;
+        }
+    }
+    return h.maxUs;
+}
+
+const char *Profiler::probeName(ProfileProbe probe) {
+    static const char *names[PROF_PROBE_COUNT] = {
+        "LOOP", "GIF", "SCROLL", "UTF8", "COMMIT", "FLIP", "BLE_C", "BLE_G", "BLE_B"
+    };
+    return probe < PROF_PROBE_COUNT ? names[probe] : "?";
+}
+
+size_t Profiler::format(char *buf, size_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    Histogram snap[PROF_PROBE_COUNT];
+    snapshot(snap);
+
+    size_t len = 0;
+    buf[0] = '\0';
+    for (uint8_t i = 0; i < PROF_PROBE_COUNT && len < size; i++) {
+        const Histogram &h = snap[i];
+        uint32_t avg = h.count ? (uint32_t)(h.totalUs / h.count) : 0;
+        int n = snprintf(buf + len, size - len, "%s:%lu,%lu,%lu,%lu,%lu;",
+                         probeName((ProfileProbe)i), (unsigned long)h.count, (unsigned long)avg,
+                         (unsigned long)percentile(h, 50), (unsigned long)percentile(h, 95),
+                         (unsigned long)h.maxUs);
+        if (n < 0 || (size_t)n >= size - len) {
+            // 缓冲区不够，丢弃写了一半的这一项
+            buf[len] = '\0';
+            break;
+        }
+        len += n;
+    }
+    return len;
+}
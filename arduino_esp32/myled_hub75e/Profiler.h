@@ -0,0 +1,91 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "config.h"
+#include <Arduino.h>
+
+// ============================================================================
+// 性能统计：基于CPU周期计数器的作用域计时，结果累计到固定大小的直方图，
+// 计时路径不分配内存，可在BLE回调任务与主循环中同时使用
+// ============================================================================
+
+// 统计点
+enum ProfileProbe {
+    PROF_LOOP,              // 主循环一轮
+    PROF_GIF_FRAME,         // GIF解码并绘制一帧
+    PROF_SCROLL_TEXT,       // 滚动文本重绘一次
+    PROF_PRINT_UTF8,        // printlnUTF8 文本绘制
+    PROF_COMMIT,            // 影子帧缓冲转换到DMA位平面
+    PROF_FLIP,              // 提交画面（同步改动行/翻页）
+    PROF_BLE_CONTROL,       // 控制特征值写入处理
+    PROF_BLE_GIF,           // GIF特征值写入处理
+    PROF_BLE_BRIGHTNESS,    // 亮度特征值写入处理
+    PROF_PROBE_COUNT
+};
+
+// 直方图桶数：第i桶为 [2^i, 2^(i+1)) 微秒（第0桶含0），最后一桶包含所有更长的耗时
+#define PROFILER_BUCKETS 16
+
+class Profiler {
+public:
+    struct Histogram {
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t totalUs;
+        uint32_t buckets[PROFILER_BUCKETS];
+    };
+
+    // 读取CPU主频，计时前调用一次
+    static void begin();
+
+    // 当前核的周期计数，32位回绕（240MHz下约17秒），单次计时不应超过这个长度
+    static inline uint32_t cycles() { return ESP.getCycleCount(); }
+
+    // 记录一次耗时（周期数）
+    static void record(ProfileProbe probe, uint32_t elapsedCycles);
+
+    // 复制全部直方图，不会读到写了一半的数据
+    static void snapshot(Histogram *out);
+    static void reset();
+
+    // 直方图的百分位耗时（所在桶的上界，不超过最大值），单位微秒
+    static uint32_t percentile(const Histogram &h, uint8_t pct);
+
+    static const char *probeName(ProfileProbe probe);
+
+    /**
+     * 格式化为文本，供BLE读取/通知：
+     * "名称:次数,平均,p50,p95,最大;" 依次列出所有统计点，耗时单位为微秒
+     * @return 写入的字符数（不含结尾的0）
+     */
+    static size_t format(char *buf, size_t size);
+
+private:
+    static Histogram histograms[PROF_PROBE_COUNT];
+    static uint32_t cyclesPerUs;
+    static portMUX_TYPE mux;
+};
+
+/**
+ * 作用域计时：构造时读周期计数，析构时记录到对应的直方图
+ * 开始与结束须在同一个核上（主循环任务和BLE任务都固定在各自的核上）
+ */
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileProbe probe) : probe(probe), start(Profiler::cycles()) {}
+    ~ProfileScope() { Profiler::record(probe, Profiler::cycles() - start); }
+
+private:
+    ProfileProbe probe;
+    uint32_t start;
+};
+
+#if PROFILER_ENABLED
+    #define PROFILE_CONCAT_(a, b) a##b
+    #define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+    #define PROFILE_SCOPE(probe) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(probe)
+#else
+    #define PROFILE_SCOPE(probe)
+#endif
+
+#endif // PROFILER_H
@@ -1,11 +1,12 @@
 #include "TextManager.h"
+#include "Profiler.h"
 
 TextManager::TextManager(MatrixPanel_I2S_DMA* display) 
     : dma_display(display), scrollTextTimeDelay(20), scrollXMove(-1),
       isAnimationDue(0), scrollTextXPosition(PANEL_RES_X), scrollTextYPosition(0),
       xOne(0), yOne(0), scrollTextWidth(0), scrollTextHeight(0),
       textSize(1), isTextWrap(false), isScrollText(false), scrollTextSpeed(1),
-      scrollTextNeedsRedraw(false), lastScrollXPosition(-999), lastDrawTime(0),
+      scrollTextNeedsRedraw(false), lastScrollXPosition(-999), lastBandHeight(0), lastDrawTime(0),
       isDrawing(false), scrollTextContent(nullptr),
       colorBlack(0), colorWhite(0), colorRed(0), colorGreen(0), colorBlue(0) {
     
@@ -61,7 +62,10 @@ void TextManager::displayText(char *textContent, bool isScroll) {
         dma_display->setCursor(0, 0);
         isTextWrap = true;
         dma_display->setTextWrap(true);
-        dma_display->printlnUTF8(textContent);
+        {
+            PROFILE_SCOPE(PROF_PRINT_UTF8);
+            dma_display->printlnUTF8(textContent);
+        }
         printInfo("TextManager::displayText", "静态文本已显示");
     }
 }
@@ -147,13 +151,32 @@ void TextManager::updateScrollText() {
         
         // 绘制逻辑 - 限制绘制频率，减少闪烁
         if (scrollTextNeedsRedraw && !isDrawing && (now - lastDrawTime) > 8) { // 最小8ms间隔
+            PROFILE_SCOPE(PROF_SCROLL_TEXT);
             isDrawing = true;
             
-            // 先切换缓冲区，再清屏绘制
-            dma_display->flipDMABuffer();
-            dma_display->clearScreen();
+            // 只重画文字所在的行带：文字连同背景色一起绘制，直接盖住上一步的笔画，
+            // 再清掉左右两侧露出的部分；其余行不动，不会整屏闪黑，双缓冲时也只同步这几行
+            const int16_t panelWidth = dma_display->width();
+            const int16_t bandHeight = 16 * textSize;
+            dma_display->setTextColor(colorWhite, colorBlack);
             dma_display->setCursor(scrollTextXPosition, scrollTextYPosition);
-            dma_display->printlnUTF8(scrollTextContent);
+            {
+                PROFILE_SCOPE(PROF_PRINT_UTF8);
+                dma_display->printUTF8(scrollTextContent);
+            }
+            int16_t textEnd = max((int16_t)0, dma_display->getCursorX());
+            if (scrollTextXPosition > 0) {
+                dma_display->fillRect(0, scrollTextYPosition, min((int)panelWidth, scrollTextXPosition), bandHeight, colorBlack);
+            }
+            if (textEnd < panelWidth) {
+                dma_display->fillRect(textEnd, scrollTextYPosition, panelWidth - textEnd, bandHeight, colorBlack);
+            }
+            // 字号变小时清掉上一次行带多出的部分
+            if (lastBandHeight > bandHeight) {
+                dma_display->fillRect(0, scrollTextYPosition + bandHeight, panelWidth, lastBandHeight - bandHeight, colorBlack);
+            }
+            lastBandHeight = bandHeight;
+            dma_display->setTextColor(colorWhite);
             
             scrollTextNeedsRedraw = false;
             lastDrawTime = now;
@@ -25,6 +25,7 @@ private:
     // 滚动文本优化变量
     bool scrollTextNeedsRedraw;
     int lastScrollXPosition;
+    int16_t lastBandHeight;             // 上一次重画的文字行带高度
     unsigned long lastDrawTime;
     bool isDrawing;
     
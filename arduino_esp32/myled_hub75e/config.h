@@ -82,6 +82,10 @@
 #define BLE_CHARACTERISTIC_BRIGHTNESS_UUID "beb5483e-36e1-4688-b7f5-ea07361b26a9"
 // 设备信息特征值 - 只读（固件版本、分辨率）
 #define BLE_CHARACTERISTIC_DEVICE_INFO_UUID "beb5483e-36e1-4688-b7f5-ea07361b26f1"
+// 性能统计特征值 - 只读+通知（各统计点的次数与耗时分布）
+#define BLE_CHARACTERISTIC_PROFILER_UUID "beb5483e-36e1-4688-b7f5-ea07361b26f2"
+// 动画库特征值 - 只读+通知（库中的动画ID与大小）
+#define BLE_CHARACTERISTIC_LIBRARY_UUID "beb5483e-36e1-4688-b7f5-ea07361b26f3"
 
 // BLE设备名称
 #define BLE_DEVICE_NAME "MyLED"
@@ -96,6 +100,10 @@
 #define BLE_CMD_IMAGE 'I'             // 图片显示命令
 #define BLE_CMD_CLOCK 'C'             // 时钟显示命令
 #define BLE_CMD_TIMER_GAME 'G'        // 计时游戏命令
+#define BLE_CMD_GAMMA 'M'             // 伽马曲线命令 (0=CIE1931, 1=2.2, 2=线性)
+#define BLE_CMD_LIBRARY 'L'           // 动画库命令 (LP<ID>=播放, LD<ID>=删除, LL=通知清单)
+#define BLE_CMD_GIF_SCALE 'Z'         // GIF缩放模式命令 (0=居中, 1=适应, 2=铺满)
+#define BLE_CMD_GIF_SPEED 'V'         // GIF播放速度命令 (百分比，100=原速，10~1000)
 
 // ============================================================================
 // 时区配置
@@ -116,11 +124,53 @@
 #define LED_MIN_BRIGHTNESS 10          // 最小亮度
 #define LED_MAX_BRIGHTNESS 255         // 最大亮度
 
+// 亮度渐变时长 (ms)，由DMA帧中断逐帧调整，0为立即生效
+// 拖动亮度滑块时每次写入都会重新开始渐变，亮度跟不上手，默认立即生效
+#define LED_BRIGHTNESS_FADE_MS 0
+
 // 刷新率配置
 #define LED_DEFAULT_REFRESH_RATE 80    // 默认刷新率 (Hz)
 #define LED_MIN_REFRESH_RATE 30        // 最小刷新率 (Hz)
 #define LED_MAX_REFRESH_RATE 150       // 最大刷新率 (Hz)
 
+// 伽马曲线配置（不同批次面板可在运行时通过BLE切换）
+#define LED_GAMMA_CIE1931 0            // CIE1931 亮度曲线（库默认）
+#define LED_GAMMA_22 1                 // 2.2 幂函数曲线
+#define LED_GAMMA_LINEAR 2             // 线性（不做校正）
+#define LED_DEFAULT_GAMMA LED_GAMMA_CIE1931
+
+// 双缓冲配置（DMA内存翻倍），开启后画面在主循环末尾通过 present() 统一提交，
+// 只把有改动的行同步到新的后台缓冲区；GIF解码任务的帧在单缓冲下直接写正在显示的缓冲区会撕裂，
+// 启用解码任务时一起开启
+#define LED_DOUBLE_BUFFER (GIF_DECODE_TASK_ENABLED)
+
+// 三缓冲配置（DMA内存三倍，隐含双缓冲），present() 不再等待帧结束，
+// 新画面排队后由刷新中断切换；来不及显示的旧画面直接丢弃
+#define LED_TRIPLE_BUFFER false
+
+// 每个画面至少刷新的次数（0为不限制），用于让画面以固定节奏切换
+#define LED_FRAME_PACING 0
+
+// RGB565影子帧缓冲（优先放在PSRAM），开启后所有绘制只写16位像素，
+// 在 present() 中一次性把改动区域转换到DMA位平面
+#define LED_SHADOW_BUFFER true
+
+// 各显示模式的色深（每通道位数），色深越低每帧DMA数据越少，同样刷新率下I2S时钟更低
+#define LED_COLOR_DEPTH_MONO 3         // 单色图像/涂鸦
+#define LED_COLOR_DEPTH_TEXT 5         // 文本、时钟
+#define LED_COLOR_DEPTH_GIF 8          // GIF动画
+
+// 切换显示模式时按色深重新分配DMA缓冲区，只保留用到的位平面，低色深模式下省出DMA内存。
+// 重新分配要先释放再申请，期间BLE等任务可能占走内存，连最低色深都放不下时面板会一直黑屏，
+// 所以默认关闭：切换时只重新链接DMA描述符，缓冲区按启动时的8位色深一直保留。
+// 只在开启影子帧缓冲时生效（重新分配期间不能往DMA缓冲区画，画面靠影子缓冲重新提交）
+#define LED_COLOR_DEPTH_RESIZE false
+
+// 时间抖动：GIF色深调到8位以下时，4x4有序抖动图案随刷新帧计数移动，
+// 把截掉的低位分摊到连续16帧上，消除渐变色带（需要影子帧缓冲，只在GIF模式开启）
+// 图案每变一步都要重新转换整帧，单缓冲时会有撕裂，默认关闭
+#define LED_TEMPORAL_DITHER false
+
 
 // 文本配置
 #define DEFAULT_TEXT_SIZE 1            // 默认字体大小
@@ -184,6 +234,11 @@
 #define DEBUG_BLE 1                    // 启用BLE调试
 #define DEBUG_IMAGE 1                  // 启用图像调试
 
+// 性能统计（CPU周期计数器计时，固定大小直方图，通过BLE读取）
+#define PROFILER_ENABLED 1             // 启用性能统计
+#define PROFILER_NOTIFY_INTERVAL 5000  // 连接时主动通知统计结果的间隔 (ms)，0为只在读取时返回
+#define PROFILER_TEXT_SIZE (BLE_CHUNK_SIZE + 1) // 统计结果文本缓冲区（含结尾0），不超过一次BLE传输
+
 // ============================================================================
 // 内存配置
 // ============================================================================
@@ -226,6 +281,62 @@
 #define GIF_PROGRESS_REPORT_INTERVAL     (5)            // 每5个数据块报告一次进度
 #define GIF_MEMORY_CHECK_INTERVAL        (10)           // 每10个数据块检查一次内存
 
+// GIF播放节奏：按每帧自带的延迟计时，落后时追帧
+#define GIF_DEFAULT_FRAME_DELAY          (100)          // GIF中延迟为0的帧按100ms显示（与浏览器一致）
+#define GIF_DEFAULT_SPEED_PERCENT        (100)          // 默认播放速度 100%
+#define GIF_MIN_SPEED_PERCENT            (10)           // 最慢 0.1 倍速
+#define GIF_MAX_SPEED_PERCENT            (1000)         // 最快 10 倍速
+#define GIF_MAX_CATCHUP_FRAMES           (4)            // 落后时一次最多追的帧数，超过则重新计时
+
+// 预解码帧缓存：第一遍播放时把每帧的RGB565整屏画面存入PSRAM，之后循环直接拷贝到影子帧缓冲，
+// 不再重复LZW解码；需要影子帧缓冲和PSRAM，超出预算时回退为实时解码
+#define GIF_FRAME_CACHE_ENABLED          (true)         // 启用帧缓存
+#define GIF_FRAME_CACHE_BUDGET           (1024 * 1024)  // 帧缓存内存上限1MB
+#define GIF_FRAME_CACHE_MAX_FRAMES       (64)           // 最多缓存64帧
+
+// GIF解码任务：在独立的FreeRTOS任务中解码到就绪帧队列，主循环到时间点取帧提交，
+// BLE回调或flash写入不会拖慢动画；需要影子帧缓冲和双缓冲，没有时在主循环中直接解码
+#define GIF_DECODE_TASK_ENABLED          (true)         // 启用解码任务
+#define GIF_DECODE_TASK_CORE             (0)            // 固定的核（主循环在核1）
+#define GIF_DECODE_TASK_PRIORITY         (1)            // 优先级（低于BLE协议栈）
+#define GIF_DECODE_TASK_STACK            (8192)         // 任务栈大小
+#define GIF_FRAME_QUEUE_LENGTH           (3)            // 就绪帧队列长度（整屏RGB565，优先PSRAM）
+
+// GIF文件读取：按大块预读到缓冲区（优先PSRAM），解码器的小块读取直接从缓冲区返回
+#define GIF_READ_BUFFER_SIZE             (32 * 1024)    // PSRAM中的预读缓冲区
+#define GIF_READ_BUFFER_SIZE_INTERNAL    (4 * 1024)     // 没有PSRAM时在内部RAM中的预读缓冲区
+#define GIF_READ_ALIGN                   (512)          // 预读起点按此对齐（与LittleFS块读取对齐）
+
+// GIF缩放：画布与面板尺寸不同时的显示方式，映射不到面板像素的行和列不绘制
+//   GIF_SCALE_CENTER - 原尺寸居中，超出面板的部分裁掉
+//   GIF_SCALE_FIT    - 比面板大时等比缩小到完整显示在面板内，不放大，空白处保持黑色
+//   GIF_SCALE_FILL   - 等比缩放到铺满面板，居中裁掉多余部分
+#define GIF_SCALE_CENTER 0
+#define GIF_SCALE_FIT    1
+#define GIF_SCALE_FILL   2
+#define GIF_SCALE_MODE                   GIF_SCALE_FIT
+#define GIF_SCALE_BOX_FILTER             (false)        // 缩小时按区域取平均色（更平滑），否则取最近的像素
+
+// GIF动画库：上传完成的GIF按内容哈希保存在LittleFS上，之后用8位十六进制ID直接切换播放，
+// 不再重新上传；总大小超出预算时淘汰最久没有播放的动画
+#define GIF_LIBRARY_ENABLED              (true)         // 启用动画库
+#define GIF_LIBRARY_DIR                  "/lib"         // 动画库目录
+#define GIF_LIBRARY_MANIFEST             "/lib/manifest.txt"    // 清单（ID、大小、最近播放顺序）
+#define GIF_LIBRARY_BUDGET               (1024 * 1024)  // 动画库占用flash上限1MB
+#define GIF_LIBRARY_MAX_ENTRIES          (24)           // 最多保存24个动画（清单不超过一次BLE传输）
+#define GIF_LIBRARY_FS_RESERVE           (64 * 1024)    // 写入时文件系统至少保留的空间（临时文件、清单）
+#define GIF_LIBRARY_TEXT_SIZE            (BLE_CHUNK_SIZE + 1) // 清单文本缓冲区（含结尾0）
+// 上传完成的GIF由后台任务写入动画库（最多几百KB），主循环照常刷新时钟、滚动文本和正在播放的动画
+#define GIF_STORE_TASK_CORE              (0)            // 固定的核（主循环在核1）
+#define GIF_STORE_TASK_PRIORITY          (0)            // 空闲优先级，解码任务和BLE协议栈空闲时才写flash
+#define GIF_STORE_TASK_STACK             (6144)         // 任务栈大小
+
+// 边接收边播放：内存模式接收时第一帧完整收到就开始播放，之后每帧完整收到才解码，
+// 播放速度不超过接收速度；接收完成后播放器接着循环播放，不重新打开（不清屏、不从头开始）
+#define GIF_STREAM_ENABLED               (true)         // 启用边接收边播放
+#define GIF_STREAM_PATH                  "<stream>"     // 选中接收缓冲区播放时使用的路径（不是真实文件）
+#define GIF_STREAM_POLL_MS               (10)           // 解码任务等待下一帧到达的间隔
+
 // 调试配置
 #define GIF_DEBUG_MEMORY_CHECKS          (true)         // 启用内存检查调试
 #define GIF_DEBUG_PROGRESS_REPORTS       (true)         // 启用进度报告调试
@@ -266,4 +377,6 @@ enum ReceiveState {
 // 播放SD卡上的所有GIF文件
 #define GIF_DIR "/gifs"  
 #define GIF_FILE "/temp.gif"  
+#define GIF_STORE_FILE "/store.gif"   // 上传完成、等待主循环保存到动画库的文件（文件模式）
+#define GIF_PATH_SIZE 32              // GIF文件路径缓冲区大小
 #endif // CONFIG_H 
\ No newline at end of file
@@ -24,6 +24,9 @@
 #include <driver/periph_ctrl.h>
 #include <soc/gpio_sig_map.h>
 
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
 // For I2S state management.
 static i2s_parallel_state_t *i2s_state  = NULL;
 
@@ -37,13 +40,50 @@ static i2s_dev_t* I2S[I2S_NUM_MAX] = {&I2S0};
 #endif
 
 callback shiftCompleteCallback;
+
+// Vsync - given by the ISR every time the whole DMA chain (one full frame) has been shifted out
+static SemaphoreHandle_t vsyncSemaphore = NULL;
+static volatile uint32_t frameCount     = 0;
+
+// The EOF interrupt is only switched on while somebody needs it: a task blocked in
+// i2s_parallel_wait_for_frame() or a shift complete callback. Otherwise the DMA runs without interrupts.
+static bool         eofIntAllocated = false;
+static int          vsyncWaiters    = 0;
+static portMUX_TYPE eofMux          = portMUX_INITIALIZER_UNLOCKED;
+
+// Call with eofMux held
+static void update_eof_int() {
+    if (!eofIntAllocated) {
+      return;
+    }
+
+    i2s_dev_t* dev = I2S[ESP32_I2S_DEVICE];
+    const bool needed = (vsyncWaiters > 0) || (shiftCompleteCallback != NULL);
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+    if (needed && !dev->int_ena.tx_done) {
+        SET_PERI_REG_BITS(I2S_INT_CLR_REG(ESP32_I2S_DEVICE), I2S_TX_DONE_INT_CLR_V, 1, I2S_TX_DONE_INT_CLR_S); // don't fire for an old EOF
+    }
+    dev->int_ena.tx_done = needed;
+#else
+    if (needed && !dev->int_ena.out_eof) {
+        SET_PERI_REG_BITS(I2S_INT_CLR_REG(ESP32_I2S_DEVICE), I2S_OUT_EOF_INT_CLR_V, 1, I2S_OUT_EOF_INT_CLR_S); // don't fire for an old EOF
+    }
+    dev->int_ena.out_eof = needed;
+#endif
+}
+
 void setShiftCompleteCallback(callback f) {
+    portENTER_CRITICAL(&eofMux);
     shiftCompleteCallback = f;
+    update_eof_int();
+    portEXIT_CRITICAL(&eofMux);
 }
 
 volatile int  previousBufferOutputLoopCount = 0;
 volatile bool previousBufferFree      = true;
 
+
 static void IRAM_ATTR irq_hndlr(void* arg) { // if we use I2S1 (default)
 
 //i2s_port_t port = *((i2s_port_t*) arg);
@@ -57,12 +97,17 @@ static void IRAM_ATTR irq_hndlr(void* arg) { // if we use I2S1 (default)
 #endif
 
 	previousBufferFree 		= true;
+	++frameCount;
 
-/*	
-    if(shiftCompleteCallback) { // we've defined a callback function ?
+    if(shiftCompleteCallback) { // we've defined a callback function ? runs in ISR context, keep it short and in IRAM
         shiftCompleteCallback();
- }
-*/
+    }
+
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    xSemaphoreGiveFromISR(vsyncSemaphore, &higherPriorityTaskWoken);
+    if (higherPriorityTaskWoken) {
+        portYIELD_FROM_ISR();
+    }
         
 } // end irq_hndlr
 
@@ -407,6 +452,13 @@ esp_err_t i2s_parallel_driver_install(i2s_port_t port, i2s_parallel_config_t* co
   // We using the double buffering switch logic?
   if (conf->int_ena_out_eof)
   {
+      if (vsyncSemaphore == NULL) {
+          vsyncSemaphore = xSemaphoreCreateBinary();
+          if (vsyncSemaphore == NULL) {
+              return ESP_ERR_NO_MEM;
+          }
+      }
+
       // Get ISR setup 
       esp_err_t err =  esp_intr_alloc(irq_source, 
                                      (int)(ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL1),
@@ -421,12 +473,11 @@ esp_err_t i2s_parallel_driver_install(i2s_port_t port, i2s_parallel_config_t* co
       // Setup interrupt handler which is focussed only on the (page 322 of Tech. Ref. Manual)
       // "I2S_OUT_EOF_INT: Triggered when rxlink has finished sending a packet"
       // ... whatever the hell that is supposed to mean... One massive linked list? So all pixels in the chain?
-#ifdef CONFIG_IDF_TARGET_ESP32S3
-      // ESP32-S3 uses different interrupt enable register
-      dev->int_ena.tx_done = 1;
-#else
-      dev->int_ena.out_eof = 1;
-#endif
+      // Not enabled here: update_eof_int() switches it on for waiters and the shift complete callback
+      portENTER_CRITICAL(&eofMux);
+      eofIntAllocated = true;
+      update_eof_int();
+      portEXIT_CRITICAL(&eofMux);
   }
    
   return ESP_OK;
@@ -483,6 +534,40 @@ esp_err_t i2s_parallel_driver_install(i2s_port_t port, i2s_parallel_config_t* co
 
   return ESP_OK;
 }
+// Change the output clock of a running bus - same divider calculation as in i2s_parallel_driver_install()
+esp_err_t i2s_parallel_set_clock(i2s_port_t port, int sample_rate, i2s_parallel_cfg_bits_t sample_width) {
+  if(port < I2S_NUM_0 || port >= I2S_NUM_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if(sample_rate > I2S_PARALLEL_CLOCK_HZ || sample_rate < 1) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  uint32_t clk_div_main = I2S_PARALLEL_CLOCK_HZ / sample_rate / i2s_parallel_get_memory_width(port, sample_width);
+  if(clk_div_main < 2 || clk_div_main > 0xFF) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+  // Clock setup is skipped for ESP32-S3 in i2s_parallel_driver_install() as well
+  return ESP_ERR_NOT_SUPPORTED;
+#else
+  I2S[port]->clkm_conf.clkm_div_num = clk_div_main;
+  return ESP_OK;
+#endif
+}
+
+// Swap in re-linked descriptor chains, i.e. when the number of descriptors per frame has changed
+void i2s_parallel_set_dma_chains(lldesc_t *lldesc_a, int desccount_a, lldesc_t *lldesc_b, int desccount_b) {
+  if (i2s_state == NULL) {
+    return;
+  }
+
+  i2s_state->dmadesc_a   = lldesc_a;
+  i2s_state->desccount_a = desccount_a;
+  i2s_state->dmadesc_b   = lldesc_b;
+  i2s_state->desccount_b = desccount_b;
+}
+
 /*
 i2s_dev_t* i2s_parallel_get_dev(i2s_port_t port) {
   if(port < I2S_NUM_0 || port >= I2S_NUM_MAX) {
@@ -531,3 +616,41 @@ void i2s_parallel_set_previous_buffer_not_free() {
     previousBufferFree = false;
 	previousBufferOutputLoopCount = 0;
 }
+
+// Block the calling task until the DMA chain has been shifted out once more, i.e. the start of the next frame.
+// A vsync given before the call doesn't count, it is skipped without waiting for another frame.
+// Only one task should wait at a time.
+bool i2s_parallel_wait_for_frame(TickType_t ticks_to_wait) {
+    if (vsyncSemaphore == NULL) {
+      return false; // EOF interrupt not set up
+    }
+
+    portENTER_CRITICAL(&eofMux);
+    ++vsyncWaiters;
+    update_eof_int();
+    const uint32_t startFrame = frameCount;
+    portEXIT_CRITICAL(&eofMux);
+
+    TimeOut_t timeout;
+    vTaskSetTimeOutState(&timeout);
+
+    bool vsync = false;
+    do {
+      if (xSemaphoreTake(vsyncSemaphore, ticks_to_wait) != pdTRUE) {
+        break;
+      }
+      vsync = (frameCount != startFrame);   // false: a stale give, the frame we wait for is still running
+    } while (!vsync && xTaskCheckForTimeOut(&timeout, &ticks_to_wait) == pdFALSE);
+
+    portENTER_CRITICAL(&eofMux);
+    --vsyncWaiters;
+    update_eof_int();
+    portEXIT_CRITICAL(&eofMux);
+
+    return vsync;
+}
+
+// Only counts while the EOF interrupt is on, see update_eof_int()
+uint32_t i2s_parallel_get_frame_count() {
+    return frameCount;
+}
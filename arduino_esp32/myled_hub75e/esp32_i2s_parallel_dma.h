@@ -45,7 +45,7 @@ typedef struct {
     int desccount_b;      // only used with double buffering
     lldesc_t * lldesc_b;  // only used with double buffering
     bool clkphase;        // Clock signal phase
-    bool int_ena_out_eof; // Do we raise an interrupt every time the DMA output loops? Don't do this unless we're doing double buffering!
+    bool int_ena_out_eof; // Do we raise an interrupt every time the DMA output loops? Needed for buffer flipping and vsync waits/frame counting
 } i2s_parallel_config_t;
 
 static inline int i2s_parallel_get_memory_width(i2s_port_t port, i2s_parallel_cfg_bits_t width) {
@@ -79,6 +79,7 @@ void link_dma_desc(volatile lldesc_t *dmadesc, volatile lldesc_t *prevdmadesc, v
 esp_err_t   i2s_parallel_driver_install(i2s_port_t port, i2s_parallel_config_t* conf);
 esp_err_t   i2s_parallel_send_dma(i2s_port_t port, lldesc_t* dma_descriptor);
 esp_err_t   i2s_parallel_stop_dma(i2s_port_t port);
+esp_err_t   i2s_parallel_set_clock(i2s_port_t port, int sample_rate, i2s_parallel_cfg_bits_t sample_width);
 //i2s_dev_t*    i2s_parallel_get_dev(i2s_port_t port);
 
 // For frame buffer flipping / double buffering
@@ -89,10 +90,17 @@ typedef struct {
 } i2s_parallel_state_t;
 
 void i2s_parallel_flip_to_buffer(i2s_port_t port, int bufid);
+void i2s_parallel_set_dma_chains(lldesc_t *lldesc_a, int desccount_a, lldesc_t *lldesc_b, int desccount_b);
 bool i2s_parallel_is_previous_buffer_free();
 void i2s_parallel_set_previous_buffer_not_free();
 
-// Callback function for when whole length of DMA chain has been sent out.
+// Vsync: block until the next full frame has been sent out (false on timeout or without EOF interrupt)
+bool     i2s_parallel_wait_for_frame(TickType_t ticks_to_wait);
+// Number of full frames sent out while the EOF interrupt was on (a vsync waiter or the shift complete callback)
+uint32_t i2s_parallel_get_frame_count();
+
+// Callback function for when whole length of DMA chain has been sent out. Called from the ISR.
+// The EOF interrupt stays on while a callback is set, pass NULL to turn it off again.
 typedef void (*callback)(void);
 void setShiftCompleteCallback(callback f);
 
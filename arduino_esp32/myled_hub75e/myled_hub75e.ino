@@ -2,9 +2,11 @@
 #include "debug.h"
 #include "BLEHandler.h"
 #include "GIFManager.h"
+#include "GIFLibrary.h"
 #include "TextManager.h"
 #include "DisplayManager.h"
 #include "ClockManager.h"
+#include "Profiler.h"
 #include "esp_task_wdt.h"
 
 // library includes
@@ -33,6 +35,14 @@ AnimatedGIF gif;
 
 // 全局状态变量
 bool isScrollText = false;
+
+// 请求切换显示模式（色深），供BLE处理模块调用，在loop()的 present() 中执行
+void requestDisplayMode(DisplayManager::DisplayMode mode) {
+  if (displayManager != nullptr) {
+    displayManager->requestDisplayMode(mode);
+  }
+}
+
 // 初始化蓝牙
 void initBLE() {
   printInfo("initBLE", "开始初始化BLE");
@@ -43,13 +53,16 @@ void initBLE() {
     &gif,                          // GIF解码器
     [](int size) { textManager->setTextSize(size); },           // 设置文本大小函数
     [](int speed) { textManager->setTextScrollSpeed(speed); },  // 设置滚动速度函数
-    [](char* text, bool scroll) { textManager->displayText(text, scroll); }, // 显示文本函数
+    [](char* text, bool scroll) { requestDisplayMode(DisplayManager::MODE_TEXT); textManager->displayText(text, scroll); }, // 显示文本函数
     []() { textManager->freeScrollText(); },                    // 释放滚动文本函数
     []() { displayManager->clear(); },                          // 清屏函数
     [](int brightness) { displayManager->setLedBrightness(brightness); }, // 设置亮度函数
     [](int rate) { displayManager->setRefreshRate(rate); },     // 设置刷新频率函数
     [](bool enable) { 
       isClockMode = enable; 
+      if (enable) {
+        requestDisplayMode(DisplayManager::MODE_TEXT);
+      }
       if (clockManager) {
         clockManager->setClockMode(enable);
       }
@@ -78,6 +91,7 @@ void setup() {
     return;
   }
   printInfo("setup", "系统启动");
+  Profiler::begin();
   
   // PSRAM检测和调试信息
   if (isPSRAMAvailable()) {
@@ -95,6 +109,9 @@ void setup() {
   // 启动时清理GIF相关残留文件和内存
   GIFCharacteristicCallbacks::cleanupOnStartup();
   
+  // 加载动画库清单，之前上传过的GIF可以直接切换播放
+  GIFLibrary::begin();
+  
   // 配置看门狗，延长超时时间
   esp_task_wdt_init(10, true); // 10秒超时
   esp_task_wdt_add(NULL);
@@ -117,10 +134,13 @@ void setup() {
   printInfo("setup", ("BLE初始化后内存状态: 可用 " + String(ESP.getFreeHeap()) + " 字节").c_str());
   
   
+  displayManager->setDisplayMode(DisplayManager::MODE_TEXT);
   textManager->displayText((char*)LED_DEFAULT_TEXT, false);
 }
 
 void loop() {
+  PROFILE_SCOPE(PROF_LOOP);
+
   // 喂狗，防止看门狗复位
   yield();
   esp_task_wdt_reset();
@@ -154,12 +174,45 @@ void loop() {
     textManager->updateScrollText();
   }
 
+  // BLE设置的GIF缩放模式，播放中立即按新映射从头播放，否则下次打开时生效
+  int gifScaleMode;
+  if (ControlCharacteristicCallbacks::takeGIFScaleMode(&gifScaleMode)) {
+    gifManager->setScaleMode(gifScaleMode);
+  }
+  // 播放速度从下一帧的延迟开始生效
+  int gifSpeed;
+  if (ControlCharacteristicCallbacks::takeGIFSpeed(&gifSpeed)) {
+    gifManager->setSpeed(gifSpeed);
+  }
+
   // 处理GIF显示
   if (isShowGIF && !isClockMode) {
-    // 初始化GIF播放器（如果需要）
-    if (!gifManager->isInitialized()) {
-      // 在开始播放GIF前先清屏，确保没有残留内容
+    // 上传完成的GIF由后台任务保存到动画库并选中，写flash不占用BLE回调和主循环；
+    // BLE先记下要保存的GIF再设置显示标志，看到显示标志时这里一定能取到
+    bool storing = GIFCharacteristicCallbacks::storeUploadedGIF();
+
+    // 选中了新的GIF（刚上传的或动画库中的）：停止当前播放，下面从新文件重新初始化
+    char gifPath[GIF_PATH_SIZE];
+    if (GIFLibrary::takeSelection(gifPath, sizeof(gifPath))) {
+      if (gifManager->isInitialized()) {
+        gifManager->stopGIFPlayer();
+      }
+      gifManager->setGIFFile(gifPath);
+    }
+    
+    // 初始化GIF播放器（如果需要）；刚上传的GIF还在保存时等保存任务选中后再打开
+    if (!gifManager->isInitialized() && !storing) {
+      // 在开始播放GIF前切换到全色深并清屏，确保没有残留内容
+      displayManager->setDisplayMode(DisplayManager::MODE_GIF);
       displayManager->clear();
+      // BLE回调只清除滚动标志，滚动文本在这里释放，不会和 updateScrollText() 同时进行
+      textManager->freeScrollText();
+      // 内存模式接收的GIF直接从缓冲区解码，缓冲区交由GIFManager释放；文件模式读取选中的文件
+      int32_t gifSize = 0;
+      uint8_t* gifData = GIFCharacteristicCallbacks::takeGIFBuffer(&gifSize);
+      if (gifData != nullptr) {
+        gifManager->setGIFMemory(gifData, gifSize);
+      }
       if (!gifManager->initGIFPlayer()) {
         // 初始化失败，停止GIF显示并清理资源
         isShowGIF = false;
@@ -170,8 +223,8 @@ void loop() {
       }
     }
     
-    // 播放GIF帧
-    if (!gifManager->playGIFFrame()) {
+    // 播放GIF帧（解码任务运行时这里只取出到时间点的就绪帧）；边接收边播放的动画在保存期间照常播放
+    if (gifManager->isInitialized() && !gifManager->playGIFFrame()) {
       // 播放失败，停止GIF显示并清理资源
       isShowGIF = false;
       gifManager->stopGIFPlayer();
@@ -180,7 +233,7 @@ void loop() {
       GIFCharacteristicCallbacks::cleanupAfterDisplay();
     }
   } else {
-    // 如果不需要显示GIF，停止播放器
+    // 如果不需要显示GIF，停止播放器（等待解码任务退出后才返回）
     if (gifManager->isInitialized()) {
       gifManager->stopGIFPlayer();
     }
@@ -190,6 +243,18 @@ void loop() {
   if (bleHandler) {
     bleHandler->updateTimerGameDisplay();
   }
+
+  // 定时通知性能统计
+  #if PROFILER_ENABLED
+  static unsigned long lastProfilerNotify = 0;
+  if (PROFILER_NOTIFY_INTERVAL > 0 && bleHandler && millis() - lastProfilerNotify > PROFILER_NOTIFY_INTERVAL) {
+    lastProfilerNotify = millis();
+    bleHandler->sendProfilerStats();
+  }
+  #endif
+
+  // 提交本轮绘制内容（双缓冲时只同步有改动的行）
+  displayManager->present();
   
 }  // end loop
 